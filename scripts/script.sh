@@ -117,7 +117,7 @@ set logging on gdb_output.log
 set logging overwrite on
 break main
 break X::X::initialize
-break X::EventHandler::processNextEvent
+break X::EventHandler::processPendingEvents
 break X::Launcher::createWindow
 break X::Launcher::show
 break Logger::init
@@ -0,0 +1,339 @@
+#include "../x/ipc/ipc_protocol.h"
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * doowmc: command line client for the doowm control socket
+ *
+ *     doowmc focus left|right|up|down|<window>
+ *     doowmc workspace <n>
+ *     doowmc move <n>
+ *     doowmc spawn <command...>
+ *     doowmc query focused|clients|workspaces|monitors
+ *     doowmc subscribe focus,title,workspace,monitor,layout
+ *     doowmc bench [count] [depth]
+ *
+ * Several commands separated by ';' are sent in one write and run by the
+ * window manager in the same pass. Workspaces count from 1.
+ *
+ * subscribe prints one "<class> <text>" line per event until the window
+ * manager exits. Put queries before it to get the state the events
+ * update, e.g. "doowmc query workspaces ; subscribe workspace".
+ */
+
+namespace {
+
+using namespace X;
+
+struct Request {
+    Ipc::Op op;
+    std::string payload;
+};
+
+const char* eventNames[] = { "focus", "title", "workspace", "monitor", "layout" };
+static_assert(sizeof(eventNames) / sizeof(eventNames[0]) == static_cast<size_t>(Ipc::Event::Count));
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: doowmc <command> [; <command>...]\n"
+                 "  focus left|right|up|down|<window>\n"
+                 "  workspace <n>\n"
+                 "  move <n>\n"
+                 "  spawn <command...>\n"
+                 "  query focused|clients|workspaces|monitors\n"
+                 "  subscribe focus,title,workspace,monitor,layout\n"
+                 "  bench [count] [depth]\n");
+}
+
+int connectSocket() {
+    std::string path = Ipc::socketPath();
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::fprintf(stderr, "doowmc: socket path too long: %s\n", path.c_str());
+        return -1;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        std::fprintf(stderr, "doowmc: cannot connect to %s: %s\n", path.c_str(), std::strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+bool writeAll(int fd, std::string_view data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t sent = send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        written += static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+/**
+ * Print an event frame as "<class> <text>".
+ */
+void printEvent(std::string_view payload) {
+    if (payload.empty() || static_cast<uint8_t>(payload[0]) >= static_cast<uint8_t>(Ipc::Event::Count)) {
+        return;
+    }
+    std::printf("%s %.*s\n", eventNames[static_cast<uint8_t>(payload[0])],
+                static_cast<int>(payload.size() - 1), payload.data() + 1);
+    std::fflush(stdout);
+}
+
+/**
+ * Read replies until count of them arrived; each is passed to onReply.
+ * Events pushed in between go to printEvent; with count 0 they are read
+ * until the connection ends.
+ */
+template <typename Callback>
+bool readReplies(int fd, size_t count, std::string& buffer, Callback onReply) {
+    bool forever = count == 0;
+    size_t offset = 0;
+    char chunk[64 * 1024];
+    while (count > 0 || forever) {
+        uint8_t code;
+        std::string_view payload;
+        int result = Ipc::nextFrame(buffer, offset, code, payload, Ipc::kMaxReply);
+        if (result < 0) {
+            return false;
+        }
+        if (result > 0) {
+            if (static_cast<Ipc::Status>(code) == Ipc::Status::Event) {
+                printEvent(payload);
+            } else if (count > 0) {
+                onReply(static_cast<Ipc::Status>(code), payload);
+                count--;
+            }
+            continue;
+        }
+        buffer.erase(0, offset);
+        offset = 0;
+        ssize_t got = read(fd, chunk, sizeof(chunk));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return forever && got == 0;
+        }
+        buffer.append(chunk, static_cast<size_t>(got));
+    }
+    buffer.erase(0, offset);
+    return true;
+}
+
+bool parseIndex(const std::string& text, uint32_t& index) {
+    char* end = nullptr;
+    unsigned long value = std::strtoul(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || value == 0) {
+        return false;
+    }
+    index = static_cast<uint32_t>(value - 1);
+    return true;
+}
+
+bool parseRequest(const std::vector<std::string>& words, Request& request) {
+    const std::string& verb = words[0];
+    if (verb == "focus" && words.size() == 2) {
+        static const char* directions[] = { "left", "right", "up", "down" };
+        for (uint8_t i = 0; i < 4; i++) {
+            if (words[1] == directions[i]) {
+                request = { Ipc::Op::FocusDirection, std::string(1, static_cast<char>(i)) };
+                return true;
+            }
+        }
+        char* end = nullptr;
+        unsigned long window = std::strtoul(words[1].c_str(), &end, 0);
+        if (*end != '\0' || window == 0) {
+            return false;
+        }
+        request = { Ipc::Op::FocusWindow, Ipc::encodeU32(static_cast<uint32_t>(window)) };
+        return true;
+    }
+    if ((verb == "workspace" || verb == "move") && words.size() == 2) {
+        uint32_t index;
+        if (!parseIndex(words[1], index)) {
+            return false;
+        }
+        request = { verb == "workspace" ? Ipc::Op::Workspace : Ipc::Op::MoveToWorkspace,
+                    Ipc::encodeU32(index) };
+        return true;
+    }
+    if (verb == "spawn" && words.size() >= 2) {
+        std::string command;
+        for (size_t i = 1; i < words.size(); i++) {
+            command += (i > 1 ? " " : "") + words[i];
+        }
+        request = { Ipc::Op::Spawn, command };
+        return true;
+    }
+    if (verb == "query" && words.size() == 2) {
+        static const char* queries[] = { "focused", "clients", "workspaces", "monitors" };
+        for (uint8_t i = 0; i < 4; i++) {
+            if (words[1] == queries[i]) {
+                request = { Ipc::Op::Query, std::string(1, static_cast<char>(i)) };
+                return true;
+            }
+        }
+    }
+    if (verb == "subscribe" && words.size() == 2) {
+        uint8_t mask = 0;
+        size_t start = 0;
+        while (start <= words[1].size()) {
+            size_t end = std::min(words[1].find(',', start), words[1].size());
+            std::string name = words[1].substr(start, end - start);
+            bool known = false;
+            for (uint8_t i = 0; i < static_cast<uint8_t>(Ipc::Event::Count); i++) {
+                if (name == eventNames[i]) {
+                    mask |= Ipc::eventBit(static_cast<Ipc::Event>(i));
+                    known = true;
+                }
+            }
+            if (!known) {
+                return false;
+            }
+            start = end + 1;
+        }
+        request = { Ipc::Op::Subscribe, std::string(1, static_cast<char>(mask)) };
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Keep depth cheap queries in flight and report the throughput.
+ */
+int bench(int fd, size_t count, size_t depth) {
+    std::string batch;
+    for (size_t i = 0; i < depth; i++) {
+        Ipc::appendFrame(batch, static_cast<uint8_t>(Ipc::Op::Query),
+                         std::string(1, static_cast<char>(Ipc::Query::Focused)));
+    }
+
+    std::string buffer;
+    size_t done = 0;
+    size_t errors = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (done < count) {
+        size_t n = std::min(depth, count - done);
+        std::string_view frames(batch.data(), n * (Ipc::kHeaderSize + 1));
+        if (!writeAll(fd, frames) ||
+            !readReplies(fd, n, buffer, [&](Ipc::Status status, std::string_view) {
+                errors += status != Ipc::Status::Ok;
+            })) {
+            std::fprintf(stderr, "doowmc: connection lost after %zu requests\n", done);
+            return 1;
+        }
+        done += n;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%zu requests, %zu in flight: %.3fs, %.0f requests/s, %.1fus per batch\n",
+                done, depth, seconds, done / seconds, seconds * 1e6 * depth / done);
+    return errors ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+
+    if (std::string(argv[1]) == "bench") {
+        size_t count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100000;
+        size_t depth = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 64;
+        if (!count || !depth) {
+            usage();
+            return 2;
+        }
+        int fd = connectSocket();
+        if (fd < 0) {
+            return 1;
+        }
+        int result = bench(fd, count, depth);
+        close(fd);
+        return result;
+    }
+
+    // Commands separated by ';' go out in one write
+    std::vector<Request> requests;
+    std::vector<std::string> words;
+    for (int i = 1; i <= argc; i++) {
+        if (i < argc && std::string(argv[i]) != ";") {
+            words.push_back(argv[i]);
+            continue;
+        }
+        if (words.empty()) {
+            continue;
+        }
+        Request request;
+        if (!parseRequest(words, request)) {
+            usage();
+            return 2;
+        }
+        requests.push_back(request);
+        words.clear();
+    }
+    bool subscribing = false;
+    for (const Request& request : requests) {
+        subscribing = subscribing || request.op == Ipc::Op::Subscribe;
+    }
+
+    int fd = connectSocket();
+    if (fd < 0) {
+        return 1;
+    }
+    std::string out;
+    for (const Request& request : requests) {
+        Ipc::appendFrame(out, static_cast<uint8_t>(request.op), request.payload);
+    }
+
+    int result = 0;
+    std::string buffer;
+    bool ok = writeAll(fd, out) &&
+              readReplies(fd, requests.size(), buffer, [&](Ipc::Status status, std::string_view payload) {
+                  if (status != Ipc::Status::Ok) {
+                      std::fprintf(stderr, "doowmc: %.*s\n", static_cast<int>(payload.size()),
+                                   payload.data());
+                      result = 1;
+                  } else if (!payload.empty()) {
+                      std::fwrite(payload.data(), 1, payload.size(), stdout);
+                      if (payload.back() != '\n') {
+                          std::fputc('\n', stdout);
+                      }
+                  }
+              });
+    if (ok && subscribing) {
+        std::fflush(stdout);
+        ok = readReplies(fd, 0, buffer, [](Ipc::Status, std::string_view) {});
+    }
+    close(fd);
+    if (!ok) {
+        std::fprintf(stderr, "doowmc: connection lost\n");
+        return 1;
+    }
+    return result;
+}
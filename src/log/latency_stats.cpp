@@ -0,0 +1,87 @@
+#include "latency_stats.h"
+#include <chrono>
+#include <sstream>
+
+LatencyStats::LatencyStats(const std::string& name)
+    : name(name) {
+    reset();
+}
+
+void LatencyStats::record(uint64_t micros) {
+    samples++;
+    total += micros;
+    if (micros > maximum) {
+        maximum = micros;
+    }
+    buckets[bucketFor(micros)]++;
+}
+
+void LatencyStats::reset() {
+    samples = 0;
+    total = 0;
+    maximum = 0;
+    buckets.fill(0);
+}
+
+double LatencyStats::mean() const {
+    return samples ? static_cast<double>(total) / samples : 0.0;
+}
+
+uint64_t LatencyStats::percentile(double p) const {
+    if (!samples) {
+        return 0;
+    }
+
+    uint64_t target = static_cast<uint64_t>(p / 100.0 * samples);
+    if (target >= samples) {
+        target = samples - 1;
+    }
+
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; i++) {
+        seen += buckets[i];
+        if (seen > target) {
+            uint64_t limit = bucketLimit(i);
+            return limit < maximum ? limit : maximum;
+        }
+    }
+    return maximum;
+}
+
+std::string LatencyStats::summary() const {
+    std::stringstream ss;
+    ss << name << ": n=" << samples;
+    if (samples) {
+        ss << ", mean=" << static_cast<uint64_t>(mean()) << "us"
+           << ", p50=" << percentile(50) << "us"
+           << ", p99=" << percentile(99) << "us"
+           << ", max=" << maximum << "us";
+    }
+    return ss.str();
+}
+
+uint64_t LatencyStats::nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int LatencyStats::bucketFor(uint64_t micros) {
+    // Values below kSubBuckets get an exact bucket each; above that the
+    // bucket is the power of two plus the next three bits
+    if (micros < kSubBuckets) {
+        return static_cast<int>(micros);
+    }
+    int exponent = 63 - __builtin_clzll(micros);
+    int sub = static_cast<int>((micros >> (exponent - 3)) & (kSubBuckets - 1));
+    return (exponent - 2) * kSubBuckets + sub;
+}
+
+uint64_t LatencyStats::bucketLimit(int bucket) {
+    if (bucket < kSubBuckets) {
+        return bucket;
+    }
+    int exponent = bucket / kSubBuckets + 2;
+    uint64_t sub = bucket % kSubBuckets;
+    uint64_t base = (static_cast<uint64_t>(kSubBuckets) + sub) << (exponent - 3);
+    return base + (1ull << (exponent - 3)) - 1;
+}
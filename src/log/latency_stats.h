@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+/**
+ * @class LatencyStats
+ * @brief Fixed-size latency histogram for performance reporting
+ *
+ * Records durations in microseconds into log-linear buckets so that
+ * recording is constant time and allocation free, which makes it safe
+ * to use on the event loop. Percentiles are approximate (within one
+ * sub-bucket, about 12%).
+ */
+class LatencyStats {
+public:
+    /**
+     * @brief Constructor
+     * @param name Name used when reporting the statistics
+     */
+    LatencyStats(const std::string& name);
+
+    /**
+     * @brief Record a duration
+     * @param micros Duration in microseconds
+     */
+    void record(uint64_t micros);
+
+    /**
+     * @brief Clear all recorded durations
+     */
+    void reset();
+
+    /**
+     * @brief Get the number of recorded durations
+     * @return The sample count
+     */
+    uint64_t count() const { return samples; }
+
+    /**
+     * @brief Get the mean duration
+     * @return The mean in microseconds, or 0 if nothing was recorded
+     */
+    double mean() const;
+
+    /**
+     * @brief Get the largest recorded duration
+     * @return The maximum in microseconds
+     */
+    uint64_t max() const { return maximum; }
+
+    /**
+     * @brief Get an approximate percentile
+     * @param p The percentile in the range [0, 100]
+     * @return Upper bound of the bucket holding the percentile, in microseconds
+     */
+    uint64_t percentile(double p) const;
+
+    /**
+     * @brief Format the statistics for the log
+     * @return A one-line summary
+     */
+    std::string summary() const;
+
+    /**
+     * @brief Get a monotonic timestamp
+     * @return Microseconds since an arbitrary fixed point
+     */
+    static uint64_t nowMicros();
+
+private:
+    static constexpr int kSubBuckets = 8;
+    static constexpr int kBuckets = 64 * kSubBuckets;
+
+    std::string name;
+    uint64_t samples;
+    uint64_t total;
+    uint64_t maximum;
+    std::array<uint32_t, kBuckets> buckets;
+
+    /**
+     * @brief Map a duration to its histogram bucket
+     * @param micros Duration in microseconds
+     * @return The bucket index
+     */
+    static int bucketFor(uint64_t micros);
+
+    /**
+     * @brief Get the largest duration that maps to a bucket
+     * @param bucket The bucket index
+     * @return The upper bound in microseconds
+     */
+    static uint64_t bucketLimit(int bucket);
+};
@@ -0,0 +1,45 @@
+#include "phase_timer.h"
+#include "latency_stats.h"
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+// Taken during static initialization, right after the dynamic loader
+// hands control to the program
+const uint64_t processStart = LatencyStats::nowMicros();
+
+std::string formatMillis(uint64_t micros) {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2) << micros / 1000.0 << "ms";
+    return ss.str();
+}
+
+} // namespace
+
+PhaseTimer::PhaseTimer(const std::string& name)
+    : name(name) {
+    start = LatencyStats::nowMicros();
+    last = start;
+}
+
+void PhaseTimer::mark(const std::string& phase) {
+    uint64_t now = LatencyStats::nowMicros();
+    phases.emplace_back(phase, now - last);
+    last = now;
+}
+
+uint64_t PhaseTimer::sinceProcessStart() {
+    return LatencyStats::nowMicros() - processStart;
+}
+
+std::string PhaseTimer::report() const {
+    std::stringstream ss;
+    ss << name << ":";
+    for (const auto& phase : phases) {
+        ss << " " << phase.first << "=" << formatMillis(phase.second);
+    }
+    ss << ", total=" << formatMillis(last - start)
+       << ", since exec=" << formatMillis(last - processStart);
+    return ss.str();
+}
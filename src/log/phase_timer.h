@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @class PhaseTimer
+ * @brief Measures consecutive phases of a sequence such as startup
+ *
+ * Each call to mark() closes the phase that started at the previous
+ * mark (or at construction) and gives it a name.
+ */
+class PhaseTimer {
+public:
+    /**
+     * @brief Constructor that starts the first phase
+     * @param name Name used when reporting the timings
+     */
+    PhaseTimer(const std::string& name);
+
+    /**
+     * @brief End the current phase
+     * @param phase Name of the phase that just finished
+     */
+    void mark(const std::string& phase);
+
+    /**
+     * @brief Get the time since the process started
+     * @return Microseconds since static initialization of the program
+     */
+    static uint64_t sinceProcessStart();
+
+    /**
+     * @brief Format the per-phase breakdown for the log
+     * @return A one-line report with every phase and the total
+     */
+    std::string report() const;
+
+private:
+    std::string name;
+    uint64_t start;
+    uint64_t last;
+    std::vector<std::pair<std::string, uint64_t>> phases;
+};
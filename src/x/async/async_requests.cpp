@@ -0,0 +1,58 @@
+#include "async_requests.h"
+#include "../connection/connection.h"
+#include "../../log/logger.h"
+#include <xcb/xcbext.h>
+
+namespace X {
+
+AsyncRequests::AsyncRequests(Connection& connection)
+    : connection(connection) {
+}
+
+AsyncRequests::~AsyncRequests() {
+    if (!waiting.empty()) {
+        Logger::debug("Abandoning " + std::to_string(waiting.size()) +
+                      " coroutines waiting for replies");
+    }
+}
+
+bool AsyncRequests::poll(unsigned int sequence, void** reply) {
+    xcb_generic_error_t* error = nullptr;
+    *reply = nullptr;
+    if (!xcb_poll_for_reply(connection.getConnection(), sequence, reply, &error)) {
+        return false;
+    }
+
+    // A failed request completes with an empty reply; the usual cause is
+    // a window destroyed while the request was in flight
+    free(error);
+    return true;
+}
+
+void AsyncRequests::wait(unsigned int sequence, std::coroutine_handle<> handle, void** reply) {
+    waiting.push_back({ sequence, handle, reply });
+}
+
+size_t AsyncRequests::resumeReady() {
+    if (waiting.empty()) {
+        return 0;
+    }
+
+    // Resumed coroutines may park again or send new requests, so work on
+    // the current list and collect the ones still waiting separately
+    std::vector<Waiter> current;
+    current.swap(waiting);
+
+    size_t resumed = 0;
+    for (size_t i = 0; i < current.size(); i++) {
+        if (poll(current[i].sequence, current[i].reply)) {
+            current[i].handle.resume();
+            resumed++;
+        } else {
+            waiting.push_back(current[i]);
+        }
+    }
+    return resumed;
+}
+
+} // namespace X
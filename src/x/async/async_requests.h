@@ -0,0 +1,161 @@
+#pragma once
+
+#include <xcb/xcb.h>
+#include <coroutine>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace X {
+
+class Connection;
+
+/**
+ * @struct FreeDeleter
+ * @brief Deleter for replies allocated by XCB
+ */
+struct FreeDeleter {
+    void operator()(void* pointer) const { free(pointer); }
+};
+
+/**
+ * @brief Owning pointer to an XCB reply
+ */
+template <typename Reply>
+using ReplyPtr = std::unique_ptr<Reply, FreeDeleter>;
+
+/**
+ * @struct ReplyOf
+ * @brief Maps an XCB cookie type to the type of its reply
+ */
+template <typename Cookie>
+struct ReplyOf;
+
+template <>
+struct ReplyOf<xcb_get_property_cookie_t> { using type = xcb_get_property_reply_t; };
+
+template <>
+struct ReplyOf<xcb_get_window_attributes_cookie_t> { using type = xcb_get_window_attributes_reply_t; };
+
+template <>
+struct ReplyOf<xcb_get_geometry_cookie_t> { using type = xcb_get_geometry_reply_t; };
+
+template <>
+struct ReplyOf<xcb_intern_atom_cookie_t> { using type = xcb_intern_atom_reply_t; };
+
+template <>
+struct ReplyOf<xcb_query_tree_cookie_t> { using type = xcb_query_tree_reply_t; };
+
+class AsyncRequests;
+
+/**
+ * @class ReplyAwaiter
+ * @brief Awaitable that completes when the reply to a request is available
+ *
+ * Awaiting yields a ReplyPtr that is empty if the request failed (an
+ * error reply, for example because the window is gone).
+ *
+ * @tparam Reply The XCB reply type
+ */
+template <typename Reply>
+class ReplyAwaiter {
+public:
+    ReplyAwaiter(AsyncRequests& requests, unsigned int sequence)
+        : requests(requests), sequence(sequence), reply(nullptr) {}
+
+    bool await_ready();
+    void await_suspend(std::coroutine_handle<> handle);
+    ReplyPtr<Reply> await_resume() { return ReplyPtr<Reply>(static_cast<Reply*>(reply)); }
+
+private:
+    AsyncRequests& requests;
+    unsigned int sequence;
+    void* reply;
+};
+
+/**
+ * @class AsyncRequests
+ * @brief Resumes coroutines waiting on XCB cookies from the event loop
+ *
+ * A coroutine that co_awaits a cookie whose reply has not arrived is
+ * parked here. After each batch of events the event handler asks for
+ * ready replies without blocking, using xcb_poll_for_reply, and resumes
+ * their coroutines. Meanwhile the event loop keeps handling input and
+ * other clients.
+ */
+class AsyncRequests {
+public:
+    /**
+     * @brief Constructor
+     * @param connection The X connection
+     */
+    AsyncRequests(Connection& connection);
+
+    /**
+     * @brief Destructor
+     *
+     * Coroutines still waiting at shutdown are abandoned: resuming them
+     * would run handlers against a window manager being torn down.
+     */
+    ~AsyncRequests();
+
+    /**
+     * @brief Await the reply to a request
+     * @param cookie The cookie of the request
+     * @return An awaitable yielding the reply
+     */
+    template <typename Cookie>
+    ReplyAwaiter<typename ReplyOf<Cookie>::type> reply(Cookie cookie) {
+        return ReplyAwaiter<typename ReplyOf<Cookie>::type>(*this, cookie.sequence);
+    }
+
+    /**
+     * @brief Resume every coroutine whose reply has arrived
+     * @return The number of coroutines resumed
+     */
+    size_t resumeReady();
+
+    /**
+     * @brief Check if any coroutine is waiting for a reply
+     * @return true if replies are outstanding, false otherwise
+     */
+    bool hasPending() const { return !waiting.empty(); }
+
+    /**
+     * @brief Take a reply if it is already available
+     * @param sequence The sequence number of the request
+     * @param reply Receives the reply, or nullptr if the request failed
+     * @return true if the request has completed, false otherwise
+     */
+    bool poll(unsigned int sequence, void** reply);
+
+    /**
+     * @brief Park a coroutine until a reply is available
+     * @param sequence The sequence number of the request
+     * @param handle The coroutine to resume
+     * @param reply Where to store the reply before resuming
+     */
+    void wait(unsigned int sequence, std::coroutine_handle<> handle, void** reply);
+
+private:
+    struct Waiter {
+        unsigned int sequence;
+        std::coroutine_handle<> handle;
+        void** reply;
+    };
+
+    Connection& connection;
+    std::vector<Waiter> waiting;
+};
+
+template <typename Reply>
+bool ReplyAwaiter<Reply>::await_ready() {
+    return requests.poll(sequence, &reply);
+}
+
+template <typename Reply>
+void ReplyAwaiter<Reply>::await_suspend(std::coroutine_handle<> handle) {
+    requests.wait(sequence, handle, &reply);
+}
+
+} // namespace X
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "../../log/logger.h"
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace X {
+
+/**
+ * @class Task
+ * @brief Fire-and-forget coroutine for event handlers
+ *
+ * Starts running immediately and frees itself when it finishes. The
+ * caller gets control back at the first co_await that has to wait for
+ * the X server.
+ */
+class Task {
+public:
+    struct promise_type {
+        Task get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+
+        void unhandled_exception() noexcept {
+            // Nobody awaits a Task, so report the error here
+            try {
+                throw;
+            } catch (const std::exception& e) {
+                Logger::error("Unhandled exception in event handler: " + std::string(e.what()));
+            } catch (...) {
+                Logger::error("Unknown exception in event handler");
+            }
+        }
+    };
+};
+
+/**
+ * @class Async
+ * @brief Lazily started coroutine producing a value for its awaiter
+ *
+ * Used for helpers that need one or more replies from the X server.
+ * The helper runs when it is awaited and resumes the awaiting
+ * coroutine directly when it returns.
+ *
+ * @tparam T The type of the result
+ */
+template <typename T>
+class Async {
+public:
+    struct promise_type {
+        std::optional<T> value;
+        std::exception_ptr exception;
+        std::coroutine_handle<> continuation;
+
+        Async get_return_object() noexcept {
+            return Async(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                auto continuation = handle.promise().continuation;
+                return continuation ? continuation : std::noop_coroutine();
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        template <typename U>
+        void return_value(U&& result) {
+            value.emplace(std::forward<U>(result));
+        }
+
+        void unhandled_exception() noexcept { exception = std::current_exception(); }
+    };
+
+    Async(Async&& other) noexcept
+        : handle(std::exchange(other.handle, nullptr)) {}
+
+    Async(const Async&) = delete;
+    Async& operator=(const Async&) = delete;
+    Async& operator=(Async&&) = delete;
+
+    ~Async() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+
+    T await_resume() {
+        if (handle.promise().exception) {
+            std::rethrow_exception(handle.promise().exception);
+        }
+        return std::move(*handle.promise().value);
+    }
+
+private:
+    explicit Async(std::coroutine_handle<promise_type> handle)
+        : handle(handle) {}
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+} // namespace X
@@ -0,0 +1,123 @@
+#include "client.h"
+
+namespace X {
+
+Client::Client(Connection& connection, xcb_window_t windowId, xcb_window_t frameId,
+               ClientIndex& index, ClientChanges& changes)
+    : connection(connection), index(index), changes(changes), window(connection, windowId), frame(connection, frameId),
+      geometry{ 0, 0, 0, 0 }, borderWidth(0), placed(false), shown(false), workspace(0), floating(false),
+      title(TitleTable::empty()), netTitle(false), ignoredUnmaps(0), mruPrev(nullptr), mruNext(nullptr) {
+}
+
+bool Client::consumeUnmap() {
+    if (!ignoredUnmaps) {
+        return false;
+    }
+    ignoredUnmaps--;
+    return true;
+}
+
+bool Client::place(const Rect& outer, unsigned int borderWidth) {
+    if (placed && outer == geometry && borderWidth == this->borderWidth) {
+        return false;
+    }
+    bool resized = !placed || outer.width != geometry.width || outer.height != geometry.height ||
+                   borderWidth != this->borderWidth;
+    geometry = outer;
+    this->borderWidth = borderWidth;
+    placed = true;
+    index.update(this);
+    changes.mark(getId());
+
+    // X sizes exclude the border and must not be zero
+    unsigned int border = 2 * borderWidth;
+    unsigned int width = outer.width > border ? outer.width - border : 1;
+    unsigned int height = outer.height > border ? outer.height - border : 1;
+    frame.configure(outer.x, outer.y, width, height);
+    if (resized) {
+        window.configure(0, 0, width, height);
+    } else {
+        sendConfigureNotify();
+    }
+    return true;
+}
+
+void Client::adopt(bool mapped) {
+    xcb_connection_t* conn = connection.getConnection();
+    xcb_window_t id = window.getId();
+
+    xcb_change_save_set(conn, XCB_SET_MODE_INSERT, id);
+
+    // Title changes arrive as PropertyNotify
+    uint32_t events[1] = { XCB_EVENT_MASK_PROPERTY_CHANGE };
+    connection.track(xcb_change_window_attributes(conn, id, XCB_CW_EVENT_MASK, events),
+                     ErrorTracker::Request::ChangeAttributes, id);
+
+    // The frame draws the border
+    uint32_t values[1] = { 0 };
+    connection.track(xcb_configure_window(conn, id, XCB_CONFIG_WINDOW_BORDER_WIDTH, values),
+                     ErrorTracker::Request::ConfigureWindow, id);
+
+    connection.track(xcb_reparent_window(conn, id, frame.getId(), 0, 0),
+                     ErrorTracker::Request::ReparentWindow, id);
+    if (mapped) {
+        // The server unmaps the window for the reparent and maps it again
+        expectUnmap();
+    } else {
+        window.queueMap();
+    }
+}
+
+void Client::show() {
+    if (!shown) {
+        frame.queueMap();
+        shown = true;
+    }
+}
+
+void Client::hide() {
+    if (shown) {
+        frame.queueUnmap();
+        shown = false;
+    }
+}
+
+void Client::release(bool destroyed) {
+    if (destroyed) {
+        return;
+    }
+    xcb_connection_t* conn = connection.getConnection();
+    xcb_window_t id = window.getId();
+
+    connection.track(xcb_reparent_window(conn, id, connection.getRootWindow(),
+                                         geometry.x, geometry.y),
+                     ErrorTracker::Request::ReparentWindow, id);
+    xcb_change_save_set(conn, XCB_SET_MODE_DELETE, id);
+}
+
+void Client::focus() {
+    auto cookie = xcb_set_input_focus(connection.getConnection(), XCB_INPUT_FOCUS_POINTER_ROOT,
+                                      window.getId(), XCB_CURRENT_TIME);
+    connection.track(cookie, ErrorTracker::Request::SetInputFocus, window.getId());
+}
+
+void Client::sendConfigureNotify() {
+    unsigned int border = 2 * borderWidth;
+
+    xcb_configure_notify_event_t event = {};
+    event.response_type = XCB_CONFIGURE_NOTIFY;
+    event.event = window.getId();
+    event.window = window.getId();
+    event.above_sibling = XCB_NONE;
+    event.x = geometry.x + borderWidth;
+    event.y = geometry.y + borderWidth;
+    event.width = geometry.width > border ? geometry.width - border : 1;
+    event.height = geometry.height > border ? geometry.height - border : 1;
+    event.border_width = 0;
+    event.override_redirect = 0;
+
+    xcb_send_event(connection.getConnection(), 0, window.getId(),
+                   XCB_EVENT_MASK_STRUCTURE_NOTIFY, reinterpret_cast<const char*>(&event));
+}
+
+} // namespace X
@@ -0,0 +1,217 @@
+#pragma once
+
+#include "../connection/connection.h"
+#include "../window/window.h"
+#include "../layout/rect.h"
+#include "client_changes.h"
+#include "client_index.h"
+#include "title_table.h"
+#include <xcb/xcb.h>
+
+namespace X {
+
+/**
+ * @class Client
+ * @brief A top-level window managed by the window manager
+ *
+ * Holds the window wrapper together with the state the window manager
+ * keeps about the client. The client window is reparented into a frame
+ * window owned by the window manager; the frame carries the border and
+ * is what gets placed, stacked, shown and hidden.
+ */
+class Client {
+public:
+    /**
+     * @brief Constructor
+     * @param connection The X connection
+     * @param windowId The ID of the client window
+     * @param frameId The ID of the frame window, see FramePool
+     * @param index The spatial index kept current by place()
+     * @param changes Told about every change of the state below
+     */
+    Client(Connection& connection, xcb_window_t windowId, xcb_window_t frameId, ClientIndex& index,
+           ClientChanges& changes);
+
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    /**
+     * @brief Get the client window ID
+     * @return The window ID
+     */
+    xcb_window_t getId() const { return window.getId(); }
+
+    /**
+     * @brief Get the client window
+     * @return Reference to the window wrapper
+     */
+    Window& getWindow() { return window; }
+
+    /**
+     * @brief Get the frame window
+     * @return Reference to the frame wrapper
+     */
+    Window& getFrame() { return frame; }
+
+    /**
+     * @brief Reparent the client window into the frame
+     * @param mapped Whether the client window is currently mapped
+     *
+     * The client window is mapped inside the frame, which stays unmapped
+     * until show(). The client is added to the save-set so it survives
+     * the window manager exiting. Requests are not flushed.
+     */
+    void adopt(bool mapped);
+
+    /**
+     * @brief Hand the client window back to the root window
+     * @param destroyed Whether the client window no longer exists
+     *
+     * Requests are not flushed.
+     */
+    void release(bool destroyed);
+
+    /**
+     * @brief Map the frame
+     */
+    void show();
+
+    /**
+     * @brief Unmap the frame; the client window stays mapped inside it
+     *
+     * Nothing is sent for a frame that is not shown, such as that of a
+     * client adopted onto a hidden workspace.
+     */
+    void hide();
+
+    /**
+     * @brief Give the client the input focus
+     *
+     * Raising is up to the StackingOrder. The request is not flushed.
+     */
+    void focus();
+
+    /**
+     * @brief Tell the client its position on the root window (ICCCM 4.2.3)
+     *
+     * Needed whenever the frame moves without the client window being
+     * resized, since the client then receives no real ConfigureNotify.
+     */
+    void sendConfigureNotify();
+
+    /**
+     * @brief Move the client to a rectangle, if it is not already there
+     * @param outer The rectangle including the border
+     * @param borderWidth The border width
+     * @return true if a configure request was queued, false otherwise
+     *
+     * A move is a single configure of the frame plus a synthetic
+     * ConfigureNotify; only a resize configures the client window too.
+     * The requests are not flushed.
+     */
+    bool place(const Rect& outer, unsigned int borderWidth);
+
+    /**
+     * @brief Get the rectangle the client was last placed in
+     * @return The rectangle including the border
+     */
+    const Rect& getGeometry() const { return geometry; }
+
+    /**
+     * @brief Check if the client has been placed by a layout
+     * @return true if the geometry is known, false otherwise
+     */
+    bool isPlaced() const { return placed; }
+
+    /**
+     * @brief Get the workspace the client is on
+     * @return The workspace index
+     */
+    unsigned int getWorkspace() const { return workspace; }
+
+    /**
+     * @brief Set the workspace the client is on
+     * @param index The workspace index
+     */
+    void setWorkspace(unsigned int index) {
+        workspace = index;
+        changes.mark(getId());
+    }
+
+    /**
+     * @brief Check if the client floats above the layout
+     * @return true if the client is placed by hand, false if it is tiled
+     */
+    bool isFloating() const { return floating; }
+
+    /**
+     * @brief Set whether the client floats above the layout
+     * @param enabled true to float, false to tile
+     */
+    void setFloating(bool enabled) {
+        floating = enabled;
+        changes.mark(getId());
+    }
+
+    /**
+     * @brief Get the window title
+     * @return The title as UTF-8, empty if there is none
+     */
+    const std::string& getTitle() const { return *title; }
+
+    /**
+     * @brief Check if the title came from _NET_WM_NAME
+     * @return true if WM_NAME changes can be ignored
+     */
+    bool hasNetTitle() const { return netTitle; }
+
+    /**
+     * @brief Set the window title, see ClientManager::setTitle()
+     * @param title The title, interned in a TitleTable
+     * @param net Whether it came from _NET_WM_NAME
+     */
+    void setTitle(const std::string* title, bool net) {
+        if (title != this->title) {
+            changes.mark(getId());
+        }
+        this->title = title;
+        netTitle = net;
+    }
+
+    /**
+     * @brief Note that the window manager unmapped the window
+     *
+     * The UnmapNotify this causes, such as the one from reparenting a
+     * mapped window, must not be taken for the client withdrawing its
+     * window.
+     */
+    void expectUnmap() { ignoredUnmaps++; }
+
+    /**
+     * @brief Check if an UnmapNotify was caused by the window manager
+     * @return true if the notification was expected and is now consumed
+     */
+    bool consumeUnmap();
+
+private:
+    friend class MruList;
+
+    Connection& connection;
+    ClientIndex& index;
+    ClientChanges& changes;
+    Window window;
+    Window frame;
+    Rect geometry;   // Last placement, including the border
+    unsigned int borderWidth;   // Of the frame; the client window has none
+    bool placed;
+    bool shown;                   // The frame is mapped
+    unsigned int workspace;
+    bool floating;
+    const std::string* title;     // Interned, see TitleTable
+    bool netTitle;
+    unsigned int ignoredUnmaps;   // UnmapNotify events caused by us still to come
+    Client* mruPrev;              // Focused more recently, see MruList
+    Client* mruNext;              // Focused less recently
+};
+
+} // namespace X
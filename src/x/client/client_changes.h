@@ -0,0 +1,58 @@
+#pragma once
+
+#include <xcb/xcb.h>
+#include <unordered_set>
+#include <vector>
+
+namespace X {
+
+/**
+ * @class ClientChanges
+ * @brief Windows whose client state changed since someone last looked
+ *
+ * Clients report changes of what the window manager tells others about
+ * them: placement, workspace, floating and title. Managing and
+ * unmanaging a window count as changes too. Nothing is recorded until
+ * tracking is enabled, so the set cannot grow without a reader.
+ */
+class ClientChanges {
+public:
+    /**
+     * @brief Constructor with tracking disabled
+     */
+    ClientChanges() : enabled(false) {}
+
+    /**
+     * @brief Start or stop recording changes
+     * @param enabled Whether to record
+     */
+    void setEnabled(bool enabled) {
+        this->enabled = enabled;
+        windows.clear();
+    }
+
+    /**
+     * @brief Record that a client changed
+     * @param window The client window ID
+     */
+    void mark(xcb_window_t window) {
+        if (enabled) {
+            windows.insert(window);
+        }
+    }
+
+    /**
+     * @brief Take the changed windows, leaving none recorded
+     * @param out Receives the windows, each once, in no particular order
+     */
+    void take(std::vector<xcb_window_t>& out) {
+        out.assign(windows.begin(), windows.end());
+        windows.clear();
+    }
+
+private:
+    bool enabled;
+    std::unordered_set<xcb_window_t> windows;
+};
+
+} // namespace X
@@ -0,0 +1,288 @@
+#include "client_index.h"
+#include "client.h"
+#include <algorithm>
+#include <climits>
+
+namespace X {
+
+namespace {
+
+/**
+ * A rectangle seen from a direction: "along" grows in the direction,
+ * "across" is perpendicular to it. Intervals are half-open.
+ */
+struct Span {
+    int alongLo, alongHi;
+    int acrossLo, acrossHi;
+};
+
+Span project(const Rect& rect, ClientIndex::Direction direction) {
+    int x0 = rect.x;
+    int x1 = rect.x + static_cast<int>(rect.width);
+    int y0 = rect.y;
+    int y1 = rect.y + static_cast<int>(rect.height);
+    switch (direction) {
+        case ClientIndex::Direction::Left:
+            return { -x1, -x0, y0, y1 };
+        case ClientIndex::Direction::Right:
+            return { x0, x1, y0, y1 };
+        case ClientIndex::Direction::Up:
+            return { -y1, -y0, x0, x1 };
+        case ClientIndex::Direction::Down:
+        default:
+            return { y0, y1, x0, x1 };
+    }
+}
+
+} // namespace
+
+ClientIndex::ClientIndex(int cellSize)
+    : cellSize(std::max(cellSize, 1)),
+      minCellX(INT_MAX), minCellY(INT_MAX), maxCellX(INT_MIN), maxCellY(INT_MIN),
+      raises(0), queries(0) {
+}
+
+void ClientIndex::update(Client* client) {
+    const Rect& rect = client->getGeometry();
+    CellRange range = rangeOf(rect);
+
+    auto it = entries.find(client);
+    if (it == entries.end()) {
+        Entry& entry = entries.emplace(client, Entry{ client, rect, range, 0, 0 }).first->second;
+        mark(entry, range, nullptr, true);
+        return;
+    }
+
+    Entry& entry = it->second;
+    entry.rect = rect;
+    if (range == entry.range) {
+        return;
+    }
+
+    // Only the cells the rectangle left or entered change
+    CellRange before = entry.range;
+    entry.range = range;
+    mark(entry, before, &range, false);
+    mark(entry, range, &before, true);
+}
+
+void ClientIndex::remove(const Client* client) {
+    auto it = entries.find(client);
+    if (it == entries.end()) {
+        return;
+    }
+    mark(it->second, it->second.range, nullptr, false);
+    entries.erase(it);
+}
+
+void ClientIndex::raise(const Client* client) {
+    auto it = entries.find(client);
+    if (it != entries.end()) {
+        it->second.raised = ++raises;
+    }
+}
+
+Client* ClientIndex::at(int x, int y, const Filter& accept) const {
+    const std::vector<Entry*>* list = cell(cellOf(x), cellOf(y));
+    if (!list) {
+        return nullptr;
+    }
+
+    // Floating clients are stacked above the tiled ones, which never overlap
+    const Entry* best = nullptr;
+    for (const Entry* entry : *list) {
+        const Rect& rect = entry->rect;
+        if (x < rect.x || y < rect.y || x >= rect.x + static_cast<int>(rect.width) ||
+            y >= rect.y + static_cast<int>(rect.height) || !accept(entry->client)) {
+            continue;
+        }
+        bool floating = entry->client->isFloating();
+        if (!best || (floating && (!best->client->isFloating() || entry->raised > best->raised))) {
+            best = entry;
+        }
+    }
+    return best ? best->client : nullptr;
+}
+
+Client* ClientIndex::nearest(const Rect& from, Direction direction, const Filter& accept) const {
+    if (entries.empty()) {
+        return nullptr;
+    }
+    queries++;
+
+    bool horizontal = direction == Direction::Left || direction == Direction::Right;
+    bool backwards = direction == Direction::Left || direction == Direction::Up;
+    int step = backwards ? -1 : 1;
+    int laneMin = horizontal ? minCellX : minCellY;
+    int laneMax = horizontal ? maxCellX : maxCellY;
+    int acrossMin = horizontal ? minCellY : minCellX;
+    int acrossMax = horizontal ? maxCellY : maxCellX;
+
+    Span origin = project(from, direction);
+    int originCentre = origin.alongLo + origin.alongHi;   // Doubled to stay integral
+    int lane = cellOf(horizontal ? from.x + static_cast<int>(from.width) / 2
+                                 : from.y + static_cast<int>(from.height) / 2);
+    int first = backwards ? std::min(lane, laneMax) : std::max(lane, laneMin);
+
+    // Cells across the lanes are visited from the start rectangle outwards
+    int acrossStart = horizontal ? from.y : from.x;
+    int acrossEnd = acrossStart + static_cast<int>(horizontal ? from.height : from.width);
+    int acrossLo = cellOf(acrossStart);
+    int acrossHi = cellOf(acrossEnd - 1);
+
+    const Entry* best = nullptr;
+    long bestScore = LONG_MAX;
+    auto visit = [&](int l, int a) {
+        const std::vector<Entry*>* list = horizontal ? cell(l, a) : cell(a, l);
+        if (!list) {
+            return;
+        }
+        for (const Entry* entry : *list) {
+            if (entry->visited == queries) {
+                continue;
+            }
+            entry->visited = queries;
+            if (!accept(entry->client)) {
+                continue;
+            }
+
+            Span span = project(entry->rect, direction);
+            if (span.alongLo + span.alongHi <= originCentre) {
+                continue;
+            }
+            long gap = std::max(0, span.alongLo - origin.alongHi);
+            long offset = std::max({ 0, span.acrossLo - origin.acrossHi,
+                                     origin.acrossLo - span.acrossHi });
+            long score = gap + 2 * offset;
+            if (score < bestScore) {
+                bestScore = score;
+                best = entry;
+            }
+        }
+    };
+
+    for (int l = first; l >= laneMin && l <= laneMax; l += step) {
+        // A client not seen yet lies entirely in this lane or beyond,
+        // so its gap is at least the distance to the lane
+        long laneGap = 0;
+        if (l != lane) {
+            long laneStart = backwards ? -static_cast<long>(l + 1) * cellSize
+                                       : static_cast<long>(l) * cellSize;
+            laneGap = std::max(0L, laneStart - origin.alongHi);
+        }
+        if (best && laneGap >= bestScore) {
+            break;
+        }
+
+        for (int a = std::max(acrossLo, acrossMin); a <= std::min(acrossHi, acrossMax); a++) {
+            visit(l, a);
+        }
+        for (int a = std::min(acrossLo - 1, acrossMax); a >= acrossMin; a--) {
+            long offset = acrossStart - static_cast<long>(a + 1) * cellSize;
+            if (best && laneGap + 2 * offset >= bestScore) {
+                break;
+            }
+            visit(l, a);
+        }
+        for (int a = std::max(acrossHi + 1, acrossMin); a <= acrossMax; a++) {
+            long offset = static_cast<long>(a) * cellSize - acrossEnd;
+            if (best && laneGap + 2 * offset >= bestScore) {
+                break;
+            }
+            visit(l, a);
+        }
+    }
+    return best ? best->client : nullptr;
+}
+
+void ClientIndex::query(const Rect& area, const Filter& accept, std::vector<Client*>& out) const {
+    queries++;
+    CellRange range = rangeOf(area);
+    range.x0 = std::max(range.x0, minCellX);
+    range.y0 = std::max(range.y0, minCellY);
+    range.x1 = std::min(range.x1, maxCellX);
+    range.y1 = std::min(range.y1, maxCellY);
+
+    for (int y = range.y0; y <= range.y1; y++) {
+        for (int x = range.x0; x <= range.x1; x++) {
+            const std::vector<Entry*>* list = cell(x, y);
+            if (!list) {
+                continue;
+            }
+            for (const Entry* entry : *list) {
+                if (entry->visited == queries) {
+                    continue;
+                }
+                entry->visited = queries;
+
+                const Rect& rect = entry->rect;
+                if (rect.x >= area.x + static_cast<int>(area.width) ||
+                    area.x >= rect.x + static_cast<int>(rect.width) ||
+                    rect.y >= area.y + static_cast<int>(area.height) ||
+                    area.y >= rect.y + static_cast<int>(rect.height)) {
+                    continue;
+                }
+                if (accept(entry->client)) {
+                    out.push_back(entry->client);
+                }
+            }
+        }
+    }
+}
+
+int ClientIndex::cellOf(int value) const {
+    return value >= 0 ? value / cellSize : -((-value - 1) / cellSize) - 1;
+}
+
+ClientIndex::CellRange ClientIndex::rangeOf(const Rect& rect) const {
+    int width = std::max(static_cast<int>(rect.width), 1);
+    int height = std::max(static_cast<int>(rect.height), 1);
+    return { cellOf(rect.x), cellOf(rect.y), cellOf(rect.x + width - 1), cellOf(rect.y + height - 1) };
+}
+
+uint64_t ClientIndex::key(int x, int y) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+void ClientIndex::mark(Entry& entry, const CellRange& range, const CellRange* skip, bool insert) {
+    for (int y = range.y0; y <= range.y1; y++) {
+        for (int x = range.x0; x <= range.x1; x++) {
+            if (skip && skip->contains(x, y)) {
+                continue;
+            }
+            if (insert) {
+                cells[key(x, y)].push_back(&entry);
+                continue;
+            }
+
+            auto it = cells.find(key(x, y));
+            if (it == cells.end()) {
+                continue;
+            }
+            std::vector<Entry*>& list = it->second;
+            auto found = std::find(list.begin(), list.end(), &entry);
+            if (found != list.end()) {
+                *found = list.back();
+                list.pop_back();
+            }
+            if (list.empty()) {
+                cells.erase(it);
+            }
+        }
+    }
+
+    // The bounds only grow; queries skip empty cells cheaply
+    if (insert) {
+        minCellX = std::min(minCellX, range.x0);
+        minCellY = std::min(minCellY, range.y0);
+        maxCellX = std::max(maxCellX, range.x1);
+        maxCellY = std::max(maxCellY, range.y1);
+    }
+}
+
+const std::vector<ClientIndex::Entry*>* ClientIndex::cell(int x, int y) const {
+    auto it = cells.find(key(x, y));
+    return it != cells.end() ? &it->second : nullptr;
+}
+
+} // namespace X
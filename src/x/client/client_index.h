@@ -0,0 +1,175 @@
+#pragma once
+
+#include "../layout/rect.h"
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace X {
+
+class Client;
+
+/**
+ * @class ClientIndex
+ * @brief Uniform grid over the cached client rectangles
+ *
+ * The screen is cut into square cells and every placed client is listed
+ * in each cell its rectangle overlaps. Client::place() keeps the index
+ * current, so queries never need a GetGeometry round trip and only look
+ * at the few clients sharing a cell with the query instead of all of
+ * them. Cells that no client touches take no memory.
+ *
+ * Queries take a filter, typically "visible and not the client itself";
+ * clients rejected by it are skipped as if they were not indexed.
+ */
+class ClientIndex {
+public:
+    using Filter = std::function<bool(const Client*)>;
+
+    /**
+     * @enum Direction
+     * @brief Directions for nearest() queries
+     */
+    enum class Direction {
+        Left,
+        Right,
+        Up,
+        Down,
+    };
+
+    /**
+     * @brief Constructor
+     * @param cellSize Edge length of a grid cell in pixels
+     */
+    explicit ClientIndex(int cellSize = 128);
+
+    ClientIndex(const ClientIndex&) = delete;
+    ClientIndex& operator=(const ClientIndex&) = delete;
+
+    /**
+     * @brief Index a client at its current geometry, or move it there
+     * @param client The client
+     *
+     * Only the cells the client left or entered are touched.
+     */
+    void update(Client* client);
+
+    /**
+     * @brief Drop a client from the index
+     * @param client The client
+     */
+    void remove(const Client* client);
+
+    /**
+     * @brief Record that a client was raised, for at()
+     * @param client The client
+     */
+    void raise(const Client* client);
+
+    /**
+     * @brief Find the client at a point
+     * @param x The x coordinate on the root window
+     * @param y The y coordinate on the root window
+     * @param accept The filter
+     * @return The floating client raised last, else the tiled client,
+     *         or nullptr if there is none at the point
+     */
+    Client* at(int x, int y, const Filter& accept) const;
+
+    /**
+     * @brief Find the nearest client in a direction
+     * @param from The rectangle to start from
+     * @param direction The direction
+     * @param accept The filter
+     * @return The client, or nullptr if there is none in that direction
+     *
+     * Distance is the gap along the direction plus twice the offset
+     * across it, so a client in line is preferred over a closer one off
+     * to the side. Cells are visited outwards from the start and the
+     * search stops once no unvisited cell can hold a nearer client.
+     */
+    Client* nearest(const Rect& from, Direction direction, const Filter& accept) const;
+
+    /**
+     * @brief Collect the clients overlapping an area
+     * @param area The area
+     * @param accept The filter
+     * @param out Receives the clients, each once
+     *
+     * Used for edge snapping with the area grown by the snap distance.
+     */
+    void query(const Rect& area, const Filter& accept, std::vector<Client*>& out) const;
+
+    /**
+     * @brief Get the number of indexed clients
+     * @return The number of clients
+     */
+    size_t size() const { return entries.size(); }
+
+private:
+    struct CellRange {
+        int x0, y0, x1, y1;   // Inclusive
+
+        bool contains(int x, int y) const { return x >= x0 && x <= x1 && y >= y0 && y <= y1; }
+        bool operator==(const CellRange& other) const {
+            return x0 == other.x0 && y0 == other.y0 && x1 == other.x1 && y1 == other.y1;
+        }
+    };
+
+    struct Entry {
+        Client* client;
+        Rect rect;
+        CellRange range;                      // Cells the rectangle overlaps
+        uint64_t raised;
+        mutable uint64_t visited;             // Last query that saw the entry
+    };
+
+    int cellSize;
+    std::unordered_map<const Client*, Entry> entries;
+    std::unordered_map<uint64_t, std::vector<Entry*>> cells;   // Entries are stable map nodes
+    int minCellX, minCellY, maxCellX, maxCellY;   // Cells ever used
+    uint64_t raises;
+    mutable uint64_t queries;
+
+    /**
+     * @brief Get the cell a coordinate falls into
+     * @param value The coordinate
+     * @return The cell index along that axis
+     */
+    int cellOf(int value) const;
+
+    /**
+     * @brief Get the cells a rectangle overlaps
+     * @param rect The rectangle
+     * @return The range of cells
+     */
+    CellRange rangeOf(const Rect& rect) const;
+
+    /**
+     * @brief Get the key of a cell
+     * @param x The cell column
+     * @param y The cell row
+     * @return The key in cells
+     */
+    static uint64_t key(int x, int y);
+
+    /**
+     * @brief Add an entry to or remove it from a range of cells
+     * @param entry The entry
+     * @param range The cells
+     * @param skip Cells to leave alone, or nullptr
+     * @param insert Whether to add rather than remove
+     */
+    void mark(Entry& entry, const CellRange& range, const CellRange* skip, bool insert);
+
+    /**
+     * @brief Get the entries listed in a cell
+     * @param x The cell column
+     * @param y The cell row
+     * @return The entries, or nullptr for an empty cell
+     */
+    const std::vector<Entry*>* cell(int x, int y) const;
+};
+
+} // namespace X
@@ -0,0 +1,169 @@
+#include "client_manager.h"
+#include "../../log/latency_stats.h"
+#include "../../log/logger.h"
+
+namespace X {
+
+namespace {
+
+// Windows that were created but never mapped (or mapped by someone who
+// does not need us) do not keep their replies parked forever
+constexpr uint64_t kPrefetchExpiryMicros = 10ull * 1000 * 1000;
+
+} // namespace
+
+ClientManager::ClientManager(Connection& connection)
+    : connection(connection), frames(connection), prefetchEnabled(true) {
+    Logger::debug("Client manager initialized");
+}
+
+ClientManager::~ClientManager() {
+    for (auto& entry : pending) {
+        discard(entry.second);
+    }
+    pending.clear();
+    byFrame.clear();
+    clients.clear();
+}
+
+Client* ClientManager::manage(xcb_window_t window, bool mapped) {
+    auto it = clients.find(window);
+    if (it != clients.end()) {
+        return it->second.get();
+    }
+
+    xcb_window_t frame = frames.acquire();
+    auto client = std::make_unique<Client>(connection, window, frame, index, changes);
+    Client* result = client.get();
+    result->adopt(mapped);
+    clients.emplace(window, std::move(client));
+    byFrame.emplace(frame, result);
+    changes.mark(window);
+    return result;
+}
+
+bool ClientManager::unmanage(xcb_window_t window, bool destroyed) {
+    auto it = clients.find(window);
+    if (it == clients.end()) {
+        return false;
+    }
+
+    // The client leaves the frame before the frame is unmapped for reuse
+    Client* client = it->second.get();
+    xcb_window_t frame = client->getFrame().getId();
+    client->release(destroyed);
+    index.remove(client);
+    titles.release(&client->getTitle());
+    frames.release(frame);
+    byFrame.erase(frame);
+    clients.erase(it);
+    changes.mark(window);
+    return true;
+}
+
+bool ClientManager::setTitle(Client* client, std::string_view title, bool net) {
+    const std::string* current = &client->getTitle();
+    if (*current == title) {
+        client->setTitle(current, net);
+        return false;
+    }
+    client->setTitle(titles.intern(title), net);
+    titles.release(current);
+    return true;
+}
+
+Client* ClientManager::find(xcb_window_t window) {
+    auto it = clients.find(window);
+    return it != clients.end() ? it->second.get() : nullptr;
+}
+
+void ClientManager::getAll(std::vector<Client*>& out) const {
+    out.reserve(out.size() + clients.size());
+    for (const auto& entry : clients) {
+        out.push_back(entry.second.get());
+    }
+}
+
+Client* ClientManager::findByFrame(xcb_window_t frame) {
+    auto it = byFrame.find(frame);
+    return it != byFrame.end() ? it->second : nullptr;
+}
+
+void ClientManager::prefetch(xcb_window_t window) {
+    if (!prefetchEnabled || pending.count(window) || clients.count(window)) {
+        return;
+    }
+
+    uint64_t now = LatencyStats::nowMicros();
+
+    // Expire old entries; ids whose prefetch was already claimed are
+    // simply skipped
+    while (!pendingOrder.empty()) {
+        auto it = pending.find(pendingOrder.front());
+        if (it != pending.end() && now - it->second.createdAt < kPrefetchExpiryMicros) {
+            break;
+        }
+        if (it != pending.end()) {
+            discard(it->second);
+            pending.erase(it);
+        }
+        pendingOrder.pop_front();
+    }
+
+    // Changes made after the queries below arrive as PropertyNotify, so
+    // the classification can be refreshed before the MapRequest reads it
+    xcb_connection_t* conn = connection.getConnection();
+    uint32_t events[1] = { XCB_EVENT_MASK_PROPERTY_CHANGE };
+    connection.track(xcb_change_window_attributes(conn, window, XCB_CW_EVENT_MASK, events),
+                     ErrorTracker::Request::ChangeAttributes, window);
+
+    PendingClient client;
+    client.query = Window::queryManage(connection, window);
+    client.pid = connection.requestWindowPid(window);
+    client.createdAt = now;
+
+    pending.emplace(window, client);
+    pendingOrder.push_back(window);
+}
+
+bool ClientManager::takePrefetch(xcb_window_t window, PendingClient& client) {
+    auto it = pending.find(window);
+    if (it == pending.end()) {
+        return false;
+    }
+    client = it->second;
+    pending.erase(it);
+    return true;
+}
+
+void ClientManager::discardPrefetch(xcb_window_t window) {
+    auto it = pending.find(window);
+    if (it != pending.end()) {
+        discard(it->second);
+        pending.erase(it);
+    }
+}
+
+void ClientManager::refreshPrefetch(xcb_window_t window, xcb_atom_t property) {
+    auto it = pending.find(window);
+    if (it == pending.end()) {
+        return;
+    }
+
+    // Toolkits set _NET_WM_PID with its own request after creating the
+    // window, so the one read at CreateNotify is usually still empty
+    if (property == connection.getAtom("_NET_WM_PID")) {
+        xcb_discard_reply(connection.getConnection(), it->second.pid.sequence);
+        it->second.pid = connection.requestWindowPid(window);
+        return;
+    }
+    Window::requeryManage(connection, window, it->second.query, property);
+}
+
+void ClientManager::discard(const PendingClient& client) {
+    xcb_connection_t* conn = connection.getConnection();
+    Window::discardManage(connection, client.query);
+    xcb_discard_reply(conn, client.pid.sequence);
+}
+
+} // namespace X
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "client.h"
+#include "../connection/connection.h"
+#include "../window/window.h"
+#include "../window/frame_pool.h"
+#include <xcb/xcb.h>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace X {
+
+/**
+ * @struct PendingClient
+ * @brief Requests sent for a window that was created but not yet mapped
+ */
+struct PendingClient {
+    Window::ManageQuery query;       // Attributes, class, type and title
+    xcb_get_property_cookie_t pid;   // _NET_WM_PID
+    uint64_t createdAt;              // When the CreateNotify was handled
+};
+
+/**
+ * @class ClientManager
+ * @brief Registry of managed clients and of windows about to become clients
+ *
+ * When a top-level window is created the requests needed to manage it
+ * are sent right away and the cookies are parked here. By the time the
+ * MapRequest arrives the replies are usually already buffered, so
+ * handling it does not wait on the server.
+ *
+ * Managed clients are reparented into frames taken from a FramePool.
+ * Their placed rectangles are kept in a ClientIndex for spatial queries.
+ */
+class ClientManager {
+public:
+    /**
+     * @brief Constructor
+     * @param connection The X connection
+     */
+    ClientManager(Connection& connection);
+
+    /**
+     * @brief Destructor that discards unclaimed prefetched replies
+     */
+    ~ClientManager();
+
+    /**
+     * @brief Start managing a window, reparenting it into a frame
+     * @param window The window ID
+     * @param mapped Whether the window is already mapped
+     * @return The client, or the existing client if already managed
+     */
+    Client* manage(xcb_window_t window, bool mapped = false);
+
+    /**
+     * @brief Stop managing a window and return its frame to the pool
+     * @param window The window ID
+     * @param destroyed Whether the window no longer exists
+     * @return true if the window was managed, false otherwise
+     */
+    bool unmanage(xcb_window_t window, bool destroyed = false);
+
+    /**
+     * @brief Find a managed client
+     * @param window The window ID
+     * @return The client, or nullptr if the window is not managed
+     */
+    Client* find(xcb_window_t window);
+
+    /**
+     * @brief Find the client a frame belongs to
+     * @param frame The frame window ID
+     * @return The client, or nullptr if the window is not a frame in use
+     */
+    Client* findByFrame(xcb_window_t frame);
+
+    /**
+     * @brief Get the number of managed clients
+     * @return The number of clients
+     */
+    size_t size() const { return clients.size(); }
+
+    /**
+     * @brief Collect the managed clients
+     * @param out Receives the clients, in no particular order
+     */
+    void getAll(std::vector<Client*>& out) const;
+
+    /**
+     * @brief Get the spatial index of the placed clients
+     * @return Reference to the index
+     */
+    ClientIndex& getIndex() { return index; }
+
+    /**
+     * @brief Get the record of changed clients
+     * @return Reference to the changes, see ClientChanges
+     */
+    ClientChanges& getChanges() { return changes; }
+
+    /**
+     * @brief Set the title of a client, sharing storage with equal titles
+     * @param client The client
+     * @param title The title as UTF-8
+     * @param net Whether it came from _NET_WM_NAME
+     * @return true if the title changed, false otherwise
+     */
+    bool setTitle(Client* client, std::string_view title, bool net);
+
+    /**
+     * @brief Get the interned titles
+     * @return Reference to the title table
+     */
+    const TitleTable& getTitles() const { return titles; }
+
+    /**
+     * @brief Send the requests needed to manage a newly created window
+     * @param window The window ID
+     */
+    void prefetch(xcb_window_t window);
+
+    /**
+     * @brief Claim the requests sent for a window
+     * @param window The window ID
+     * @param pending Receives the parked cookies
+     * @return true if requests were parked for the window, false otherwise
+     */
+    bool takePrefetch(xcb_window_t window, PendingClient& pending);
+
+    /**
+     * @brief Drop the requests parked for a window
+     * @param window The window ID
+     */
+    void discardPrefetch(xcb_window_t window);
+
+    /**
+     * @brief Re-send a parked request whose property changed before the map
+     * @param window The window ID
+     * @param property The atom of the property that changed
+     */
+    void refreshPrefetch(xcb_window_t window, xcb_atom_t property);
+
+    /**
+     * @brief Note that a MapRequest for a window is waiting on replies
+     * @param window The window ID
+     */
+    void beginMapping(xcb_window_t window) { mapping.insert(window); }
+    
+    /**
+     * @brief Finish a MapRequest started with beginMapping()
+     * @param window The window ID
+     * @return false if the window was destroyed in the meantime
+     */
+    bool endMapping(xcb_window_t window) { return mapping.erase(window) > 0; }
+    
+    /**
+     * @brief Cancel a MapRequest still waiting on replies
+     * @param window The window ID
+     */
+    void cancelMapping(xcb_window_t window) { mapping.erase(window); }
+    
+    /**
+     * @brief Enable or disable prefetching on window creation
+     * @param enabled Whether to prefetch
+     */
+    void setPrefetchEnabled(bool enabled) { prefetchEnabled = enabled; }
+
+    /**
+     * @brief Check if prefetching is enabled
+     * @return true if windows are queried on creation, false otherwise
+     */
+    bool isPrefetchEnabled() const { return prefetchEnabled; }
+
+private:
+    Connection& connection;
+    FramePool frames;   // Outlives the clients using its frames
+    ClientIndex index;  // Outlives the clients updating it
+    ClientChanges changes;   // Likewise
+    TitleTable titles;  // Shared titles of the clients
+    std::unordered_map<xcb_window_t, std::unique_ptr<Client>> clients;
+    std::unordered_map<xcb_window_t, Client*> byFrame;
+    std::unordered_map<xcb_window_t, PendingClient> pending;
+    std::deque<xcb_window_t> pendingOrder;   // Oldest prefetch first
+    std::unordered_set<xcb_window_t> mapping;  // MapRequests awaiting replies
+    bool prefetchEnabled;
+
+    /**
+     * @brief Tell XCB that parked replies will never be read
+     * @param client The parked requests
+     */
+    void discard(const PendingClient& client);
+};
+
+} // namespace X
@@ -0,0 +1,59 @@
+#include "mru_list.h"
+
+namespace X {
+
+MruList::MruList()
+    : head(nullptr), tail(nullptr) {
+}
+
+void MruList::touch(Client* client) {
+    if (head == client) {
+        return;
+    }
+    remove(client);
+
+    client->mruPrev = nullptr;
+    client->mruNext = head;
+    if (head) {
+        head->mruPrev = client;
+    } else {
+        tail = client;
+    }
+    head = client;
+}
+
+void MruList::append(Client* client) {
+    if (linked(client)) {
+        return;
+    }
+
+    client->mruPrev = tail;
+    client->mruNext = nullptr;
+    if (tail) {
+        tail->mruNext = client;
+    } else {
+        head = client;
+    }
+    tail = client;
+}
+
+void MruList::remove(Client* client) {
+    if (!linked(client)) {
+        return;
+    }
+
+    if (client->mruPrev) {
+        client->mruPrev->mruNext = client->mruNext;
+    } else {
+        head = client->mruNext;
+    }
+    if (client->mruNext) {
+        client->mruNext->mruPrev = client->mruPrev;
+    } else {
+        tail = client->mruPrev;
+    }
+    client->mruPrev = nullptr;
+    client->mruNext = nullptr;
+}
+
+} // namespace X
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "client.h"
+
+namespace X {
+
+/**
+ * @class MruList
+ * @brief Clients ordered by when they were last focused
+ *
+ * The links live on the clients themselves, so moving a client to the
+ * front on a focus change and taking it out when it goes away are
+ * constant time and never allocate.
+ */
+class MruList {
+public:
+    MruList();
+
+    MruList(const MruList&) = delete;
+    MruList& operator=(const MruList&) = delete;
+
+    /**
+     * @brief Move a client to the front, adding it if needed
+     * @param client The client that was focused
+     */
+    void touch(Client* client);
+
+    /**
+     * @brief Add a client at the back, as the least recently used
+     * @param client The client
+     */
+    void append(Client* client);
+
+    /**
+     * @brief Take a client out of the list
+     * @param client The client
+     */
+    void remove(Client* client);
+
+    /**
+     * @brief Get the most recently used client
+     * @return The client, or nullptr if the list is empty
+     */
+    Client* front() const { return head; }
+
+    /**
+     * @brief Get the client used before another one
+     * @param client A client in the list
+     * @return The next client, or nullptr at the end of the list
+     */
+    static Client* next(const Client* client) { return client->mruNext; }
+
+private:
+    Client* head;
+    Client* tail;
+
+    /**
+     * @brief Check if a client is linked into this list
+     * @param client The client
+     * @return true if the client is in the list
+     */
+    bool linked(const Client* client) const {
+        return client->mruPrev || head == client;
+    }
+};
+
+} // namespace X
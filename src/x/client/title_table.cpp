@@ -0,0 +1,47 @@
+#include "title_table.h"
+#include "../../log/logger.h"
+
+namespace X {
+
+TitleTable::TitleTable()
+    : hits(0), misses(0) {
+}
+
+TitleTable::~TitleTable() {
+    if (hits + misses) {
+        Logger::info("Titles: " + std::to_string(hits) + " already stored, " +
+                     std::to_string(misses) + " stored");
+    }
+}
+
+const std::string* TitleTable::intern(std::string_view title) {
+    if (title.empty()) {
+        return empty();
+    }
+
+    auto it = titles.find(title);
+    if (it != titles.end()) {
+        hits++;
+        it->second++;
+        return &it->first;
+    }
+    misses++;
+    return &titles.emplace(std::string(title), 1).first->first;
+}
+
+void TitleTable::release(const std::string* title) {
+    if (title == empty()) {
+        return;
+    }
+    auto it = titles.find(*title);
+    if (it != titles.end() && --it->second == 0) {
+        titles.erase(it);
+    }
+}
+
+const std::string* TitleTable::empty() {
+    static const std::string none;
+    return &none;
+}
+
+} // namespace X
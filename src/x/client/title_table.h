@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace X {
+
+/**
+ * @class TitleTable
+ * @brief Interned window titles, shared by every client showing the same one
+ *
+ * Terminals, browser tabs and file managers often carry identical titles,
+ * and a title that keeps being set to the same value is common. Each
+ * distinct title is stored once with a reference count; looking up a
+ * title that is already stored does not allocate.
+ */
+class TitleTable {
+public:
+    /**
+     * @brief Constructor
+     */
+    TitleTable();
+
+    /**
+     * @brief Destructor that reports how often a title was already stored
+     */
+    ~TitleTable();
+
+    TitleTable(const TitleTable&) = delete;
+    TitleTable& operator=(const TitleTable&) = delete;
+
+    /**
+     * @brief Get the stored copy of a title, taking a reference to it
+     * @param title The title
+     * @return The stored title, valid until the last reference is released
+     */
+    const std::string* intern(std::string_view title);
+
+    /**
+     * @brief Drop a reference taken by intern()
+     * @param title The stored title
+     */
+    void release(const std::string* title);
+
+    /**
+     * @brief Get the empty title, which needs no reference
+     * @return The empty title
+     */
+    static const std::string* empty();
+
+    /**
+     * @brief Get the number of distinct titles stored
+     * @return The number of titles
+     */
+    size_t size() const { return titles.size(); }
+
+private:
+    struct Hash {
+        using is_transparent = void;
+        size_t operator()(std::string_view text) const { return std::hash<std::string_view>()(text); }
+    };
+
+    std::unordered_map<std::string, size_t, Hash, std::equal_to<>> titles;   // Title to references
+    uint64_t hits;     // intern() found the title stored
+    uint64_t misses;   // intern() stored a new title
+};
+
+} // namespace X
@@ -0,0 +1,242 @@
+#include "config.h"
+#include "../client/client_index.h"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <X11/keysym.h>
+#include <X11/Xlib.h>
+
+namespace X {
+
+namespace {
+
+constexpr uint16_t kAlt = XCB_MOD_MASK_1;
+constexpr uint16_t kSuper = XCB_MOD_MASK_4;
+
+KeyBinding binding(xcb_keysym_t keysym, uint16_t modifiers, KeyAction action, int value = 0,
+                   bool relative = false) {
+    return KeyBinding{ keysym, modifiers, action, value, relative, std::string() };
+}
+
+int direction(ClientIndex::Direction direction) {
+    return static_cast<int>(direction);
+}
+
+bool readFile(const std::filesystem::path& path, std::string& text) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    text = contents.str();
+    return true;
+}
+
+bool parseModifier(const std::string& name, uint16_t& modifiers) {
+    if (name == "Alt" || name == "Mod1") {
+        modifiers |= XCB_MOD_MASK_1;
+    } else if (name == "Shift") {
+        modifiers |= XCB_MOD_MASK_SHIFT;
+    } else if (name == "Ctrl" || name == "Control") {
+        modifiers |= XCB_MOD_MASK_CONTROL;
+    } else if (name == "Super" || name == "Mod4") {
+        modifiers |= XCB_MOD_MASK_4;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Parse "Mod+Mod+Key" into a keysym and modifiers.
+ */
+bool parseKey(const std::string& text, xcb_keysym_t& keysym, uint16_t& modifiers) {
+    modifiers = 0;
+    size_t start = 0;
+    size_t plus;
+    while ((plus = text.find('+', start)) != std::string::npos && plus + 1 < text.size()) {
+        if (!parseModifier(text.substr(start, plus - start), modifiers)) {
+            return false;
+        }
+        start = plus + 1;
+    }
+    keysym = static_cast<xcb_keysym_t>(XStringToKeysym(text.c_str() + start));
+    return keysym != NoSymbol;
+}
+
+/**
+ * Parse a workspace argument: prev, next or a number from 1.
+ */
+bool parseWorkspace(const std::string& text, int& value, bool& relative) {
+    if (text == "prev" || text == "next") {
+        value = text == "prev" ? -1 : 1;
+        relative = true;
+        return true;
+    }
+    char* end = nullptr;
+    long number = std::strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || number < 1) {
+        return false;
+    }
+    value = static_cast<int>(number - 1);
+    relative = false;
+    return true;
+}
+
+bool parseColor(std::string text, uint32_t& color) {
+    if (!text.empty() && text[0] == '#') {
+        text = "0x" + text.substr(1);
+    }
+    char* end = nullptr;
+    unsigned long value = std::strtoul(text.c_str(), &end, 0);
+    if (text.empty() || *end != '\0' || value > 0xFFFFFF) {
+        return false;
+    }
+    color = static_cast<uint32_t>(value);
+    return true;
+}
+
+bool parseBinding(const std::vector<std::string>& words, KeyBinding& out) {
+    if (words.size() < 3 || !parseKey(words[1], out.keysym, out.modifiers)) {
+        return false;
+    }
+    const std::string& action = words[2];
+    out.value = 0;
+    out.relative = false;
+    if ((action == "workspace" || action == "move") && words.size() == 4) {
+        out.action = action == "workspace" ? KeyAction::Workspace : KeyAction::MoveToWorkspace;
+        return parseWorkspace(words[3], out.value, out.relative);
+    }
+    if (action == "focus" && words.size() == 4) {
+        static const char* directions[] = { "left", "right", "up", "down" };
+        for (int i = 0; i < 4; i++) {
+            if (words[3] == directions[i]) {
+                out.action = KeyAction::Focus;
+                out.value = i;
+                return true;
+            }
+        }
+        return false;
+    }
+    if ((action == "switch" || action == "launcher") && words.size() == 3) {
+        out.action = action == "switch" ? KeyAction::Switch : KeyAction::Launcher;
+        return true;
+    }
+    if (action == "spawn" && words.size() >= 4) {
+        out.action = KeyAction::Spawn;
+        out.command.clear();
+        for (size_t i = 3; i < words.size(); i++) {
+            out.command += (i > 3 ? " " : "") + words[i];
+        }
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+Config::Config()
+    : borderColor(0x3388FF),
+      highlightColor(0xFFAA00),
+      borderWidth(2),
+      rules(std::make_shared<const RuleMatcher>()) {
+    bindings = {
+        binding(XK_Left, kAlt, KeyAction::Workspace, -1, true),
+        binding(XK_Right, kAlt, KeyAction::Workspace, 1, true),
+        binding(XK_Left, kAlt | XCB_MOD_MASK_SHIFT, KeyAction::MoveToWorkspace, -1, true),
+        binding(XK_Right, kAlt | XCB_MOD_MASK_SHIFT, KeyAction::MoveToWorkspace, 1, true),
+        binding(XK_Left, kSuper, KeyAction::Focus, direction(ClientIndex::Direction::Left)),
+        binding(XK_Right, kSuper, KeyAction::Focus, direction(ClientIndex::Direction::Right)),
+        binding(XK_Up, kSuper, KeyAction::Focus, direction(ClientIndex::Direction::Up)),
+        binding(XK_Down, kSuper, KeyAction::Focus, direction(ClientIndex::Direction::Down)),
+        binding(XK_Tab, kAlt, KeyAction::Switch),
+        binding(XK_F2, kAlt, KeyAction::Launcher),
+    };
+}
+
+std::string Config::directory() {
+    const char* configHome = std::getenv("XDG_CONFIG_HOME");
+    const char* homeDir = std::getenv("HOME");
+    if (configHome && *configHome) {
+        return (std::filesystem::path(configHome) / "doowm").string();
+    }
+    if (homeDir) {
+        return (std::filesystem::path(homeDir) / ".config" / "doowm").string();
+    }
+    return std::string();
+}
+
+std::shared_ptr<const Config> Config::load(const std::string& directory) {
+    auto config = std::make_shared<Config>();
+    if (directory.empty()) {
+        return config;
+    }
+
+    std::string text;
+    if (readFile(std::filesystem::path(directory) / "config", text)) {
+        config->parse(text);
+    }
+    if (readFile(std::filesystem::path(directory) / "rules", text)) {
+        std::vector<Rule> parsed;
+        RuleMatcher::parse(text, parsed, &config->problems);
+        auto rules = std::make_shared<RuleMatcher>();
+        rules->compile(std::move(parsed));
+        config->rules = std::move(rules);
+    }
+    return config;
+}
+
+size_t Config::parse(const std::string& text) {
+    std::istringstream stream(text);
+    std::string line;
+    size_t number = 0;
+    size_t errors = 0;
+    std::vector<KeyBinding> parsed;
+    bool anyBinding = false;
+    while (std::getline(stream, line)) {
+        number++;
+        std::istringstream lineStream(line);
+        std::vector<std::string> words;
+        std::string word;
+        while (lineStream >> word) {
+            words.push_back(word);
+        }
+        if (words.empty() || words[0][0] == '#') {
+            continue;
+        }
+
+        bool valid = false;
+        const std::string& key = words[0];
+        if (key == "bind") {
+            KeyBinding entry{};
+            valid = parseBinding(words, entry);
+            anyBinding = true;
+            if (valid) {
+                parsed.push_back(std::move(entry));
+            }
+        } else if (key == "border_width" && words.size() == 2) {
+            char* end = nullptr;
+            unsigned long width = std::strtoul(words[1].c_str(), &end, 10);
+            valid = *end == '\0' && width <= 64;
+            if (valid) {
+                borderWidth = static_cast<unsigned int>(width);
+            }
+        } else if ((key == "border_color" || key == "highlight_color") && words.size() == 2) {
+            valid = parseColor(words[1], key == "border_color" ? borderColor : highlightColor);
+        }
+        if (!valid) {
+            problems.push_back("Config line " + std::to_string(number) + ": cannot parse \"" + line + "\"");
+            errors++;
+        }
+    }
+
+    // A broken line does not bring back the defaults for the others
+    if (anyBinding) {
+        bindings = std::move(parsed);
+    }
+    return errors;
+}
+
+} // namespace X
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "../rules/rule_matcher.h"
+#include <xcb/xcb.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace X {
+
+/**
+ * @enum KeyAction
+ * @brief What a key binding does
+ */
+enum class KeyAction : uint8_t {
+    Workspace,         // Show a workspace
+    MoveToWorkspace,   // Move the focused client to a workspace
+    Focus,             // Focus the nearest client in a direction
+    Switch,            // Cycle through the clients while Alt is held
+    Launcher,          // Show the application launcher
+    Spawn,             // Run a command
+};
+
+/**
+ * @struct KeyBinding
+ * @brief A key combination and its action
+ */
+struct KeyBinding {
+    xcb_keysym_t keysym;
+    uint16_t modifiers;
+    KeyAction action;
+    int value;             // Workspace from 0 or offset if relative; ClientIndex::Direction for Focus
+    bool relative;
+    std::string command;   // For Spawn
+};
+
+/**
+ * @struct Config
+ * @brief The user configuration, compiled into flat tables
+ *
+ * Read from the directory $XDG_CONFIG_HOME/doowm (~/.config/doowm): the
+ * file "config" and the window rules in "rules", see RuleMatcher. A
+ * Config is never changed once loaded; a reload builds a new one, so it
+ * can be built on any thread and swapped in whole.
+ *
+ * Config lines look like
+ *
+ *     border_width 2
+ *     border_color 0x3388FF
+ *     highlight_color #FFAA00
+ *     bind Alt+Left workspace prev
+ *     bind Alt+Shift+3 move 3
+ *     bind Super+Up focus up
+ *     bind Super+Return spawn xterm -e tmux
+ *
+ * with the actions workspace and move (prev, next or N from 1), focus
+ * (left, right, up or down), switch, launcher and spawn. Key names are
+ * X keysym names; modifiers are Alt, Shift, Ctrl and Super. Bindings in
+ * the file replace the default ones as a whole. Empty lines and lines
+ * starting with '#' are ignored.
+ */
+struct Config {
+    std::vector<KeyBinding> bindings;
+    uint32_t borderColor;         // Of managed clients
+    uint32_t highlightColor;      // Of the client selected by Alt+Tab
+    unsigned int borderWidth;
+    std::shared_ptr<const RuleMatcher> rules;
+    std::vector<std::string> problems;   // Messages about skipped lines, to be logged
+
+    /**
+     * @brief Constructor for the defaults
+     */
+    Config();
+
+    /**
+     * @brief Get the configuration directory
+     * @return The directory, empty if neither $XDG_CONFIG_HOME nor $HOME is set
+     */
+    static std::string directory();
+
+    /**
+     * @brief Read and compile the configuration; does not log
+     * @param directory The configuration directory
+     * @return The configuration; defaults for missing files and skipped lines
+     */
+    static std::shared_ptr<const Config> load(const std::string& directory);
+
+    /**
+     * @brief Parse a config file into this configuration
+     * @param text The file contents
+     * @return The number of lines that could not be parsed
+     */
+    size_t parse(const std::string& text);
+};
+
+} // namespace X
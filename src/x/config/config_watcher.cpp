@@ -0,0 +1,136 @@
+#include "config_watcher.h"
+#include "../../log/logger.h"
+#include <cerrno>
+#include <cstring>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace X {
+
+ConfigWatcher::ConfigWatcher(EventLoop& loop, std::string directory)
+    : loop(loop), directory(std::move(directory)), inotifyFd(-1), wakeupFd(-1), requested(false),
+      stopping(false), reloads(0) {
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    if (thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeup.notify_one();
+        thread.join();
+    }
+    for (int fd : { inotifyFd, wakeupFd }) {
+        if (fd >= 0) {
+            loop.removeWatch(fd);
+            ::close(fd);
+        }
+    }
+    if (reloads) {
+        Logger::info("Configuration reloaded " + std::to_string(reloads) + " times");
+    }
+}
+
+bool ConfigWatcher::start(Loaded loaded) {
+    this->loaded = std::move(loaded);
+
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0) {
+        Logger::warning(std::string("Failed to create inotify instance: ") + std::strerror(errno));
+        return false;
+    }
+
+    // Editors replace files by renaming as often as they write them
+    uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE;
+    if (inotify_add_watch(inotifyFd, directory.c_str(), mask) < 0) {
+        Logger::info("Not watching " + directory + " for configuration changes: " + std::strerror(errno));
+        return false;
+    }
+
+    wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeupFd < 0) {
+        Logger::warning(std::string("Failed to create eventfd: ") + std::strerror(errno));
+        return false;
+    }
+
+    try {
+        thread = std::thread(&ConfigWatcher::run, this);
+    } catch (const std::system_error& e) {
+        Logger::warning(std::string("Failed to start configuration thread: ") + e.what());
+        return false;
+    }
+
+    loop.addWatch(inotifyFd, [this]() { changed(); });
+    loop.addWatch(wakeupFd, [this]() { collect(); });
+    Logger::info("Watching " + directory + " for configuration changes");
+    return true;
+}
+
+void ConfigWatcher::changed() {
+    alignas(inotify_event) char buffer[4096];
+    bool relevant = false;
+    ssize_t length;
+    while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+        for (char* at = buffer; at < buffer + length;) {
+            auto event = reinterpret_cast<const inotify_event*>(at);
+            if (event->len && (std::strcmp(event->name, "config") == 0 || std::strcmp(event->name, "rules") == 0)) {
+                relevant = true;
+            }
+            at += sizeof(inotify_event) + event->len;
+        }
+    }
+    if (!relevant) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requested = true;
+    }
+    wakeup.notify_one();
+}
+
+void ConfigWatcher::run() {
+    // Must not log: the logger is not thread safe
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeup.wait(lock, [this]() { return stopping || requested; });
+            if (stopping) {
+                return;
+            }
+            requested = false;
+        }
+
+        std::shared_ptr<const Config> config = Config::load(directory);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready = std::move(config);
+        }
+        uint64_t one = 1;
+        if (write(wakeupFd, &one, sizeof(one)) < 0) {
+            continue;
+        }
+    }
+}
+
+void ConfigWatcher::collect() {
+    uint64_t count;
+    while (read(wakeupFd, &count, sizeof(count)) == sizeof(count)) {
+    }
+
+    std::shared_ptr<const Config> config;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        config.swap(ready);
+    }
+    if (config) {
+        reloads++;
+        loaded(std::move(config));
+    }
+}
+
+} // namespace X
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "config.h"
+#include "../event/event_loop.h"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace X {
+
+/**
+ * @class ConfigWatcher
+ * @brief Reloads the configuration when its files change
+ *
+ * inotify on the configuration directory is served from the event loop;
+ * a change only wakes a worker thread, which reads and compiles the files
+ * into a new Config. The finished Config comes back through an eventfd
+ * and is handed over on the main thread, between two passes, so event
+ * handling never waits on the disk or the parser and never sees half a
+ * configuration. Changes arriving during a reload cause one more.
+ */
+class ConfigWatcher {
+public:
+    /**
+     * @brief Takes a reloaded configuration on the main thread
+     */
+    using Loaded = std::function<void(std::shared_ptr<const Config> config)>;
+
+    /**
+     * @brief Constructor
+     * @param loop The event loop
+     * @param directory The configuration directory
+     */
+    ConfigWatcher(EventLoop& loop, std::string directory);
+
+    /**
+     * @brief Destructor that stops watching and joins the worker
+     */
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    /**
+     * @brief Start watching
+     * @param loaded The function taking reloaded configurations
+     * @return true on success, false if the directory cannot be watched
+     */
+    bool start(Loaded loaded);
+
+private:
+    EventLoop& loop;
+    std::string directory;
+    Loaded loaded;
+    int inotifyFd;
+    int wakeupFd;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    bool requested;                       // Guarded by mutex
+    bool stopping;                        // Guarded by mutex
+    std::shared_ptr<const Config> ready;  // Guarded by mutex
+    uint64_t reloads;
+
+    /**
+     * @brief Read inotify events and ask for a reload if a file changed
+     */
+    void changed();
+
+    /**
+     * @brief Body of the worker thread
+     */
+    void run();
+
+    /**
+     * @brief Hand a reloaded configuration over on the main thread
+     */
+    void collect();
+};
+
+} // namespace X
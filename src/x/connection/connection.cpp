@@ -3,10 +3,12 @@
 #include <xcb/xcb_atom.h>
 #include <xcb/xcb_icccm.h>
 #include <stdexcept>
+#include <fcntl.h>
 
 namespace X {
 
-Connection::Connection(const char* displayName) {
+Connection::Connection(const char* displayName)
+    : async(*this) {
     Logger::debug("Connecting to X server" + 
                  (displayName ? std::string(": ") + displayName : std::string("")));
     
@@ -45,6 +47,10 @@ Connection::Connection(const char* displayName) {
         throw std::runtime_error(errorMsg);
     }
     
+    // Keep the X socket out of launched processes
+    int fd = xcb_get_file_descriptor(connection);
+    fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) | FD_CLOEXEC);
+    
     // Get the screen
     const xcb_setup_t* setup = xcb_get_setup(connection);
     xcb_screen_iterator_t iter = xcb_setup_roots_iterator(setup);
@@ -68,7 +74,14 @@ Connection::Connection(const char* displayName) {
 
 Connection::~Connection() {
     Logger::debug("Disconnecting from X server");
+    
     if (connection) {
+        // Unclaimed replies are owned by XCB until they are collected
+        for (auto& entry : pendingAtoms) {
+            xcb_discard_reply(connection, entry.second.sequence);
+        }
+        pendingAtoms.clear();
+        
         xcb_disconnect(connection);
         connection = nullptr;
     }
@@ -78,6 +91,10 @@ bool Connection::isConnected() const {
     return connection && (xcb_connection_has_error(connection) == 0);
 }
 
+int Connection::getFileDescriptor() const {
+    return xcb_get_file_descriptor(connection);
+}
+
 void Connection::flush() {
     xcb_flush(connection);
 }
@@ -86,37 +103,174 @@ xcb_window_t Connection::generateId() {
     return xcb_generate_id(connection);
 }
 
+namespace {
+
+/**
+ * Drop a multi-byte UTF-8 sequence that the length limit cut short.
+ */
+void trimPartialCharacter(std::string& text) {
+    size_t start = text.size();
+    while (start > 0 && text.size() - start < 3 && (text[start - 1] & 0xC0) == 0x80) {
+        start--;
+    }
+    if (start == 0) {
+        return;
+    }
+    unsigned char lead = static_cast<unsigned char>(text[start - 1]);
+    size_t length = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+    if (text.size() - (start - 1) < length) {
+        text.resize(start - 1);
+    }
+}
+
+} // namespace
+
 std::string Connection::getWindowName(xcb_window_t window) {
-    // Try to get _NET_WM_NAME (UTF-8)
-    xcb_get_property_cookie_t cookie = xcb_get_property(
+    TitleQuery query = requestWindowTitle(window);
+    ReplyPtr<xcb_get_property_reply_t> name(xcb_get_property_reply(connection, query.name, nullptr));
+    ReplyPtr<xcb_get_property_reply_t> legacyName(
+        xcb_get_property_reply(connection, query.legacyName, nullptr));
+    
+    std::string title;
+    parseWindowTitle(name.get(), legacyName.get(), title);
+    return title;
+}
+
+Connection::TitleQuery Connection::requestWindowTitle(xcb_window_t window) {
+    // Both at once: WM_NAME is only used if _NET_WM_NAME is missing
+    TitleQuery query;
+    query.name = xcb_get_property(connection, 0, window, getAtom("_NET_WM_NAME"),
+                                  getAtom("UTF8_STRING"), 0, kTitleWords);
+    query.legacyName = xcb_get_property(connection, 0, window, XCB_ATOM_WM_NAME,
+                                        XCB_GET_PROPERTY_TYPE_ANY, 0, kTitleWords);
+    return query;
+}
+
+bool Connection::parseWindowTitle(const xcb_get_property_reply_t* name,
+                                  const xcb_get_property_reply_t* legacyName, std::string& title) {
+    title.clear();
+    bool utf8 = name && name->format == 8 && name->value_len > 0;
+    const xcb_get_property_reply_t* reply = utf8 ? name : legacyName;
+    if (!reply || reply->format != 8) {
+        return false;
+    }
+    
+    auto mutableReply = const_cast<xcb_get_property_reply_t*>(reply);
+    const char* value = static_cast<const char*>(xcb_get_property_value(mutableReply));
+    int length = xcb_get_property_value_length(mutableReply);
+    
+    if (utf8 || reply->type != XCB_ATOM_STRING) {
+        // COMPOUND_TEXT is passed through; its ASCII part reads correctly
+        title.assign(value, length);
+        if (reply->bytes_after) {
+            trimPartialCharacter(title);
+        }
+        return utf8;
+    }
+    
+    // STRING is Latin-1, which maps directly onto the first code points
+    for (int i = 0; i < length; i++) {
+        unsigned char c = static_cast<unsigned char>(value[i]);
+        if (c < 0x80) {
+            title += static_cast<char>(c);
+        } else {
+            title += static_cast<char>(0xC0 | (c >> 6));
+            title += static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+    return false;
+}
+
+uint32_t Connection::getWindowPid(xcb_window_t window) {
+    return getWindowPid(requestWindowPid(window));
+}
+
+xcb_get_property_cookie_t Connection::requestWindowPid(xcb_window_t window) {
+    return xcb_get_property(
         connection,
         0,
         window,
-        XCB_ATOM_WM_NAME,
-        XCB_ATOM_STRING,
+        getAtom("_NET_WM_PID"),
+        XCB_ATOM_CARDINAL,
         0,
-        1024
+        1
     );
-    
+}
+
+uint32_t Connection::getWindowPid(xcb_get_property_cookie_t cookie) {
     xcb_get_property_reply_t* reply = xcb_get_property_reply(
         connection,
         cookie,
         nullptr
     );
     
-    if (!reply) {
-        return "";
+    uint32_t pid = parseWindowPid(reply);
+    free(reply);
+    return pid;
+}
+
+uint32_t Connection::parseWindowPid(const xcb_get_property_reply_t* reply) {
+    if (!reply || reply->type != XCB_ATOM_CARDINAL || reply->format != 32) {
+        return 0;
+    }
+    
+    auto mutableReply = const_cast<xcb_get_property_reply_t*>(reply);
+    if (xcb_get_property_value_length(mutableReply) < 4) {
+        return 0;
+    }
+    return *static_cast<uint32_t*>(xcb_get_property_value(mutableReply));
+}
+
+xcb_atom_t Connection::getAtom(const std::string& name) {
+    auto it = atoms.find(name);
+    if (it != atoms.end()) {
+        return it->second;
     }
     
-    std::string name;
-    if (reply->type == XCB_ATOM_STRING && reply->format == 8) {
-        const char* value = (const char*)xcb_get_property_value(reply);
-        int len = xcb_get_property_value_length(reply);
-        name = std::string(value, len);
+    xcb_intern_atom_cookie_t cookie;
+    auto pending = pendingAtoms.find(name);
+    if (pending != pendingAtoms.end()) {
+        cookie = pending->second;
+        pendingAtoms.erase(pending);
+    } else {
+        cookie = xcb_intern_atom(
+            connection,
+            0,
+            name.length(),
+            name.c_str()
+        );
     }
     
+    xcb_intern_atom_reply_t* reply = xcb_intern_atom_reply(
+        connection,
+        cookie,
+        nullptr
+    );
+    
+    if (!reply) {
+        Logger::warning("Failed to intern atom " + name);
+        return XCB_ATOM_NONE;
+    }
+    
+    xcb_atom_t atom = reply->atom;
     free(reply);
-    return name;
+    
+    atoms[name] = atom;
+    return atom;
+}
+
+void Connection::prefetchAtoms(const std::vector<std::string>& names) {
+    for (const auto& name : names) {
+        if (atoms.count(name) || pendingAtoms.count(name)) {
+            continue;
+        }
+        pendingAtoms[name] = xcb_intern_atom(
+            connection,
+            0,
+            name.length(),
+            name.c_str()
+        );
+    }
 }
 
 xcb_connection_t* Connection::getConnection() const {
@@ -1,8 +1,12 @@
 #pragma once
 
+#include "../error/error_tracker.h"
+#include "../async/async_requests.h"
 #include <xcb/xcb.h>
 #include <string>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 namespace X {
 
@@ -15,6 +19,18 @@ namespace X {
  */
 class Connection {
 public:
+    /**
+     * @struct TitleQuery
+     * @brief Cookies of the two properties a window title is read from
+     */
+    struct TitleQuery {
+        xcb_get_property_cookie_t name;         // _NET_WM_NAME, UTF-8
+        xcb_get_property_cookie_t legacyName;   // WM_NAME, usually Latin-1
+    };
+    
+    // Titles are read up to 256 bytes; they feed rules, the switcher and IPC
+    static constexpr uint32_t kTitleWords = 64;
+    
     /**
      * @brief Constructor that establishes a connection to the X server
      */
@@ -49,6 +65,12 @@ public:
      */
     xcb_screen_t* getScreen() const { return screen; }
     
+    /**
+     * @brief Get the file descriptor of the connection
+     * @return The descriptor of the X socket
+     */
+    int getFileDescriptor() const;
+    
     /**
      * @brief Flush the connection (send all pending requests)
      */
@@ -66,7 +88,92 @@ public:
      * @return The window name or an empty string if not available
      */
     std::string getWindowName(xcb_window_t window);
+    
+    /**
+     * @brief Send the requests for a window title without waiting
+     * @param window The window ID
+     * @return The cookies, to pass to parseWindowTitle() with their replies
+     */
+    TitleQuery requestWindowTitle(xcb_window_t window);
+    
+    /**
+     * @brief Read a window title from the replies of a TitleQuery
+     * @param name Reply for _NET_WM_NAME, or nullptr
+     * @param legacyName Reply for WM_NAME, or nullptr
+     * @param title Receives the title as UTF-8; its storage is reused
+     * @return true if the title came from _NET_WM_NAME, false otherwise
+     *
+     * A title cut at the length limit is cut back to a whole character.
+     */
+    static bool parseWindowTitle(const xcb_get_property_reply_t* name,
+                                 const xcb_get_property_reply_t* legacyName, std::string& title);
+    
+    /**
+     * @brief Get the PID of the process owning a window
+     * @param window The window ID
+     * @return The _NET_WM_PID of the window, or 0 if not set
+     */
+    uint32_t getWindowPid(xcb_window_t window);
+    
+    /**
+     * @brief Read the PID of a window from a request sent earlier
+     * @param cookie Cookie of a _NET_WM_PID property request
+     * @return The _NET_WM_PID of the window, or 0 if not set
+     */
+    uint32_t getWindowPid(xcb_get_property_cookie_t cookie);
+    
+    /**
+     * @brief Send a request for the _NET_WM_PID of a window
+     * @param window The window ID
+     * @return The cookie of the property request
+     */
+    xcb_get_property_cookie_t requestWindowPid(xcb_window_t window);
+    
+    /**
+     * @brief Extract the PID from a _NET_WM_PID property reply
+     * @param reply The reply, may be nullptr
+     * @return The PID, or 0 if not set
+     */
+    static uint32_t parseWindowPid(const xcb_get_property_reply_t* reply);
+    
+    /**
+     * @brief Get an atom by name, interning it on first use
+     * @param name The atom name
+     * @return The atom, or XCB_ATOM_NONE on failure
+     */
+    xcb_atom_t getAtom(const std::string& name);
+    
+    /**
+     * @brief Send intern requests for atoms without waiting for the replies
+     * @param names The atom names
+     *
+     * The replies are collected by getAtom() on first use, so the round
+     * trip overlaps with whatever is sent in between.
+     */
+    void prefetchAtoms(const std::vector<std::string>& names);
 
+    /**
+     * @brief Record an unchecked request so its errors can be attributed
+     * @param cookie The cookie of the request
+     * @param request The operation
+     * @param window The window the request targets
+     */
+    void track(xcb_void_cookie_t cookie, ErrorTracker::Request request, xcb_window_t window) {
+        errors.track(cookie.sequence, request, window);
+    }
+    
+    /**
+     * @brief Get the asynchronous error tracker
+     * @return Reference to the error tracker
+     */
+    ErrorTracker& getErrors() { return errors; }
+    
+    /**
+     * @brief Get the coroutine layer for awaiting replies
+     * @return Reference to the pending request registry
+     */
+    AsyncRequests& getAsync() { return async; }
+    
     /**
      * @brief Close the connection to the X server
      */
@@ -76,6 +183,10 @@ private:
     xcb_connection_t* connection;
     xcb_screen_t* screen;
     int screenNum;
+    ErrorTracker errors;
+    AsyncRequests async;
+    std::unordered_map<std::string, xcb_atom_t> atoms;  // Interned atom cache
+    std::unordered_map<std::string, xcb_intern_atom_cookie_t> pendingAtoms;
 };
 
 } // namespace X 
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "error_tracker.h"
+#include "../../log/logger.h"
+#include <sstream>
+
+namespace X {
+
+namespace {
+
+// Sequence numbers wrap around, so compare them by signed distance
+bool sequenceBefore(unsigned int a, unsigned int b) {
+    return static_cast<int32_t>(a - b) < 0;
+}
+
+const char* errorName(uint8_t code) {
+    switch (code) {
+        case XCB_REQUEST:        return "BadRequest";
+        case XCB_VALUE:          return "BadValue";
+        case XCB_WINDOW:         return "BadWindow";
+        case XCB_PIXMAP:         return "BadPixmap";
+        case XCB_ATOM:           return "BadAtom";
+        case XCB_MATCH:          return "BadMatch";
+        case XCB_DRAWABLE:       return "BadDrawable";
+        case XCB_ACCESS:         return "BadAccess";
+        case XCB_ALLOC:          return "BadAlloc";
+        case XCB_ID_CHOICE:      return "BadIDChoice";
+        case XCB_LENGTH:         return "BadLength";
+        case XCB_IMPLEMENTATION: return "BadImplementation";
+        default:                 return "Unknown";
+    }
+}
+
+} // namespace
+
+ErrorTracker::ErrorTracker()
+    : ring(kCapacity), head(0), tail(0), droppedRaces(0), reported(0), untracked(0) {
+    racesByRequest.fill(0);
+}
+
+ErrorTracker::~ErrorTracker() {
+    if (droppedRaces || reported) {
+        std::stringstream ss;
+        ss << "X errors: " << droppedRaces << " BadWindow races dropped (";
+        for (size_t i = 0; i < racesByRequest.size(); i++) {
+            ss << (i ? ", " : "") << requestName(static_cast<Request>(i))
+               << "=" << racesByRequest[i];
+        }
+        ss << "), " << reported << " reported, " << untracked << " untracked";
+        Logger::info(ss.str());
+    }
+}
+
+void ErrorTracker::track(unsigned int sequence, Request request, xcb_window_t window) {
+    if (head - tail == kCapacity) {
+        // Nothing has been retired for a whole ring: lose the oldest record
+        tail++;
+    }
+    ring[head % kCapacity] = { sequence, window, request };
+    head++;
+}
+
+void ErrorTracker::retire(unsigned int sequence) {
+    while (tail != head && sequenceBefore(ring[tail % kCapacity].sequence, sequence)) {
+        tail++;
+    }
+}
+
+void ErrorTracker::handle(const xcb_generic_error_t* error) {
+    const Entry* entry = find(error->full_sequence);
+
+    // A window destroyed by its client while our request was in flight
+    if (error->error_code == XCB_WINDOW) {
+        droppedRaces++;
+        if (entry) {
+            racesByRequest[static_cast<size_t>(entry->request)]++;
+        } else {
+            untracked++;
+        }
+        return;
+    }
+
+    std::stringstream ss;
+    ss << "X error " << errorName(error->error_code)
+       << " (code " << static_cast<int>(error->error_code) << ")";
+    if (entry) {
+        reported++;
+        ss << " from " << requestName(entry->request)
+           << " on window 0x" << std::hex << entry->window << std::dec;
+    } else {
+        untracked++;
+        ss << " from untracked request (major " << static_cast<int>(error->major_code)
+           << ", minor " << error->minor_code << ")";
+    }
+    ss << ", sequence " << error->full_sequence
+       << ", resource 0x" << std::hex << error->resource_id;
+    Logger::warning(ss.str());
+}
+
+const ErrorTracker::Entry* ErrorTracker::find(unsigned int sequence) const {
+    if (tail == head) {
+        return nullptr;
+    }
+
+    // Records are appended in sequence order: binary search on the
+    // distance from the oldest one
+    unsigned int base = ring[tail % kCapacity].sequence;
+    unsigned int target = sequence - base;
+    uint64_t low = tail;
+    uint64_t high = head;
+    while (low < high) {
+        uint64_t mid = low + (high - low) / 2;
+        unsigned int offset = ring[mid % kCapacity].sequence - base;
+        if (offset < target) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if (low != head && ring[low % kCapacity].sequence == sequence) {
+        return &ring[low % kCapacity];
+    }
+    return nullptr;
+}
+
+const char* ErrorTracker::requestName(Request request) {
+    switch (request) {
+        case Request::MapWindow:        return "MapWindow";
+        case Request::UnmapWindow:      return "UnmapWindow";
+        case Request::ConfigureWindow:  return "ConfigureWindow";
+        case Request::ChangeAttributes: return "ChangeWindowAttributes";
+        case Request::SetInputFocus:    return "SetInputFocus";
+        case Request::CreateWindow:     return "CreateWindow";
+        case Request::ReparentWindow:   return "ReparentWindow";
+        case Request::ChangeProperty:   return "ChangeProperty";
+        default:                        return "Unknown";
+    }
+}
+
+} // namespace X
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <xcb/xcb.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace X {
+
+/**
+ * @class ErrorTracker
+ * @brief Correlates asynchronous X errors with the requests that caused them
+ *
+ * Requests are sent unchecked so nothing waits for the server. Their
+ * sequence numbers are recorded together with the operation and the
+ * target window; when an error arrives in the event stream it is
+ * matched against that record by sequence number.
+ *
+ * BadWindow errors are expected whenever a client destroys a window
+ * while a request for it is in flight. They are counted and dropped
+ * without formatting any log message.
+ */
+class ErrorTracker {
+public:
+    /**
+     * @enum Request
+     * @brief Operations whose errors are worth attributing
+     */
+    enum class Request : uint8_t {
+        MapWindow,
+        UnmapWindow,
+        ConfigureWindow,
+        ChangeAttributes,
+        SetInputFocus,
+        CreateWindow,
+        ReparentWindow,
+        ChangeProperty,
+        Count
+    };
+
+    /**
+     * @brief Constructor
+     */
+    ErrorTracker();
+
+    /**
+     * @brief Destructor that reports error counts
+     */
+    ~ErrorTracker();
+
+    /**
+     * @brief Record a request whose errors should be attributed
+     * @param sequence Sequence number of the request
+     * @param request The operation
+     * @param window The window the request targets
+     */
+    void track(unsigned int sequence, Request request, xcb_window_t window);
+
+    /**
+     * @brief Forget requests that can no longer produce an error
+     * @param sequence Sequence number of the latest event received
+     *
+     * The server reports errors in request order, so once an event with
+     * a given sequence number arrives no earlier request can fail.
+     */
+    void retire(unsigned int sequence);
+
+    /**
+     * @brief Handle an error received from the event stream
+     * @param error The error
+     */
+    void handle(const xcb_generic_error_t* error);
+
+    /**
+     * @brief Get the number of BadWindow errors dropped as destroy races
+     * @return The number of dropped errors
+     */
+    uint64_t getDroppedRaces() const { return droppedRaces; }
+
+    /**
+     * @brief Get the name of an operation
+     * @param request The operation
+     * @return A static string naming the request
+     */
+    static const char* requestName(Request request);
+
+private:
+    struct Entry {
+        unsigned int sequence;
+        xcb_window_t window;
+        Request request;
+    };
+
+    static constexpr size_t kCapacity = 1024;
+
+    std::vector<Entry> ring;
+    uint64_t head;   // Next slot to write
+    uint64_t tail;   // Oldest live slot
+    uint64_t droppedRaces;
+    uint64_t reported;
+    uint64_t untracked;
+    std::array<uint64_t, static_cast<size_t>(Request::Count)> racesByRequest;
+
+    /**
+     * @brief Find the record of a request
+     * @param sequence Sequence number of the request
+     * @return The record, or nullptr if it was not tracked
+     */
+    const Entry* find(unsigned int sequence) const;
+};
+
+} // namespace X
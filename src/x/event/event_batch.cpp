@@ -0,0 +1,143 @@
+#include "event_batch.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace X {
+
+EventBatch::EventBatch(xcb_window_t root)
+    : root(root) {
+}
+
+EventBatch::~EventBatch() {
+    clear();
+}
+
+void EventBatch::add(xcb_generic_event_t* event, uint64_t receivedAt, bool ordered) {
+    entries.push_back({ event, receivedAt, classify(event), ordered });
+}
+
+void EventBatch::schedule() {
+    // Walk backwards so every event sees the best class of the events
+    // after it for the same window, and is promoted to at least that
+    laterBest.clear();
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        xcb_window_t window = windowOf(it->event);
+        if (!window) {
+            continue;
+        }
+        auto found = laterBest.try_emplace(window, it->priority);
+        if (!found.second) {
+            if (found.first->second < it->priority) {
+                it->priority = found.first->second;
+            } else {
+                found.first->second = it->priority;
+            }
+        }
+    }
+
+    auto byPriority = [](const Entry& a, const Entry& b) { return a.priority < b.priority; };
+    if (!std::is_sorted(entries.begin(), entries.end(), byPriority)) {
+        std::stable_sort(entries.begin(), entries.end(), byPriority);
+    }
+}
+
+void EventBatch::clear() {
+    for (const auto& entry : entries) {
+        free(entry.event);
+    }
+    entries.clear();
+}
+
+bool EventBatch::lastOrderedSequence(unsigned int& sequence) const {
+    // Sequence numbers wrap around, so compare them by signed distance
+    bool found = false;
+    for (const auto& entry : entries) {
+        if (entry.ordered &&
+            (!found || static_cast<int32_t>(entry.event->full_sequence - sequence) > 0)) {
+            sequence = entry.event->full_sequence;
+            found = true;
+        }
+    }
+    return found;
+}
+
+size_t EventBatch::backgroundCount() const {
+    return std::count_if(entries.begin(), entries.end(), [](const Entry& entry) {
+        return classify(entry.event) != Priority::Input;
+    });
+}
+
+EventBatch::Priority EventBatch::classify(const xcb_generic_event_t* event) {
+    switch (event->response_type & ~0x80) {
+        case XCB_KEY_PRESS:
+        case XCB_KEY_RELEASE:
+        case XCB_BUTTON_PRESS:
+        case XCB_BUTTON_RELEASE:
+        case XCB_MOTION_NOTIFY:
+            return Priority::Input;
+        case XCB_FOCUS_IN:
+        case XCB_FOCUS_OUT:
+        case XCB_ENTER_NOTIFY:
+        case XCB_LEAVE_NOTIFY:
+        case XCB_CREATE_NOTIFY:
+        case XCB_DESTROY_NOTIFY:
+        case XCB_MAP_REQUEST:
+        case XCB_MAP_NOTIFY:
+        case XCB_UNMAP_NOTIFY:
+            return Priority::Focus;
+        case XCB_CONFIGURE_REQUEST:
+        case XCB_CONFIGURE_NOTIFY:
+            return Priority::Configure;
+        default:
+            // Property changes, client messages, errors and the rest
+            return Priority::Property;
+    }
+}
+
+xcb_window_t EventBatch::windowOf(const xcb_generic_event_t* event) const {
+    switch (event->response_type & ~0x80) {
+        case XCB_KEY_PRESS:
+        case XCB_KEY_RELEASE:
+        case XCB_BUTTON_PRESS:
+        case XCB_BUTTON_RELEASE:
+        case XCB_MOTION_NOTIFY: {
+            // Same layout for all five
+            auto input = reinterpret_cast<const xcb_key_press_event_t*>(event);
+            return input->event == root ? 0 : input->event;
+        }
+        case XCB_FOCUS_IN:
+        case XCB_FOCUS_OUT:
+            return reinterpret_cast<const xcb_focus_in_event_t*>(event)->event;
+        case XCB_ENTER_NOTIFY:
+        case XCB_LEAVE_NOTIFY:
+            return reinterpret_cast<const xcb_enter_notify_event_t*>(event)->event;
+        case XCB_CREATE_NOTIFY:
+            return reinterpret_cast<const xcb_create_notify_event_t*>(event)->window;
+        case XCB_DESTROY_NOTIFY:
+            return reinterpret_cast<const xcb_destroy_notify_event_t*>(event)->window;
+        case XCB_MAP_REQUEST:
+            return reinterpret_cast<const xcb_map_request_event_t*>(event)->window;
+        case XCB_MAP_NOTIFY:
+            return reinterpret_cast<const xcb_map_notify_event_t*>(event)->window;
+        case XCB_UNMAP_NOTIFY:
+            return reinterpret_cast<const xcb_unmap_notify_event_t*>(event)->window;
+        case XCB_CONFIGURE_REQUEST:
+            return reinterpret_cast<const xcb_configure_request_event_t*>(event)->window;
+        case XCB_CONFIGURE_NOTIFY:
+            return reinterpret_cast<const xcb_configure_notify_event_t*>(event)->window;
+        case XCB_REPARENT_NOTIFY:
+            return reinterpret_cast<const xcb_reparent_notify_event_t*>(event)->window;
+        case XCB_GRAVITY_NOTIFY:
+            return reinterpret_cast<const xcb_gravity_notify_event_t*>(event)->window;
+        case XCB_CIRCULATE_NOTIFY:
+            return reinterpret_cast<const xcb_circulate_notify_event_t*>(event)->window;
+        case XCB_PROPERTY_NOTIFY:
+            return reinterpret_cast<const xcb_property_notify_event_t*>(event)->window;
+        case XCB_CLIENT_MESSAGE:
+            return reinterpret_cast<const xcb_client_message_event_t*>(event)->window;
+        default:
+            return 0;
+    }
+}
+
+} // namespace X
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <xcb/xcb.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace X {
+
+/**
+ * @class EventBatch
+ * @brief Events drained in one go, reordered so input is handled first
+ *
+ * Each event gets a priority class: input, then focus and mapping, then
+ * configuration, then properties and everything else. Sorting by class
+ * alone could reorder events of one window (a ConfigureRequest overtaking
+ * its window's MapRequest), so an event is promoted to the best class of
+ * any later event for the same window before a stable sort.
+ *
+ * Key and pointer events delivered to the root window, which is where
+ * the window manager's grabs report them, are not tied to a window and
+ * move freely to the front.
+ */
+class EventBatch {
+public:
+    enum class Priority : uint8_t {
+        Input,
+        Focus,
+        Configure,
+        Property,
+    };
+
+    struct Entry {
+        xcb_generic_event_t* event;
+        uint64_t receivedAt;   // When the event was read, in microseconds
+        Priority priority;
+        bool ordered;          // Read in sequence order with every event before it
+    };
+
+    /**
+     * @brief Constructor
+     * @param root The root window
+     */
+    EventBatch(xcb_window_t root);
+
+    /**
+     * @brief Destructor that frees the events
+     */
+    ~EventBatch();
+
+    EventBatch(const EventBatch&) = delete;
+    EventBatch& operator=(const EventBatch&) = delete;
+
+    /**
+     * @brief Add an event, taking ownership of it
+     * @param event The event
+     * @param receivedAt When the event was read
+     * @param ordered false if the event may have overtaken older events
+     */
+    void add(xcb_generic_event_t* event, uint64_t receivedAt, bool ordered = true);
+
+    /**
+     * @brief Sort the events by priority, keeping each window's order
+     */
+    void schedule();
+
+    /**
+     * @brief Free the events and empty the batch
+     */
+    void clear();
+
+    /**
+     * @brief Get the sequence number up to which every event was seen
+     * @param sequence Receives the sequence number
+     * @return false if the batch has no ordered event
+     */
+    bool lastOrderedSequence(unsigned int& sequence) const;
+
+    /**
+     * @brief Count the events that are not input
+     * @return The number of background events
+     */
+    size_t backgroundCount() const;
+
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    std::vector<Entry>::const_iterator begin() const { return entries.begin(); }
+    std::vector<Entry>::const_iterator end() const { return entries.end(); }
+
+    /**
+     * @brief Get the priority class of an event
+     * @param event The event
+     * @return The priority class
+     */
+    static Priority classify(const xcb_generic_event_t* event);
+
+private:
+    xcb_window_t root;
+    std::vector<Entry> entries;
+    std::unordered_map<xcb_window_t, Priority> laterBest;   // Reused by schedule()
+
+    /**
+     * @brief Get the window whose events must stay in order with this one
+     * @param event The event
+     * @return The window, or 0 if the event is not tied to one
+     */
+    xcb_window_t windowOf(const xcb_generic_event_t* event) const;
+};
+
+} // namespace X
@@ -7,27 +7,205 @@
 namespace X {
 
 EventHandler::EventHandler(X& system)
-    : system(system) {
+    : system(system),
+      batch(system.getConnection().getRootWindow()),
+      prioritized(true),
+      quietKeyStats("Key press latency"),
+      stormKeyStats("Key press latency (event storm)"),
+      prefetchedMapStats("Map request (prefetched)"),
+      coldMapStats("Map request (no prefetch)"),
+      titleFetches(0), titleCoalesced(0), titleIgnored(0) {
     Logger::debug("Event handler initialized");
 }
 
-void EventHandler::processNextEvent() {
-    xcb_generic_event_t* event = xcb_wait_for_event(system.getConnection().getConnection());
+EventHandler::~EventHandler() {
+    if (quietKeyStats.count()) {
+        Logger::info(quietKeyStats.summary());
+    }
+    if (stormKeyStats.count()) {
+        Logger::info(stormKeyStats.summary());
+    }
+    if (prefetchedMapStats.count()) {
+        Logger::info(prefetchedMapStats.summary());
+    }
+    if (coldMapStats.count()) {
+        Logger::info(coldMapStats.summary());
+    }
+    if (titleFetches) {
+        Logger::info("Title changes: " + std::to_string(titleFetches) + " read, " +
+                     std::to_string(titleCoalesced) + " coalesced, " +
+                     std::to_string(titleIgnored) + " WM_NAME ignored");
+    }
+}
+
+void EventHandler::processPendingEvents() {
+    xcb_connection_t* conn = system.getConnection().getConnection();
+    
+    AsyncRequests& async = system.getConnection().getAsync();
+    
+    // Handlers may read more events into XCB's queue while waiting for
+    // replies, and resumed coroutines may do the same, so keep going
+    // until the queue, the socket and the ready replies are all exhausted
+    do {
+        while (fillBatch()) {
+            runBatch();
+        }
+    } while (async.resumeReady() > 0);
     
-    if (!event) {
+    // Control socket requests act in the same pass as the X events, so
+    // a burst of them costs one relayout and one flush
+    if (IpcServer* ipc = system.getIpc()) {
+        ipc->dispatch();
+    }
+    
+    finishLayout();
+    
+    IoThread* ioThread = system.getIoThread();
+    if (xcb_connection_has_error(conn) || (ioThread && ioThread->hasFailed())) {
         Logger::warning("Failed to get next event, connection might be broken");
         system.terminate();
-        return;
     }
+}
+
+bool EventHandler::fillBatch() {
+    if (IoThread* ioThread = system.getIoThread()) {
+        // Input may overtake older events in its own lane
+        QueuedEvent queued;
+        while (batch.size() < kMaxBatch && ioThread->pop(queued)) {
+            batch.add(queued.event, queued.receivedAt, !queued.input);
+        }
+        return !batch.empty();
+    }
+    
+    xcb_connection_t* conn = system.getConnection().getConnection();
+    uint64_t now = LatencyStats::nowMicros();
+    while (batch.size() < kMaxBatch) {
+        xcb_generic_event_t* event = xcb_poll_for_event(conn);
+        if (!event) {
+            break;
+        }
+        batch.add(event, now);
+    }
+    return !batch.empty();
+}
+
+void EventHandler::runBatch() {
+    if (prioritized) {
+        batch.schedule();
+    }
+    LatencyStats& keyStats = batch.backgroundCount() >= kStormSize ? stormKeyStats : quietKeyStats;
+    
+    for (const auto& entry : batch) {
+        processNextEvent(entry.event);
+        if ((entry.event->response_type & ~0x80) == XCB_KEY_PRESS) {
+            keyStats.record(LatencyStats::nowMicros() - entry.receivedAt);
+        }
+    }
+    
+    // Requests older than every event read in order can no longer fail
+    unsigned int sequence;
+    if (batch.lastOrderedSequence(sequence)) {
+        system.getConnection().getErrors().retire(sequence);
+    }
+    batch.clear();
+}
+
+void EventHandler::finishLayout() {
+    WorkspaceManager& workspaces = system.getWorkspaces();
+    
+    // Monitors are read again once per pass however many RandR
+    // notifications came in; only affected workspaces are resized
+    MonitorManager& monitors = system.getMonitors();
+    IpcEvents* events = system.getIpcEvents();
+    if (monitors.takeStale() && monitors.refresh()) {
+        workspaces.setMonitors(monitors.getMonitors());
+        if (events) {
+            events->monitorsChanged();
+        }
+    }
+    
+    // One relayout for everything that changed in this pass
+    relaidOut.clear();
+    workspaces.apply(events ? &relaidOut : nullptr);
+    if (events) {
+        events->layout(relaidOut);
+    }
+    
+    // New clients are mapped after their configure requests were queued,
+    // so they appear in their tile rather than where they asked to be;
+    // a client moved to a hidden workspace meanwhile stays unmapped
+    Client* newest = nullptr;
+    for (xcb_window_t window : mapQueue) {
+        Client* client = system.getClients().find(window);
+        if (client && workspaces.isVisible(client)) {
+            workspaces.show(client);
+            newest = client;
+        }
+    }
+    mapQueue.clear();
     
+    if (newest) {
+        workspaces.focus(newest);
+    }
+    
+    // Titles are read once per pass however often they changed in it
+    Connection& connection = system.getConnection();
+    for (xcb_window_t window : titleQueue) {
+        titleFetches++;
+        refreshTitle(window, connection.requestWindowTitle(window));
+    }
+    titleQueue.clear();
+    
+    // Windows stacked by others may have come between the layers
+    system.getStack().restore();
+    
+    // Root properties for pagers, at most one write each per pass
+    system.getEwmh().flush();
+    
+    // Likewise for status bars on the control socket
+    if (events) {
+        events->flush();
+    }
+    
+    // Queries of this pass see its outcome, including their own commands
+    if (StatePublisher* state = system.getState()) {
+        state->publish();
+        system.getIpc()->runQueries();
+    }
+}
+
+bool EventHandler::releaseClient(xcb_window_t window, bool destroyed) {
+    Client* client = system.getClients().find(window);
+    if (!client) {
+        return false;
+    }
+    system.getWorkspaces().remove(client);
+    system.getEwmh().remove(window);
+    titleQueue.erase(window);
+    return system.getClients().unmanage(window, destroyed);
+}
+
+void EventHandler::processNextEvent(xcb_generic_event_t* event) {
     // Get the event type, masking out the high bits
     uint8_t eventType = event->response_type & ~0x80;
     
     // Process the event based on its type
     switch (eventType) {
+        case 0: {
+            // Errors of unchecked requests arrive in the event stream
+            auto error = reinterpret_cast<xcb_generic_error_t*>(event);
+            system.getConnection().getErrors().handle(error);
+            break;
+        }
+        case XCB_CREATE_NOTIFY: {
+            auto createEvent = reinterpret_cast<xcb_create_notify_event_t*>(event);
+            handleCreateNotify(createEvent);
+            break;
+        }
         case XCB_MAP_REQUEST: {
+            // Copied: the handler may outlive the event while it awaits replies
             auto mapEvent = reinterpret_cast<xcb_map_request_event_t*>(event);
-            handleMapRequest(mapEvent);
+            handleMapRequest(*mapEvent);
             break;
         }
         case XCB_CONFIGURE_REQUEST: {
@@ -35,21 +213,46 @@ void EventHandler::processNextEvent() {
             handleConfigureRequest(configEvent);
             break;
         }
+        case XCB_CONFIGURE_NOTIFY: {
+            auto configEvent = reinterpret_cast<xcb_configure_notify_event_t*>(event);
+            handleConfigureNotify(configEvent);
+            break;
+        }
+        case XCB_MAP_NOTIFY: {
+            auto mapEvent = reinterpret_cast<xcb_map_notify_event_t*>(event);
+            handleMapNotify(mapEvent);
+            break;
+        }
         case XCB_UNMAP_NOTIFY: {
             auto unmapEvent = reinterpret_cast<xcb_unmap_notify_event_t*>(event);
             handleUnmapNotify(unmapEvent);
             break;
         }
+        case XCB_REPARENT_NOTIFY: {
+            auto reparentEvent = reinterpret_cast<xcb_reparent_notify_event_t*>(event);
+            handleReparentNotify(reparentEvent);
+            break;
+        }
         case XCB_DESTROY_NOTIFY: {
             auto destroyEvent = reinterpret_cast<xcb_destroy_notify_event_t*>(event);
             handleDestroyNotify(destroyEvent);
             break;
         }
+        case XCB_PROPERTY_NOTIFY: {
+            auto propertyEvent = reinterpret_cast<xcb_property_notify_event_t*>(event);
+            handlePropertyNotify(propertyEvent);
+            break;
+        }
         case XCB_KEY_PRESS: {
             auto keyEvent = reinterpret_cast<xcb_key_press_event_t*>(event);
             handleKeyPress(keyEvent);
             break;
         }
+        case XCB_KEY_RELEASE: {
+            auto keyEvent = reinterpret_cast<xcb_key_release_event_t*>(event);
+            handleKeyRelease(keyEvent);
+            break;
+        }
         case XCB_BUTTON_PRESS: {
             auto buttonEvent = reinterpret_cast<xcb_button_press_event_t*>(event);
             handleButtonPress(buttonEvent);
@@ -66,46 +269,110 @@ void EventHandler::processNextEvent() {
             break;
         }
         default:
+            if (system.getDrag().handleEvent(event) || system.getMonitors().handleEvent(event)) {
+                break;
+            }
             // Log unhandled event types for debugging
             Logger::debug("Unhandled event type: " + std::to_string(eventType));
             break;
     }
+}
+
+void EventHandler::handleCreateNotify(xcb_create_notify_event_t* event) {
+    if (event->parent != system.getConnection().getRootWindow()) {
+        return;
+    }
+    system.getStack().add(event->window,
+                          event->override_redirect ? StackingOrder::Layer::OverrideRedirect
+                                                   : StackingOrder::Layer::Normal,
+                          false);
+    
+    // Only top-level windows can become clients; override-redirect
+    // windows (menus, tooltips) never send a MapRequest
+    if (event->override_redirect) {
+        return;
+    }
     
-    // Free the event
-    free(event);
+    // Ask for everything the MapRequest will need while the client is
+    // still busy setting up its window
+    system.getClients().prefetch(event->window);
 }
 
-void EventHandler::handleMapRequest(xcb_map_request_event_t* event) {
-    Logger::debug("Map request for window: " + std::to_string(event->window));
+Task EventHandler::handleMapRequest(xcb_map_request_event_t event) {
+    Logger::debug("Map request for window: " + std::to_string(event.window));
+    
+    Connection& connection = system.getConnection();
+    ClientManager& clients = system.getClients();
+    uint64_t start = LatencyStats::nowMicros();
+    
+    // Use the requests sent on CreateNotify if there are any
+    PendingClient pending;
+    bool prefetched = clients.takePrefetch(event.window, pending);
+    if (!prefetched) {
+        pending.query = Window::queryManage(connection, event.window);
+    }
+    
+    // Match the window to a process we launched, only while one is pending
+    bool wantPid = system.getChildTracker().awaitingWindow();
+    if (wantPid && !prefetched) {
+        pending.pid = connection.requestWindowPid(event.window);
+    } else if (!wantPid && prefetched) {
+        xcb_discard_reply(connection.getConnection(), pending.pid.sequence);
+    }
+    
+    // Other events keep being handled while the replies are outstanding;
+    // a DestroyNotify in the meantime cancels the mapping
+    clients.beginMapping(event.window);
+    
+    uint32_t pid = 0;
+    if (wantPid) {
+        auto reply = co_await connection.getAsync().reply(pending.pid);
+        pid = Connection::parseWindowPid(reply.get());
+    }
+    Window::ManageInfo info = co_await Window::readManageAsync(connection, pending.query);
+    
+    if (!clients.endMapping(event.window)) {
+        Logger::debug("Window destroyed before it could be mapped: " + std::to_string(event.window));
+        co_return;
+    }
+    
+    if (pid) {
+        system.getChildTracker().windowMapped(pid, event.window);
+    }
     
     // Check if we should manage this window
-    if (Window::shouldManage(system.getConnection(), event->window)) {
-        // Create a window object for the new window
-        auto window = new Window(system.getConnection(), event->window);
-        
-        // Set border width and color
-        window->setBorderWidth(2);
-        window->setBorderColor(0x3388FF); // Blue border for managed windows
-        
-        // Map the window
-        window->map();
-        
-        // Focus the new window
-        window->focus();
+    if (info.shouldManage(false)) {
+        // Create a client for the new window, tiled or floating as the
+        // rules and its type say; it is mapped and focused after the relayout
+        system.manageClient(event.window, info, false);
+        mapQueue.push_back(event.window);
         
-        Logger::info("New window managed: " + std::to_string(event->window));
+        Logger::info("New window managed: " + std::to_string(event.window));
     } else {
         // Just map the window without managing it
-        xcb_map_window(system.getConnection().getConnection(), event->window);
-        system.getConnection().flush();
+        connection.track(
+            xcb_map_window(connection.getConnection(), event.window),
+            ErrorTracker::Request::MapWindow, event.window);
+        connection.flush();
         
-        Logger::debug("Window mapped but not managed: " + std::to_string(event->window));
+        Logger::debug("Window mapped but not managed: " + std::to_string(event.window));
     }
+    
+    uint64_t elapsed = LatencyStats::nowMicros() - start;
+    (prefetched ? prefetchedMapStats : coldMapStats).record(elapsed);
 }
 
 void EventHandler::handleConfigureRequest(xcb_configure_request_event_t* event) {
     Logger::debug("Configure request for window: " + std::to_string(event->window));
     
+    // A managed client sits at the origin of its frame, so its request
+    // is never applied to the client window as is
+    Client* client = system.getClients().find(event->window);
+    if (client) {
+        handleClientConfigureRequest(client, event);
+        return;
+    }
+    
     // Prepare values to be configured
     uint16_t mask = event->value_mask;
     uint32_t values[7];
@@ -134,28 +401,157 @@ void EventHandler::handleConfigureRequest(xcb_configure_request_event_t* event)
     }
     
     // Apply the configuration
-    xcb_configure_window(
+    auto cookie = xcb_configure_window(
         system.getConnection().getConnection(),
         event->window,
         mask,
         values
     );
+    system.getConnection().track(cookie, ErrorTracker::Request::ConfigureWindow, event->window);
+    
+    system.getConnection().flush();
+}
+
+void EventHandler::handleClientConfigureRequest(Client* client,
+                                                const xcb_configure_request_event_t* event) {
+    // Tiled clients keep their tile; ICCCM asks for a synthetic
+    // ConfigureNotify so the client learns its real geometry. One that
+    // has not been placed yet gets its tile in this pass
+    if (!client->isFloating()) {
+        if (client->isPlaced()) {
+            client->sendConfigureNotify();
+        }
+        return;
+    }
     
+    // Floating clients get the geometry they ask for, given in root
+    // coordinates of the client window
+    unsigned int border = system.getWorkspaces().getBorderWidth();
+    Rect rect = client->getGeometry();
+    if (event->value_mask & XCB_CONFIG_WINDOW_X) {
+        rect.x = event->x - static_cast<int>(border);
+    }
+    if (event->value_mask & XCB_CONFIG_WINDOW_Y) {
+        rect.y = event->y - static_cast<int>(border);
+    }
+    if (event->value_mask & XCB_CONFIG_WINDOW_WIDTH) {
+        rect.width = event->width + 2 * border;
+    }
+    if (event->value_mask & XCB_CONFIG_WINDOW_HEIGHT) {
+        rect.height = event->height + 2 * border;
+    }
+    if (!client->place(rect, border)) {
+        client->sendConfigureNotify();
+    }
     system.getConnection().flush();
 }
 
+void EventHandler::handleConfigureNotify(xcb_configure_notify_event_t* event) {
+    // Only the stacking of the root window's children is of interest
+    if (event->event == system.getConnection().getRootWindow()) {
+        system.getStack().restacked(event->window, event->above_sibling);
+    }
+}
+
+void EventHandler::handleMapNotify(xcb_map_notify_event_t* event) {
+    if (event->event == system.getConnection().getRootWindow()) {
+        system.getStack().setMapped(event->window, true);
+    }
+}
+
 void EventHandler::handleUnmapNotify(xcb_unmap_notify_event_t* event) {
     Logger::debug("Unmap notify for window: " + std::to_string(event->window));
     
-    // Handle window unmapping
-    // In a more complete implementation, we would remove the window from our managed windows list
+    if (event->event == system.getConnection().getRootWindow()) {
+        system.getStack().setMapped(event->window, false);
+    }
+    
+    // Reparenting a mapped window into its frame unmaps it; those
+    // notifications were counted when the client was adopted. Hiding a
+    // workspace only unmaps frames, which are not clients. A synthetic
+    // UnmapNotify is always a withdrawal (ICCCM 4.1.4)
+    bool synthetic = event->response_type & 0x80;
+    Client* client = system.getClients().find(event->window);
+    if (client && !synthetic && client->consumeUnmap()) {
+        return;
+    }
+    
+    // The client withdrew its window
+    if (releaseClient(event->window)) {
+        Logger::info("Window unmanaged: " + std::to_string(event->window));
+    }
+}
+
+void EventHandler::handleReparentNotify(xcb_reparent_notify_event_t* event) {
+    // Windows leave the root window for their frames and come back when
+    // they are released
+    xcb_window_t root = system.getConnection().getRootWindow();
+    if (event->event != root) {
+        return;
+    }
+    if (event->parent == root) {
+        system.getStack().add(event->window,
+                              event->override_redirect ? StackingOrder::Layer::OverrideRedirect
+                                                       : StackingOrder::Layer::Normal,
+                              false);
+    } else {
+        system.getStack().remove(event->window);
+    }
 }
 
 void EventHandler::handleDestroyNotify(xcb_destroy_notify_event_t* event) {
     Logger::debug("Destroy notify for window: " + std::to_string(event->window));
     
-    // Handle window destruction
-    // In a more complete implementation, we would remove the window from our managed windows list
+    system.getStack().remove(event->window);
+    
+    // Drop anything still held for the window
+    system.getClients().discardPrefetch(event->window);
+    system.getClients().cancelMapping(event->window);
+    if (releaseClient(event->window, true)) {
+        Logger::info("Window unmanaged: " + std::to_string(event->window));
+    }
+}
+
+void EventHandler::handlePropertyNotify(xcb_property_notify_event_t* event) {
+    Connection& connection = system.getConnection();
+    Client* client = system.getClients().find(event->window);
+    if (!client) {
+        // The window may not be mapped yet; keep its prefetch current
+        system.getClients().refreshPrefetch(event->window, event->atom);
+        return;
+    }
+    bool netName = event->atom == connection.getAtom("_NET_WM_NAME");
+    if (!netName && event->atom != XCB_ATOM_WM_NAME) {
+        return;
+    }
+    
+    // Clients setting both names change both at once; the UTF-8 one wins
+    if (!netName && client->hasNetTitle()) {
+        titleIgnored++;
+        return;
+    }
+    if (!titleQueue.insert(event->window).second) {
+        titleCoalesced++;
+    }
+}
+
+Task EventHandler::refreshTitle(xcb_window_t window, Connection::TitleQuery query) {
+    AsyncRequests& async = system.getConnection().getAsync();
+    auto name = co_await async.reply(query.name);
+    auto legacyName = co_await async.reply(query.legacyName);
+    
+    // The client may have gone while the replies were outstanding
+    Client* client = system.getClients().find(window);
+    if (!client) {
+        co_return;
+    }
+    bool net = Connection::parseWindowTitle(name.get(), legacyName.get(), titleBuffer);
+    if (system.getClients().setTitle(client, titleBuffer, net)) {
+        Logger::debug("Title of window " + std::to_string(window) + ": " + titleBuffer);
+        if (IpcEvents* events = system.getIpcEvents()) {
+            events->title(client);
+        }
+    }
 }
 
 void EventHandler::handleKeyPress(xcb_key_press_event_t* event) {
@@ -173,22 +569,17 @@ void EventHandler::handleKeyPress(xcb_key_press_event_t* event) {
     
     Logger::info(ss.str());
     
-    // Handle keyboard shortcuts
-    // Example: Alt+F4 to close a window
-    if (event->detail == 70 && (event->state & XCB_MOD_MASK_1)) {
-        Logger::info("Alt+F4 pressed - Attempting to close window");
-        
-        // In a real implementation, we would send a close request to the window
-        // For now, just log the action
-    }
-    
-    // Example: Alt+Tab to switch windows
-    if (event->detail == 23 && (event->state & XCB_MOD_MASK_1)) {
-        Logger::info("Alt+Tab pressed - Switching windows");
-        
-        // In a real implementation, we would cycle through managed windows
-        // For now, just log the action
+    // An Alt+Tab cycle sees keys first, then the shortcut bound to the
+    // key runs, if any
+    if (system.getSwitcher().handleKeyPress(event)) {
+        return;
     }
+    system.getKeyboardHandler().handleKeyPress(event);
+}
+
+void EventHandler::handleKeyRelease(xcb_key_release_event_t* event) {
+    // Only the end of an Alt+Tab cycle cares about releases
+    system.getSwitcher().handleKeyRelease(event);
 }
 
 void EventHandler::handleButtonPress(xcb_button_press_event_t* event) {
@@ -206,28 +597,39 @@ void EventHandler::handleButtonPress(xcb_button_press_event_t* event) {
     
     Logger::info(ss.str());
     
+    // Alt+drag on a client
+    if (system.getDrag().begin(event)) {
+        return;
+    }
+    
     // Handle mouse button events
     switch (event->detail) {
         case 1: { // Left button
             Logger::info("Left mouse button pressed on window 0x" + 
                         std::to_string(event->event));
             
-            // Focus the clicked window
-            xcb_set_input_focus(
+            // Focus and raise the clicked window
+            Client* client = system.getClients().find(event->event);
+            if (!client) {
+                client = system.getClients().findByFrame(event->event);
+            }
+            if (client) {
+                system.getWorkspaces().focus(client);
+                break;
+            }
+            
+            auto focusCookie = xcb_set_input_focus(
                 system.getConnection().getConnection(),
                 XCB_INPUT_FOCUS_POINTER_ROOT,
                 event->event,
                 XCB_CURRENT_TIME
             );
+            system.getConnection().track(focusCookie, ErrorTracker::Request::SetInputFocus,
+                                         event->event);
             
-            // Raise the window to the top
-            uint32_t values[1] = { XCB_STACK_MODE_ABOVE };
-            xcb_configure_window(
-                system.getConnection().getConnection(),
-                event->event,
-                XCB_CONFIG_WINDOW_STACK_MODE,
-                values
-            );
+            // Raise the window to the top of its layer, if it is not there
+            // already
+            system.getStack().raise(event->event);
             
             system.getConnection().flush();
             break;
@@ -279,9 +681,19 @@ void EventHandler::handleButtonRelease(xcb_button_release_event_t* event) {
        << ", event_y=" << event->event_y;
     
     Logger::info(ss.str());
+    
+    // Place a dragged client for good
+    system.getDrag().end();
 }
 
 void EventHandler::handleMotionNotify(xcb_motion_notify_event_t* event) {
+    // During a drag motion only updates the pointer position; the frame
+    // timer configures the client
+    if (system.getDrag().isActive()) {
+        system.getDrag().motion(event);
+        return;
+    }
+    
     // Motion events can be very frequent, so we might want to log them at DEBUG level
     // or only log them when certain conditions are met
     
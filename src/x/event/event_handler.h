@@ -1,6 +1,10 @@
 #pragma once
 #include <xcb/xcb.h>
+#include <unordered_set>
+#include <vector>
 #include "../x.h"
+#include "event_batch.h"
+#include "../../log/latency_stats.h"
 
 namespace X {
 
@@ -9,16 +13,89 @@ class X;
 class EventHandler {
 public:
     EventHandler(X& system);
-    void processNextEvent();
+    ~EventHandler();
+    
+    /**
+     * @brief Handle every event that can be read without blocking
+     */
+    void processPendingEvents();
+    
+    /**
+     * @brief Enable or disable input-first ordering of event batches
+     * @param enabled false to handle events in arrival order
+     */
+    void setPrioritized(bool enabled) { prioritized = enabled; }
     
 private:
+    static constexpr size_t kMaxBatch = 256;    // Events drained before handling starts
+    static constexpr size_t kStormSize = 64;    // Background events that make a batch a storm
+    
     X& system;
+    EventBatch batch;
+    bool prioritized;
+    std::vector<xcb_window_t> mapQueue;   // New clients mapped after the next relayout
+    LatencyStats quietKeyStats;        // Key press read to handled, ordinary batches
+    LatencyStats stormKeyStats;        // The same inside a storm of background events
+    LatencyStats prefetchedMapStats;   // MapRequest handling time with prefetched replies
+    LatencyStats coldMapStats;         // MapRequest handling time without
+    std::unordered_set<xcb_window_t> titleQueue;   // Clients whose title changed in this pass
+    std::string titleBuffer;                       // Reused for every title read
+    std::vector<unsigned int> relaidOut;           // Workspaces whose clients moved in this pass
+    uint64_t titleFetches;     // Titles read after a change
+    uint64_t titleCoalesced;   // Changes folded into a read already queued
+    uint64_t titleIgnored;     // WM_NAME changes of clients that have _NET_WM_NAME
+    
+    /**
+     * @brief Read the events that are available into the batch
+     * @return true if the batch is not empty
+     */
+    bool fillBatch();
+    
+    /**
+     * @brief Handle the batch in priority order and empty it
+     */
+    void runBatch();
+    
+    /**
+     * @brief Apply the layout, then map the clients managed since the last call
+     */
+    void finishLayout();
+    
+    /**
+     * @brief Stop managing a window and give its space to the others
+     * @param window The window ID
+     * @param destroyed Whether the window no longer exists
+     * @return true if the window was managed, false otherwise
+     */
+    bool releaseClient(xcb_window_t window, bool destroyed = false);
+    
+    /**
+     * @brief Handle a configure request of a managed client
+     * @param client The client
+     * @param event The configure request event
+     */
+    void handleClientConfigureRequest(Client* client, const xcb_configure_request_event_t* event);
+    
+    /**
+     * @brief Read the title of a client again
+     * @param window The client window
+     * @param query The title requests, already sent
+     */
+    Task refreshTitle(xcb_window_t window, Connection::TitleQuery query);
+    
+    void processNextEvent(xcb_generic_event_t* event);
+    void handleCreateNotify(xcb_create_notify_event_t* event);
     
-    void handleMapRequest(xcb_map_request_event_t* event);
+    Task handleMapRequest(xcb_map_request_event_t event);
     void handleConfigureRequest(xcb_configure_request_event_t* event);
+    void handleConfigureNotify(xcb_configure_notify_event_t* event);
+    void handleMapNotify(xcb_map_notify_event_t* event);
     void handleUnmapNotify(xcb_unmap_notify_event_t* event);
+    void handleReparentNotify(xcb_reparent_notify_event_t* event);
     void handleDestroyNotify(xcb_destroy_notify_event_t* event);
+    void handlePropertyNotify(xcb_property_notify_event_t* event);
     void handleKeyPress(xcb_key_press_event_t* event);
+    void handleKeyRelease(xcb_key_release_event_t* event);
     void handleButtonPress(xcb_button_press_event_t* event);
     void handleButtonRelease(xcb_button_release_event_t* event);
     void handleMotionNotify(xcb_motion_notify_event_t* event);
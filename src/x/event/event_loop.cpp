@@ -0,0 +1,85 @@
+#include "event_loop.h"
+#include "../../log/logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+
+namespace X {
+
+EventLoop::EventLoop()
+    : dispatching(false) {
+    Logger::debug("Event loop initialized");
+}
+
+void EventLoop::addWatch(int fd, std::function<void()> callback) {
+    removeWatch(fd);
+    watches.push_back({ fd, std::move(callback), true, POLLIN });
+}
+
+void EventLoop::setEvents(int fd, bool readable, bool writable) {
+    for (auto& watch : watches) {
+        if (watch.fd == fd && watch.active) {
+            watch.events = static_cast<short>((readable ? POLLIN : 0) | (writable ? POLLOUT : 0));
+        }
+    }
+}
+
+void EventLoop::removeWatch(int fd) {
+    for (auto& watch : watches) {
+        if (watch.fd == fd) {
+            watch.active = false;
+        }
+    }
+
+    // Inactive entries are compacted once no callback is running
+    if (!dispatching) {
+        compact();
+    }
+}
+
+void EventLoop::compact() {
+    watches.erase(std::remove_if(watches.begin(), watches.end(),
+                                 [](const Watch& watch) { return !watch.active; }),
+                  watches.end());
+}
+
+bool EventLoop::wait(int xfd, int timeoutMs) {
+    std::vector<pollfd> fds;
+    fds.reserve(watches.size() + 1);
+    fds.push_back({ xfd, POLLIN, 0 });
+    for (const auto& watch : watches) {
+        fds.push_back({ watch.fd, watch.events, 0 });
+    }
+
+    int ready = poll(fds.data(), fds.size(), timeoutMs);
+    if (ready < 0) {
+        if (errno != EINTR) {
+            Logger::warning(std::string("poll failed: ") + std::strerror(errno));
+        }
+        return false;
+    }
+
+    // Callbacks may add or remove watches, so work on the snapshot taken
+    // for poll and look each descriptor up again before calling it
+    dispatching = true;
+    size_t count = watches.size();
+    for (size_t i = 1; i < fds.size(); i++) {
+        if (!fds[i].revents) {
+            continue;
+        }
+        for (size_t w = 0; w < count && w < watches.size(); w++) {
+            if (watches[w].fd == fds[i].fd && watches[w].active) {
+                auto callback = watches[w].callback;
+                callback();
+                break;
+            }
+        }
+    }
+    dispatching = false;
+    compact();
+
+    return fds[0].revents != 0;
+}
+
+} // namespace X
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+namespace X {
+
+/**
+ * @class EventLoop
+ * @brief Waits on the X connection and other descriptors at once
+ *
+ * The X socket is always part of the wait. Other subsystems register
+ * descriptors with a callback that runs on the main thread when the
+ * descriptor becomes readable, so nothing besides the poll itself ever
+ * blocks the window manager.
+ */
+class EventLoop {
+public:
+    /**
+     * @brief Constructor
+     */
+    EventLoop();
+
+    /**
+     * @brief Watch a descriptor for readability
+     * @param fd The descriptor to watch
+     * @param callback The function to call when the descriptor is readable
+     */
+    void addWatch(int fd, std::function<void()> callback);
+
+    /**
+     * @brief Stop watching a descriptor
+     * @param fd The descriptor to stop watching
+     *
+     * Safe to call from a watch callback, including for the descriptor
+     * whose callback is running.
+     */
+    void removeWatch(int fd);
+
+    /**
+     * @brief Choose what a watched descriptor is polled for
+     * @param fd The watched descriptor
+     * @param readable Call back when it becomes readable
+     * @param writable Call back when it becomes writable
+     *
+     * Watches start out polled for readability only.
+     */
+    void setEvents(int fd, bool readable, bool writable);
+
+    /**
+     * @brief Wait for activity and dispatch watch callbacks
+     * @param xfd The descriptor signalling X events: the X connection, or
+     *            the I/O thread's eventfd in threaded mode
+     * @param timeoutMs Maximum time to wait in milliseconds, -1 for no limit
+     * @return true if X events are available, false otherwise
+     */
+    bool wait(int xfd, int timeoutMs = -1);
+
+private:
+    struct Watch {
+        int fd;
+        std::function<void()> callback;
+        bool active;
+        short events;   // poll() events to wait for
+    };
+
+    std::vector<Watch> watches;
+    bool dispatching;
+    
+    /**
+     * @brief Drop watches that were removed
+     */
+    void compact();
+};
+
+} // namespace X
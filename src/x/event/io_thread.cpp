@@ -0,0 +1,229 @@
+#include "io_thread.h"
+#include "event_batch.h"
+#include "../../log/logger.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace X {
+
+namespace {
+
+// Tells the marker of watchReplies() apart from the stop event
+constexpr uint32_t kReplyMarker = 1;
+
+// Runs on the I/O thread, which must not log: the logger is not
+// thread safe. A nonblocking eventfd write can only fail when the
+// counter would overflow, and then the descriptor is readable anyway
+void signalEventFd(int fd) {
+    uint64_t one = 1;
+    if (write(fd, &one, sizeof(one)) < 0) {
+        return;
+    }
+}
+
+} // namespace
+
+IoThread::IoThread(Connection& connection)
+    : connection(connection),
+      wakeupFd(-1),
+      stopWindow(0),
+      running(false),
+      sleeping(false),
+      failed(false),
+      markerSent(false),
+      repliesArrived(false),
+      fullStalls(0),
+      inputDelayStats("Input queueing delay"),
+      eventDelayStats("Event queueing delay") {
+}
+
+IoThread::~IoThread() {
+    stop();
+
+    // Events the main thread never got to
+    QueuedEvent queued;
+    while (inputRing.pop(queued) || eventRing.pop(queued)) {
+        free(queued.event);
+    }
+
+    if (wakeupFd >= 0) {
+        ::close(wakeupFd);
+    }
+
+    if (inputDelayStats.count()) {
+        Logger::info(inputDelayStats.summary());
+    }
+    if (eventDelayStats.count()) {
+        Logger::info(eventDelayStats.summary());
+    }
+    if (fullStalls) {
+        Logger::info("X I/O thread waited " + std::to_string(fullStalls.load()) + " times for a full ring");
+    }
+}
+
+bool IoThread::start() {
+    wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeupFd < 0) {
+        Logger::warning(std::string("Failed to create eventfd: ") + std::strerror(errno));
+        return false;
+    }
+
+    // xcb_wait_for_event cannot be interrupted, so stop() sends an event
+    // to this window; with an empty event mask it goes to its creator
+    xcb_connection_t* conn = connection.getConnection();
+    stopWindow = connection.generateId();
+    auto cookie = xcb_create_window(conn, XCB_COPY_FROM_PARENT, stopWindow,
+                                    connection.getRootWindow(), -1, -1, 1, 1, 0,
+                                    XCB_WINDOW_CLASS_INPUT_ONLY, XCB_COPY_FROM_PARENT,
+                                    0, nullptr);
+    connection.track(cookie, ErrorTracker::Request::CreateWindow, stopWindow);
+    connection.flush();
+
+    running.store(true, std::memory_order_release);
+    try {
+        thread = std::thread(&IoThread::readLoop, this);
+    } catch (const std::system_error& e) {
+        Logger::warning(std::string("Failed to start X I/O thread: ") + e.what());
+        running.store(false, std::memory_order_release);
+        return false;
+    }
+
+    Logger::info("X events are read on a separate thread");
+    return true;
+}
+
+void IoThread::stop() {
+    if (!thread.joinable()) {
+        return;
+    }
+
+    running.store(false, std::memory_order_release);
+
+    xcb_connection_t* conn = connection.getConnection();
+    xcb_client_message_event_t event = {};
+    event.response_type = XCB_CLIENT_MESSAGE;
+    event.format = 32;
+    event.window = stopWindow;
+    xcb_send_event(conn, 0, stopWindow, XCB_EVENT_MASK_NO_EVENT, reinterpret_cast<const char*>(&event));
+    xcb_destroy_window(conn, stopWindow);
+    connection.flush();
+
+    thread.join();
+}
+
+bool IoThread::pop(QueuedEvent& queued) {
+    if (!inputRing.pop(queued) && !eventRing.pop(queued)) {
+        return false;
+    }
+
+    uint64_t delay = LatencyStats::nowMicros() - queued.receivedAt;
+    (queued.input ? inputDelayStats : eventDelayStats).record(delay);
+    return true;
+}
+
+bool IoThread::prepareToSleep() {
+    sleeping.store(true, std::memory_order_seq_cst);
+
+    // Pairs with the fence in wakeup(): either the reader sees the flag
+    // and writes the eventfd, or this check sees its event
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!inputRing.empty() || !eventRing.empty() || failed.load(std::memory_order_acquire) ||
+        repliesArrived.exchange(false, std::memory_order_acquire)) {
+        sleeping.store(false, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void IoThread::acknowledgeWakeup() {
+    sleeping.store(false, std::memory_order_relaxed);
+
+    uint64_t count;
+    while (read(wakeupFd, &count, sizeof(count)) == sizeof(count)) {
+    }
+}
+
+void IoThread::watchReplies() {
+    if (markerSent.exchange(true, std::memory_order_relaxed)) {
+        return;
+    }
+
+    // Nobody selects events on the window, so it comes back to us
+    xcb_client_message_event_t event = {};
+    event.response_type = XCB_CLIENT_MESSAGE;
+    event.format = 32;
+    event.window = stopWindow;
+    event.data.data32[0] = kReplyMarker;
+    xcb_send_event(connection.getConnection(), 0, stopWindow, XCB_EVENT_MASK_NO_EVENT,
+                   reinterpret_cast<const char*>(&event));
+}
+
+bool IoThread::isInputEvent(const xcb_generic_event_t* event) {
+    return EventBatch::classify(event) == EventBatch::Priority::Input;
+}
+
+void IoThread::readLoop() {
+    xcb_connection_t* conn = connection.getConnection();
+
+    while (running.load(std::memory_order_acquire)) {
+        xcb_generic_event_t* event = xcb_wait_for_event(conn);
+        if (!event) {
+            // The connection is broken; let the main thread notice
+            failed.store(true, std::memory_order_release);
+            signalEventFd(wakeupFd);
+            break;
+        }
+
+        if (!running.load(std::memory_order_acquire)) {
+            free(event);
+            break;
+        }
+
+        if ((event->response_type & ~0x80) == XCB_CLIENT_MESSAGE) {
+            auto message = reinterpret_cast<xcb_client_message_event_t*>(event);
+            if (message->window == stopWindow && message->data.data32[0] == kReplyMarker) {
+                free(event);
+                markerSent.store(false, std::memory_order_relaxed);
+                repliesArrived.store(true, std::memory_order_release);
+                wakeup();
+                continue;
+            }
+        }
+
+        enqueue({ event, LatencyStats::nowMicros(), isInputEvent(event) });
+    }
+}
+
+void IoThread::enqueue(const QueuedEvent& queued) {
+    auto push = [&]() {
+        return queued.input ? inputRing.push(queued) : eventRing.push(queued);
+    };
+
+    if (!push()) {
+        // The main thread is awake with a full ring to work through; wait
+        // for room instead of dropping events
+        fullStalls.fetch_add(1, std::memory_order_relaxed);
+        do {
+            if (!running.load(std::memory_order_acquire)) {
+                free(queued.event);
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        } while (!push());
+    }
+
+    wakeup();
+}
+
+void IoThread::wakeup() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.exchange(false, std::memory_order_seq_cst)) {
+        signalEventFd(wakeupFd);
+    }
+}
+
+} // namespace X
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "spsc_ring.h"
+#include "../connection/connection.h"
+#include "../../log/latency_stats.h"
+#include <xcb/xcb.h>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace X {
+
+/**
+ * @struct QueuedEvent
+ * @brief An X event together with the time the I/O thread read it
+ */
+struct QueuedEvent {
+    xcb_generic_event_t* event;
+    uint64_t receivedAt;
+    bool input;   // Taken from the input lane, possibly ahead of older events
+};
+
+/**
+ * @class IoThread
+ * @brief Reads the X socket on its own thread
+ *
+ * Keeps the socket drained while the main thread is busy handling
+ * events, and stamps every event with its arrival time so the real
+ * queueing delay can be measured. Events are handed over through two
+ * bounded SPSC rings: one for keyboard and pointer input, which the
+ * handler always empties first, and one for everything else.
+ *
+ * The main thread sleeps on an eventfd that the I/O thread only writes
+ * when the main thread announced that it is about to sleep.
+ *
+ * Replies are read by the same thread, but xcb_wait_for_event() does not
+ * return for them. A coroutine waiting on one is woken by an event the
+ * window manager sends itself after the request: the server answers in
+ * order, so once that event is read the reply is in as well.
+ */
+class IoThread {
+public:
+    /**
+     * @brief Constructor
+     * @param connection The X connection
+     */
+    IoThread(Connection& connection);
+
+    /**
+     * @brief Destructor that stops the thread and frees queued events
+     */
+    ~IoThread();
+
+    IoThread(const IoThread&) = delete;
+    IoThread& operator=(const IoThread&) = delete;
+
+    /**
+     * @brief Start reading events
+     * @return true if the thread was started, false otherwise
+     */
+    bool start();
+
+    /**
+     * @brief Stop reading events and join the thread
+     */
+    void stop();
+
+    /**
+     * @brief Take the next event, input first (main thread only)
+     * @param queued Receives the event, which the caller must free
+     * @return false if no event is queued
+     */
+    bool pop(QueuedEvent& queued);
+
+    /**
+     * @brief Announce that the main thread is about to sleep
+     * @return false if events arrived meanwhile and sleeping would miss them
+     */
+    bool prepareToSleep();
+
+    /**
+     * @brief Consume the wakeup after the main thread woke up
+     */
+    void acknowledgeWakeup();
+
+    /**
+     * @brief Have the main thread woken once the replies requested so far are in
+     *
+     * Sends a marker event unless one is already on its way; the caller
+     * flushes. Main thread only.
+     */
+    void watchReplies();
+
+    /**
+     * @brief Get the descriptor the main thread sleeps on
+     * @return The eventfd signalled when events are queued
+     */
+    int getWakeupFd() const { return wakeupFd; }
+
+    /**
+     * @brief Check if the connection failed while reading
+     * @return true if the X connection is broken
+     */
+    bool hasFailed() const { return failed.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Check if an event belongs in the input lane
+     * @param event The event
+     * @return true for keyboard and pointer events
+     */
+    static bool isInputEvent(const xcb_generic_event_t* event);
+
+private:
+    static constexpr size_t kInputCapacity = 1024;
+    static constexpr size_t kEventCapacity = 4096;
+
+    Connection& connection;
+    std::thread thread;
+    int wakeupFd;
+    xcb_window_t stopWindow;   // Target of the event that unblocks the reader
+    std::atomic<bool> running;
+    std::atomic<bool> sleeping;
+    std::atomic<bool> failed;
+    std::atomic<bool> markerSent;       // A watchReplies() event is on its way
+    std::atomic<bool> repliesArrived;   // The marker came back since the last sleep
+    SpscRing<QueuedEvent, kInputCapacity> inputRing;
+    SpscRing<QueuedEvent, kEventCapacity> eventRing;
+    std::atomic<uint64_t> fullStalls;   // Times the reader waited for a full ring
+    LatencyStats inputDelayStats;       // Arrival to handling, input lane
+    LatencyStats eventDelayStats;       // Arrival to handling, other events
+
+    /**
+     * @brief Body of the I/O thread
+     */
+    void readLoop();
+
+    /**
+     * @brief Queue an event, waiting while its ring is full
+     * @param queued The event
+     */
+    void enqueue(const QueuedEvent& queued);
+
+    /**
+     * @brief Wake the main thread if it is sleeping
+     */
+    void wakeup();
+};
+
+} // namespace X
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace X {
+
+/**
+ * @class SpscRing
+ * @brief Bounded lock-free queue for one producer and one consumer thread
+ *
+ * The producer only writes the head index and the consumer only writes
+ * the tail index, so each side needs a single acquire load and release
+ * store per operation. The indices live on separate cache lines to keep
+ * the two threads from invalidating each other's line on every event.
+ *
+ * @tparam T The element type
+ * @tparam Capacity Number of slots, must be a power of two
+ */
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    SpscRing() : head(0), tail(0) {}
+
+    /**
+     * @brief Append an element (producer thread only)
+     * @param value The element
+     * @return false if the ring is full
+     */
+    bool push(const T& value) {
+        size_t currentHead = head.load(std::memory_order_relaxed);
+        if (currentHead - tail.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        slots[currentHead & (Capacity - 1)] = value;
+        head.store(currentHead + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Remove the oldest element (consumer thread only)
+     * @param value Receives the element
+     * @return false if the ring is empty
+     */
+    bool pop(T& value) {
+        size_t currentTail = tail.load(std::memory_order_relaxed);
+        if (currentTail == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = slots[currentTail & (Capacity - 1)];
+        tail.store(currentTail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Check if the ring is empty (either thread)
+     * @return true if no element is queued
+     */
+    bool empty() const {
+        return tail.load(std::memory_order_acquire) == head.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+    alignas(64) std::array<T, Capacity> slots;
+};
+
+} // namespace X
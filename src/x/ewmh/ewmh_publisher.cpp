@@ -0,0 +1,164 @@
+#include "ewmh_publisher.h"
+#include "../../log/logger.h"
+#include <algorithm>
+#include <string>
+
+namespace X {
+
+namespace {
+
+const char* const kSupported[] = {
+    "_NET_SUPPORTED",
+    "_NET_SUPPORTING_WM_CHECK",
+    "_NET_CLIENT_LIST",
+    "_NET_CLIENT_LIST_STACKING",
+    "_NET_ACTIVE_WINDOW",
+    "_NET_NUMBER_OF_DESKTOPS",
+    "_NET_CURRENT_DESKTOP",
+    "_NET_WM_NAME",
+};
+
+const char kName[] = "doowm";
+
+} // namespace
+
+EwmhPublisher::EwmhPublisher(Connection& connection, ClientManager& clients,
+                             WorkspaceManager& workspaces, StackingOrder& stack)
+    : connection(connection),
+      clients(clients),
+      workspaces(workspaces),
+      stack(stack),
+      checkWindow(XCB_NONE),
+      stackVersion(0),
+      stackingDirty(true),
+      publishedActive(XCB_NONE),
+      publishedDesktop(0),
+      initial(true),
+      writes(0),
+      appends(0),
+      replaces(0) {
+    std::vector<std::string> names(std::begin(kSupported), std::end(kSupported));
+    names.push_back("UTF8_STRING");
+    connection.prefetchAtoms(names);
+
+    // Pagers find the window manager through a window of its own that
+    // names it and points to itself
+    xcb_connection_t* conn = connection.getConnection();
+    xcb_window_t root = connection.getRootWindow();
+    checkWindow = connection.generateId();
+    uint32_t values[1] = { 1 };
+    auto cookie = xcb_create_window(conn, XCB_COPY_FROM_PARENT, checkWindow, root,
+                                    -1, -1, 1, 1, 0, XCB_WINDOW_CLASS_INPUT_ONLY,
+                                    XCB_COPY_FROM_PARENT, XCB_CW_OVERRIDE_REDIRECT, values);
+    connection.track(cookie, ErrorTracker::Request::CreateWindow, checkWindow);
+
+    xcb_atom_t check = connection.getAtom("_NET_SUPPORTING_WM_CHECK");
+    cookie = xcb_change_property(conn, XCB_PROP_MODE_REPLACE, checkWindow, check,
+                                 XCB_ATOM_WINDOW, 32, 1, &checkWindow);
+    connection.track(cookie, ErrorTracker::Request::ChangeProperty, checkWindow);
+    cookie = xcb_change_property(conn, XCB_PROP_MODE_REPLACE, checkWindow,
+                                 connection.getAtom("_NET_WM_NAME"), connection.getAtom("UTF8_STRING"),
+                                 8, sizeof(kName) - 1, kName);
+    connection.track(cookie, ErrorTracker::Request::ChangeProperty, checkWindow);
+    replace(check, XCB_ATOM_WINDOW, 1, &checkWindow);
+
+    std::vector<xcb_atom_t> supported;
+    for (const char* name : kSupported) {
+        supported.push_back(connection.getAtom(name));
+    }
+    replace(connection.getAtom("_NET_SUPPORTED"), XCB_ATOM_ATOM,
+            static_cast<uint32_t>(supported.size()), supported.data());
+
+    uint32_t desktops = static_cast<uint32_t>(workspaces.getCount());
+    replace(connection.getAtom("_NET_NUMBER_OF_DESKTOPS"), XCB_ATOM_CARDINAL, 1, &desktops);
+}
+
+EwmhPublisher::~EwmhPublisher() {
+    xcb_connection_t* conn = connection.getConnection();
+    xcb_delete_property(conn, connection.getRootWindow(), connection.getAtom("_NET_SUPPORTING_WM_CHECK"));
+    xcb_destroy_window(conn, checkWindow);
+    if (writes) {
+        Logger::info("EWMH: " + std::to_string(writes) + " root property writes, " +
+                     std::to_string(appends) + " list appends, " +
+                     std::to_string(replaces) + " list rewrites");
+    }
+}
+
+void EwmhPublisher::add(xcb_window_t window) {
+    clientList.push_back(window);
+}
+
+void EwmhPublisher::remove(xcb_window_t window) {
+    auto it = std::find(clientList.begin(), clientList.end(), window);
+    if (it != clientList.end()) {
+        clientList.erase(it);
+    }
+
+    // The frame stays in the stacking order for reuse
+    stackingDirty = true;
+}
+
+void EwmhPublisher::flush() {
+    publishList(connection.getAtom("_NET_CLIENT_LIST"), clientList, publishedClients);
+
+    if (stackingDirty || stack.getVersion() != stackVersion) {
+        stackingDirty = false;
+        stackVersion = stack.getVersion();
+        frames.clear();
+        stack.getOwned(frames);
+        stacking.clear();
+        for (xcb_window_t frame : frames) {
+            if (Client* client = clients.findByFrame(frame)) {
+                stacking.push_back(client->getId());
+            }
+        }
+        publishList(connection.getAtom("_NET_CLIENT_LIST_STACKING"), stacking, publishedStacking);
+    }
+
+    Client* focused = workspaces.getFocused();
+    xcb_window_t active = focused ? focused->getId() : XCB_NONE;
+    if (initial || active != publishedActive) {
+        publishedActive = active;
+        replace(connection.getAtom("_NET_ACTIVE_WINDOW"), XCB_ATOM_WINDOW, 1, &active);
+    }
+
+    uint32_t desktop = workspaces.getCurrent();
+    if (initial || desktop != publishedDesktop) {
+        publishedDesktop = desktop;
+        replace(connection.getAtom("_NET_CURRENT_DESKTOP"), XCB_ATOM_CARDINAL, 1, &desktop);
+    }
+    initial = false;
+}
+
+void EwmhPublisher::publishList(xcb_atom_t property, const std::vector<xcb_window_t>& next,
+                                std::vector<xcb_window_t>& published) {
+    // The first write replaces whatever a previous window manager left
+    if (!initial && next == published) {
+        return;
+    }
+    size_t kept = published.size();
+    if (initial || next.size() < kept || !std::equal(published.begin(), published.end(), next.begin())) {
+        replace(property, XCB_ATOM_WINDOW, static_cast<uint32_t>(next.size()), next.data());
+        published = next;
+        replaces++;
+        return;
+    }
+
+    auto cookie = xcb_change_property(connection.getConnection(), XCB_PROP_MODE_APPEND,
+                                      connection.getRootWindow(), property, XCB_ATOM_WINDOW, 32,
+                                      static_cast<uint32_t>(next.size() - kept), next.data() + kept);
+    connection.track(cookie, ErrorTracker::Request::ChangeProperty, connection.getRootWindow());
+    published.insert(published.end(), next.begin() + kept, next.end());
+    writes++;
+    appends++;
+}
+
+void EwmhPublisher::replace(xcb_atom_t property, xcb_atom_t type, uint32_t count, const void* data) {
+    xcb_window_t root = connection.getRootWindow();
+    auto cookie = xcb_change_property(connection.getConnection(), XCB_PROP_MODE_REPLACE, root,
+                                      property, type, 32, count, data);
+    connection.track(cookie, ErrorTracker::Request::ChangeProperty, root);
+    writes++;
+}
+
+} // namespace X
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "../client/client_manager.h"
+#include "../connection/connection.h"
+#include "../stack/stacking_order.h"
+#include "../workspace/workspace_manager.h"
+#include <xcb/xcb.h>
+#include <cstdint>
+#include <vector>
+
+namespace X {
+
+/**
+ * @class EwmhPublisher
+ * @brief Publishes the window manager's state as EWMH root properties
+ *
+ * _NET_SUPPORTED, _NET_SUPPORTING_WM_CHECK and _NET_NUMBER_OF_DESKTOPS
+ * are written once. _NET_CLIENT_LIST, _NET_CLIENT_LIST_STACKING,
+ * _NET_ACTIVE_WINDOW and _NET_CURRENT_DESKTOP are compared with what
+ * was last written when flush() runs at the end of an event pass, and
+ * each is written at most once per pass. A list that only grew at the
+ * end is extended with XCB_PROP_MODE_APPEND instead of being rewritten,
+ * so a storm of maps costs one short append per pass.
+ */
+class EwmhPublisher {
+public:
+    /**
+     * @brief Constructor that writes the static properties
+     * @param connection The X connection
+     * @param clients The client registry
+     * @param workspaces The workspaces
+     * @param stack The stacking order of the frames
+     */
+    EwmhPublisher(Connection& connection, ClientManager& clients,
+                  WorkspaceManager& workspaces, StackingOrder& stack);
+
+    /**
+     * @brief Destructor that destroys the check window and reports writes
+     */
+    ~EwmhPublisher();
+
+    EwmhPublisher(const EwmhPublisher&) = delete;
+    EwmhPublisher& operator=(const EwmhPublisher&) = delete;
+
+    /**
+     * @brief Add a newly managed client to the end of the client list
+     * @param window The client window ID
+     */
+    void add(xcb_window_t window);
+
+    /**
+     * @brief Remove a client that is no longer managed from the client list
+     * @param window The client window ID
+     */
+    void remove(xcb_window_t window);
+
+    /**
+     * @brief Write the properties that changed since the last call
+     *
+     * The requests are not flushed.
+     */
+    void flush();
+
+private:
+    Connection& connection;
+    ClientManager& clients;
+    WorkspaceManager& workspaces;
+    StackingOrder& stack;
+    xcb_window_t checkWindow;   // Child of the root named after the window manager
+
+    std::vector<xcb_window_t> clientList;        // Mapping order
+    std::vector<xcb_window_t> publishedClients;
+    std::vector<xcb_window_t> publishedStacking;
+    uint64_t stackVersion;                       // Version of stack when published
+    bool stackingDirty;                          // A client left since then
+    xcb_window_t publishedActive;
+    uint32_t publishedDesktop;
+    bool initial;                                // Nothing published yet
+
+    std::vector<xcb_window_t> frames;            // Scratch for the stacking list
+    std::vector<xcb_window_t> stacking;
+
+    uint64_t writes;
+    uint64_t appends;
+    uint64_t replaces;
+
+    /**
+     * @brief Write a window list, appending if it only grew at the end
+     * @param property The property atom
+     * @param next The list to publish
+     * @param published The list last published, updated
+     */
+    void publishList(xcb_atom_t property, const std::vector<xcb_window_t>& next,
+                     std::vector<xcb_window_t>& published);
+
+    /**
+     * @brief Replace a property on the root window
+     * @param property The property atom
+     * @param type The property type
+     * @param count The number of 32-bit values
+     * @param data The values
+     */
+    void replace(xcb_atom_t property, xcb_atom_t type, uint32_t count, const void* data);
+};
+
+} // namespace X
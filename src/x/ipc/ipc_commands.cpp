@@ -0,0 +1,165 @@
+#include "ipc_commands.h"
+#include "../x.h"
+#include <cstdio>
+
+namespace X {
+
+namespace {
+
+Ipc::Status fail(std::string& reply, const char* message) {
+    reply = message;
+    return Ipc::Status::Error;
+}
+
+} // namespace
+
+IpcCommands::IpcCommands(X& system)
+    : system(system) {
+}
+
+void IpcCommands::appendWindow(std::string& out, xcb_window_t window) {
+    char text[16];
+    std::snprintf(text, sizeof(text), "0x%08x", window);
+    out += text;
+}
+
+void IpcCommands::appendRect(std::string& out, const Rect& rect) {
+    out += std::to_string(rect.x) + "," + std::to_string(rect.y) + " " +
+           std::to_string(rect.width) + "x" + std::to_string(rect.height);
+}
+
+Ipc::Status IpcCommands::run(Ipc::Op op, std::string_view payload, std::string& reply) {
+    WorkspaceManager& workspaces = system.getWorkspaces();
+    uint32_t value = 0;
+
+    switch (op) {
+        case Ipc::Op::FocusDirection: {
+            if (payload.size() != 1 || static_cast<uint8_t>(payload[0]) > 3) {
+                return fail(reply, "bad direction");
+            }
+            // The wire values follow ClientIndex::Direction
+            workspaces.focusDirection(static_cast<ClientIndex::Direction>(payload[0]));
+            return Ipc::Status::Ok;
+        }
+        case Ipc::Op::FocusWindow: {
+            if (!Ipc::decodeU32(payload, value)) {
+                return fail(reply, "bad window");
+            }
+            Client* client = system.getClients().find(value);
+            if (!client) {
+                return fail(reply, "no such client");
+            }
+            if (!workspaces.isVisible(client)) {
+                workspaces.switchTo(client->getWorkspace());
+            }
+            workspaces.focus(client);
+            return Ipc::Status::Ok;
+        }
+        case Ipc::Op::Workspace:
+        case Ipc::Op::MoveToWorkspace: {
+            if (!Ipc::decodeU32(payload, value) || value >= workspaces.getCount()) {
+                return fail(reply, "no such workspace");
+            }
+            if (op == Ipc::Op::Workspace) {
+                workspaces.switchTo(value);
+                return Ipc::Status::Ok;
+            }
+            if (!workspaces.getFocused()) {
+                return fail(reply, "no focused client");
+            }
+            workspaces.moveFocusedBy(static_cast<int>(value) - static_cast<int>(workspaces.getCurrent()));
+            return Ipc::Status::Ok;
+        }
+        case Ipc::Op::Spawn: {
+            std::string command(payload);
+            if (command.empty()) {
+                return fail(reply, "empty command");
+            }
+            pid_t pid = system.getSpawner().spawn(command);
+            if (pid <= 0) {
+                return fail(reply, "spawn failed");
+            }
+            system.getChildTracker().track(pid, command);
+            reply = std::to_string(pid);
+            return Ipc::Status::Ok;
+        }
+        case Ipc::Op::Query:
+            // Only without a query thread; the state is that of the last pass
+            return query(*system.getState()->current(), payload, reply);
+        case Ipc::Op::Subscribe:
+            // Handled by the server; only malformed ones get here
+            return fail(reply, "bad subscription");
+    }
+    return fail(reply, "unknown request");
+}
+
+Ipc::Status IpcCommands::query(const StateSnapshot& state, std::string_view payload, std::string& reply) {
+    if (payload.size() != 1) {
+        return fail(reply, "bad query");
+    }
+
+    switch (static_cast<Ipc::Query>(payload[0])) {
+        case Ipc::Query::Focused: {
+            if (state.focused != XCB_NONE) {
+                appendWindow(reply, state.focused);
+                reply += " " + state.focusedTitle + "\n";
+            }
+            return Ipc::Status::Ok;
+        }
+        case Ipc::Query::Clients: {
+            for (const auto& chunk : state.clients) {
+                if (!chunk) {
+                    continue;
+                }
+                for (const ClientState& client : *chunk) {
+                    if (client.window == XCB_NONE) {
+                        continue;
+                    }
+                    appendWindow(reply, client.window);
+                    reply += " " + std::to_string(client.workspace + 1) +
+                             (client.floating ? " floating " : " tiled ");
+                    appendRect(reply, client.geometry);
+                    reply += " " + client.title + "\n";
+                }
+            }
+            return Ipc::Status::Ok;
+        }
+        case Ipc::Query::Workspaces: {
+            for (unsigned int i = 0; i < state.workspaces.size(); i++) {
+                int monitor = state.workspaces[i].monitor;
+                reply += std::to_string(i + 1) + (i == state.current ? "* " : " ") +
+                         (monitor >= 0 ? std::to_string(monitor + 1) : "-") + " " +
+                         std::to_string(state.workspaces[i].clients) + "\n";
+            }
+            return Ipc::Status::Ok;
+        }
+        case Ipc::Query::Monitors: {
+            for (size_t i = 0; i < state.monitors.size(); i++) {
+                int workspace = state.shown[i];
+                reply += std::to_string(i + 1) + (state.monitors[i].primary ? "* " : " ");
+                appendRect(reply, state.monitors[i].area);
+                reply += " " + std::to_string(state.monitors[i].refreshHz) + " " +
+                         (workspace >= 0 ? std::to_string(workspace + 1) : "-") + "\n";
+            }
+            return Ipc::Status::Ok;
+        }
+    }
+    return fail(reply, "unknown query");
+}
+
+void IpcCommands::queries(const StateSnapshot& state, std::string_view requests, std::string& replies) {
+    size_t offset = 0;
+    uint8_t code;
+    std::string_view payload;
+    std::string reply;
+    while (Ipc::nextFrame(requests, offset, code, payload) > 0) {
+        reply.clear();
+        Ipc::Status status = query(state, payload, reply);
+        if (reply.size() > Ipc::kMaxReply) {
+            status = fail(reply, "reply too large");
+        }
+        Ipc::appendFrame(replies, static_cast<uint8_t>(status), reply);
+    }
+}
+
+} // namespace X
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ipc_protocol.h"
+#include "../layout/rect.h"
+#include <xcb/xcb.h>
+#include <string>
+#include <string_view>
+
+namespace X {
+
+class X;
+struct StateSnapshot;
+
+/**
+ * @class IpcCommands
+ * @brief Runs control socket requests against the window manager state
+ *
+ * Requests only change the model, like the key bindings do; the
+ * relayout and the flush happen once for the whole pass.
+ */
+class IpcCommands {
+public:
+    /**
+     * @brief Constructor
+     * @param system The window manager
+     */
+    explicit IpcCommands(X& system);
+
+    /**
+     * @brief Run one request
+     * @param op The request code
+     * @param payload The request payload
+     * @param reply Receives the reply payload
+     * @return The reply status
+     */
+    Ipc::Status run(Ipc::Op op, std::string_view payload, std::string& reply);
+
+    /**
+     * @brief Append a window ID as replies and events show it
+     * @param out The text
+     * @param window The window ID
+     */
+    static void appendWindow(std::string& out, xcb_window_t window);
+
+    /**
+     * @brief Append a rectangle as "<x>,<y> <w>x<h>"
+     * @param out The text
+     * @param rect The rectangle
+     */
+    static void appendRect(std::string& out, const Rect& rect);
+
+    /**
+     * @brief Answer a Query request from published state (any thread)
+     * @param state The snapshot to answer from
+     * @param payload The request payload
+     * @param reply Receives the text
+     * @return The reply status
+     */
+    static Ipc::Status query(const StateSnapshot& state, std::string_view payload, std::string& reply);
+
+    /**
+     * @brief Answer framed Query requests from one snapshot (any thread)
+     * @param state The snapshot to answer from
+     * @param requests The framed requests
+     * @param replies Receives the framed replies
+     */
+    static void queries(const StateSnapshot& state, std::string_view requests, std::string& replies);
+
+private:
+    X& system;
+};
+
+} // namespace X
@@ -0,0 +1,77 @@
+#include "ipc_events.h"
+#include "ipc_commands.h"
+#include "../client/client.h"
+#include "../monitor/monitor_manager.h"
+#include "../workspace/workspace_manager.h"
+
+namespace X {
+
+IpcEvents::IpcEvents(IpcServer& server, WorkspaceManager& workspaces, MonitorManager& monitors)
+    : server(server), workspaces(workspaces), monitors(monitors), lastFocus(XCB_NONE) {
+}
+
+void IpcEvents::title(const Client* client) {
+    if (!server.wants(Ipc::Event::Title)) {
+        return;
+    }
+    text.clear();
+    IpcCommands::appendWindow(text, client->getId());
+    text += " " + client->getTitle();
+    server.publish(Ipc::Event::Title, client->getId(), text);
+}
+
+void IpcEvents::layout(const std::vector<unsigned int>& changed) {
+    if (!server.wants(Ipc::Event::Layout)) {
+        return;
+    }
+    for (unsigned int workspace : changed) {
+        text = std::to_string(workspace + 1) + " " + std::to_string(workspaces.getClientCount(workspace));
+        server.publish(Ipc::Event::Layout, workspace, text);
+    }
+}
+
+void IpcEvents::monitorsChanged() {
+    if (!server.wants(Ipc::Event::Monitor)) {
+        return;
+    }
+    text.clear();
+    for (const Monitor& monitor : monitors.getMonitors()) {
+        if (!text.empty()) {
+            text += " ";
+        }
+        IpcCommands::appendRect(text, monitor.area);
+    }
+    server.publish(Ipc::Event::Monitor, 0, text);
+}
+
+void IpcEvents::flush() {
+    Client* focused = workspaces.getFocused();
+    xcb_window_t focus = focused ? focused->getId() : XCB_NONE;
+    if (focus != lastFocus) {
+        lastFocus = focus;
+        if (server.wants(Ipc::Event::Focus)) {
+            text.clear();
+            if (focused) {
+                IpcCommands::appendWindow(text, focus);
+                text += " " + focused->getTitle();
+            }
+            server.publish(Ipc::Event::Focus, 0, text);
+        }
+    }
+
+    if (server.wants(Ipc::Event::Workspace)) {
+        text = std::to_string(workspaces.getCurrent() + 1);
+        for (size_t i = 0; i < monitors.getMonitors().size(); i++) {
+            int shown = workspaces.shownOn(i);
+            text += " " + (shown >= 0 ? std::to_string(shown + 1) : "-");
+        }
+        if (text != lastWorkspaces) {
+            lastWorkspaces = text;
+            server.publish(Ipc::Event::Workspace, 0, text);
+        }
+    }
+
+    server.sendEvents();
+}
+
+} // namespace X
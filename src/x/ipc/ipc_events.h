@@ -0,0 +1,66 @@
+#pragma once
+
+#include "ipc_server.h"
+#include <xcb/xcb.h>
+#include <string>
+#include <vector>
+
+namespace X {
+
+class Client;
+class MonitorManager;
+class WorkspaceManager;
+
+/**
+ * @class IpcEvents
+ * @brief Turns window manager state changes into pushed IPC events
+ *
+ * Titles, relayouts and monitor changes are reported as they happen
+ * during a pass; focus and the shown workspaces are compared with what
+ * was last published once at the end of it. Nothing is formatted for an
+ * event class nobody subscribed to.
+ */
+class IpcEvents {
+public:
+    /**
+     * @brief Constructor
+     * @param server The control socket
+     * @param workspaces The workspace manager
+     * @param monitors The monitor manager
+     */
+    IpcEvents(IpcServer& server, WorkspaceManager& workspaces, MonitorManager& monitors);
+
+    /**
+     * @brief Report that the title of a client changed
+     * @param client The client
+     */
+    void title(const Client* client);
+
+    /**
+     * @brief Report that workspaces were relaid out
+     * @param changed The workspaces whose clients moved
+     */
+    void layout(const std::vector<unsigned int>& changed);
+
+    /**
+     * @brief Report that the monitors changed
+     */
+    void monitorsChanged();
+
+    /**
+     * @brief Publish focus and workspace changes, then send the events
+     *
+     * Called once at the end of every pass.
+     */
+    void flush();
+
+private:
+    IpcServer& server;
+    WorkspaceManager& workspaces;
+    MonitorManager& monitors;
+    xcb_window_t lastFocus;
+    std::string lastWorkspaces;   // Text of the last workspace event
+    std::string text;             // Reused for every event
+};
+
+} // namespace X
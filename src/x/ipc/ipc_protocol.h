@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+
+namespace X {
+namespace Ipc {
+
+/**
+ * Wire format of the control socket, shared by the window manager and
+ * doowmc.
+ *
+ * Every message is a frame: the payload length as a 32-bit integer, one
+ * code byte and the payload. Integers are in host byte order since both
+ * ends are on the same machine. Requests carry an Op, replies a Status;
+ * each request gets exactly one reply, in order, so a client may write
+ * any number of requests before reading the replies.
+ *
+ * After a Subscribe request the server also pushes Event frames, whose
+ * payload is the Event byte and a line of text, between the replies.
+ */
+
+/**
+ * @enum Op
+ * @brief Request codes and their payloads
+ */
+enum class Op : uint8_t {
+    FocusDirection = 1,   // uint8_t direction: 0 left, 1 right, 2 up, 3 down
+    FocusWindow,          // uint32_t window ID
+    Workspace,            // uint32_t workspace index, from 0
+    MoveToWorkspace,      // uint32_t workspace index for the focused client
+    Spawn,                // The command line
+    Query,                // uint8_t Query
+    Subscribe,            // uint8_t mask of eventBit() values; 0 to stop
+};
+
+/**
+ * @enum Query
+ * @brief What a Query request asks for; the reply is text, one line each
+ */
+enum class Query : uint8_t {
+    Focused,      // "<window> <title>", or nothing
+    Clients,      // "<window> <workspace> <tiled|floating> <x>,<y> <w>x<h> <title>"
+    Workspaces,   // "<workspace> <monitor or -> <clients>", the current one marked '*'
+    Monitors,     // "<monitor> <x>,<y> <w>x<h> <Hz> <workspace>", the primary one marked '*'
+};
+
+/**
+ * @enum Status
+ * @brief Reply codes; an Error reply carries a message
+ */
+enum class Status : uint8_t {
+    Ok = 0,
+    Error,
+    Event,   // Pushed to subscribers, not a reply
+};
+
+/**
+ * @enum Event
+ * @brief Classes of pushed events and their text
+ */
+enum class Event : uint8_t {
+    Focus,       // "<window> <title>", or nothing when no client has the focus
+    Title,       // "<window> <title>"
+    Workspace,   // "<current> <workspace on each monitor, or ->..."
+    Monitor,     // "<x>,<y> <w>x<h>" for each monitor, separated by spaces
+    Layout,      // "<workspace> <clients>" for a relaid out workspace
+    Count
+};
+
+/**
+ * @brief Get the subscription mask bit of an event class
+ * @param event The event class
+ * @return The bit
+ */
+constexpr uint8_t eventBit(Event event) {
+    return static_cast<uint8_t>(1u << static_cast<unsigned int>(event));
+}
+
+constexpr size_t kHeaderSize = 5;             // Length and code
+constexpr uint32_t kMaxPayload = 64 * 1024;   // Larger requests end the connection
+// Replies are not split; a listing of every client may exceed kMaxPayload
+constexpr uint32_t kMaxReply = 16 * 1024 * 1024;
+
+/**
+ * @brief Append a frame to a buffer
+ * @param out The buffer
+ * @param code The Op or Status
+ * @param payload The payload
+ */
+inline void appendFrame(std::string& out, uint8_t code, std::string_view payload) {
+    uint32_t length = static_cast<uint32_t>(payload.size());
+    char header[kHeaderSize];
+    std::memcpy(header, &length, sizeof(length));
+    header[4] = static_cast<char>(code);
+    out.append(header, kHeaderSize);
+    out.append(payload);
+}
+
+/**
+ * @brief Take the next complete frame from a buffer
+ * @param buffer The bytes read so far
+ * @param offset Start of the frame; advanced past it on success
+ * @param code Receives the code
+ * @param payload Receives the payload, pointing into the buffer
+ * @param limit The largest payload accepted; kMaxReply when reading replies
+ * @return 1 for a frame, 0 if more bytes are needed, -1 for an oversized frame
+ */
+inline int nextFrame(std::string_view buffer, size_t& offset, uint8_t& code, std::string_view& payload,
+                     uint32_t limit = kMaxPayload) {
+    if (buffer.size() - offset < kHeaderSize) {
+        return 0;
+    }
+    uint32_t length;
+    std::memcpy(&length, buffer.data() + offset, sizeof(length));
+    if (length > limit) {
+        return -1;
+    }
+    if (buffer.size() - offset - kHeaderSize < length) {
+        return 0;
+    }
+    code = static_cast<uint8_t>(buffer[offset + 4]);
+    payload = buffer.substr(offset + kHeaderSize, length);
+    offset += kHeaderSize + length;
+    return 1;
+}
+
+/**
+ * @brief Encode an integer payload
+ * @param value The value
+ * @return The payload
+ */
+inline std::string encodeU32(uint32_t value) {
+    return std::string(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/**
+ * @brief Decode an integer payload
+ * @param payload The payload
+ * @param value Receives the value
+ * @return true if the payload holds exactly one integer
+ */
+inline bool decodeU32(std::string_view payload, uint32_t& value) {
+    if (payload.size() != sizeof(value)) {
+        return false;
+    }
+    std::memcpy(&value, payload.data(), sizeof(value));
+    return true;
+}
+
+/**
+ * @brief Get the directory holding the socket when $XDG_RUNTIME_DIR is unset
+ * @return A per-user directory under /tmp, which the server keeps private
+ */
+inline std::string fallbackDirectory() {
+    return "/tmp/doowm-" + std::to_string(getuid());
+}
+
+/**
+ * @brief Get the path of the control socket
+ * @return $DOOWM_SOCKET if set, else a path under $XDG_RUNTIME_DIR (or
+ *         fallbackDirectory()) that includes the display, so nested
+ *         sessions do not clash
+ */
+inline std::string socketPath() {
+    const char* explicitPath = std::getenv("DOOWM_SOCKET");
+    if (explicitPath && *explicitPath) {
+        return explicitPath;
+    }
+
+    const char* display = std::getenv("DISPLAY");
+    std::string suffix = display && *display ? display : ":0";
+    const char* runtimeDir = std::getenv("XDG_RUNTIME_DIR");
+    if (runtimeDir && *runtimeDir) {
+        return std::string(runtimeDir) + "/doowm" + suffix + ".sock";
+    }
+    return fallbackDirectory() + "/doowm" + suffix + ".sock";
+}
+
+} // namespace Ipc
+} // namespace X
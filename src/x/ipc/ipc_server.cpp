@@ -0,0 +1,456 @@
+#include "ipc_server.h"
+#include "../../log/logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace X {
+
+namespace {
+
+constexpr size_t kReadChunk = 64 * 1024;
+constexpr int kReadsPerWakeup = 16;   // Bounded so one client cannot hog the loop
+
+bool fillAddress(const std::string& path, sockaddr_un& address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// Anyone may create the fallback directory first; only use it if it is ours
+bool privateDirectory(const std::string& directory) {
+    if (mkdir(directory.c_str(), 0700) < 0 && errno != EEXIST) {
+        return false;
+    }
+    struct stat info;
+    return lstat(directory.c_str(), &info) == 0 && S_ISDIR(info.st_mode) && info.st_uid == getuid() &&
+           (info.st_mode & 077) == 0;
+}
+
+} // namespace
+
+IpcServer::IpcServer(EventLoop& loop)
+    : loop(loop), listenFd(-1), readBuffer(kReadChunk, '\0'), nextPeerId(0), subscribedMask(0),
+      requests(0), batches(0), largestBatch(0), eventsQueued(0), eventsCoalesced(0),
+      subscribersDropped(0), queries(0) {
+}
+
+IpcServer::~IpcServer() {
+    // Answers still being worked on are dropped with the thread
+    queryThread.reset();
+    while (!peers.empty()) {
+        close(peers.begin()->first);
+    }
+    if (listenFd >= 0) {
+        loop.removeWatch(listenFd);
+        ::close(listenFd);
+        unlink(path.c_str());
+    }
+    if (requests) {
+        Logger::info("IPC: " + std::to_string(requests) + " requests in " + std::to_string(batches) +
+                     " batches, largest " + std::to_string(largestBatch) + ", " +
+                     std::to_string(queries) + " queries off the main thread");
+    }
+    if (eventsQueued) {
+        Logger::info("IPC events: " + std::to_string(eventsQueued) + " queued, " +
+                     std::to_string(eventsCoalesced) + " coalesced, " +
+                     std::to_string(subscribersDropped) + " subscribers dropped");
+    }
+}
+
+bool IpcServer::listen(const std::string& socketPath) {
+    sockaddr_un address;
+    if (!fillAddress(socketPath, address)) {
+        Logger::warning("IPC socket path too long: " + socketPath);
+        return false;
+    }
+
+    std::string directory = Ipc::fallbackDirectory();
+    if (socketPath.compare(0, directory.size() + 1, directory + "/") == 0 && !privateDirectory(directory)) {
+        Logger::warning("IPC socket directory is not private: " + directory);
+        return false;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        Logger::warning(std::string("IPC socket failed: ") + std::strerror(errno));
+        return false;
+    }
+
+    int bound = bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    if (bound < 0 && errno == EADDRINUSE) {
+        // Replace the socket only if nobody answers on it
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool live = probe >= 0 &&
+                    connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+        if (probe >= 0) {
+            ::close(probe);
+        }
+        if (live) {
+            Logger::warning("IPC socket already in use: " + socketPath);
+            ::close(fd);
+            return false;
+        }
+        unlink(socketPath.c_str());
+        bound = bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    }
+    // Nobody can connect before listen(), so this leaves no window open
+    if (bound < 0 || chmod(socketPath.c_str(), 0600) < 0 || ::listen(fd, SOMAXCONN) < 0) {
+        Logger::warning("IPC socket " + socketPath + " failed: " + std::strerror(errno));
+        ::close(fd);
+        return false;
+    }
+
+    listenFd = fd;
+    path = socketPath;
+    loop.addWatch(listenFd, [this]() { acceptPeers(); });
+    Logger::info("IPC socket listening at " + path);
+    return true;
+}
+
+void IpcServer::setQueryHandler(QueryHandler handler) {
+    queryHandler = std::move(handler);
+    queryThread = std::make_unique<QueryThread>(loop);
+    bool started = queryThread->start(
+        [this](QueryThread::Job& job) { queryHandler(job.requests, job.replies); },
+        [this](QueryThread::Job& job) { answered(job); });
+    if (!started) {
+        queryThread.reset();
+    }
+}
+
+void IpcServer::runQueries() {
+    for (int fd : asking) {
+        auto it = peers.find(fd);
+        if (it == peers.end() || it->second.queries.empty()) {
+            continue;
+        }
+        Peer& peer = it->second;
+        queryThread->submit(QueryThread::Job{ fd, peer.id, std::move(peer.queries), std::string() });
+        peer.queries.clear();
+    }
+    asking.clear();
+}
+
+void IpcServer::answered(QueryThread::Job& job) {
+    auto it = peers.find(job.fd);
+    if (it == peers.end() || it->second.id != job.peer) {
+        return;
+    }
+    Peer& peer = it->second;
+    peer.output += job.replies;
+    peer.querying = false;
+
+    // Requests held back behind the queries run in the next pass
+    queue(job.fd, peer);
+    if (!send(job.fd, peer)) {
+        close(job.fd);
+        return;
+    }
+    updateEvents(job.fd, peer);
+}
+
+size_t IpcServer::dispatch() {
+    if (ready.empty()) {
+        return 0;
+    }
+
+    size_t count = 0;
+    std::vector<int> pending;
+    pending.swap(ready);
+    std::string reply;
+    for (int fd : pending) {
+        auto it = peers.find(fd);
+        if (it == peers.end()) {
+            continue;
+        }
+        Peer& peer = it->second;
+        peer.queued = false;
+        if (peer.querying) {
+            // Queued again once the answers are back
+            continue;
+        }
+
+        size_t offset = 0;
+        size_t collected = 0;
+        bool failed = false;
+        while (peer.output.size() - peer.written < kMaxOutput) {
+            uint8_t code;
+            std::string_view payload;
+            size_t start = offset;
+            int result = Ipc::nextFrame(peer.input, offset, code, payload);
+            if (result < 0) {
+                Logger::warning("IPC client sent an oversized request, disconnecting");
+                failed = true;
+            }
+            if (result <= 0) {
+                break;
+            }
+
+            if (static_cast<Ipc::Op>(code) == Ipc::Op::Query && queryThread) {
+                if (collected == kQueriesPerJob) {
+                    // Left for after the answers, like any other request
+                    offset = start;
+                    break;
+                }
+                collected++;
+                Ipc::appendFrame(peer.queries, code, payload);
+                queries++;
+                count++;
+                continue;
+            }
+            if (!peer.queries.empty()) {
+                // Left for after the answers
+                offset = start;
+                break;
+            }
+
+            reply.clear();
+            Ipc::Status status = Ipc::Status::Error;
+            if (static_cast<Ipc::Op>(code) == Ipc::Op::Subscribe && payload.size() == 1) {
+                subscribe(fd, peer, static_cast<uint8_t>(payload[0]));
+                status = Ipc::Status::Ok;
+            } else if (handler) {
+                status = handler(static_cast<Ipc::Op>(code), payload, reply);
+            }
+            Ipc::appendFrame(peer.output, static_cast<uint8_t>(status), reply);
+            count++;
+        }
+        peer.input.erase(0, offset);
+        if (!peer.queries.empty()) {
+            peer.querying = true;
+            asking.push_back(fd);
+        }
+
+        // Requests left unrun for a slow reader are retried next time
+        if (!failed && !peer.querying && peer.output.size() - peer.written >= kMaxOutput) {
+            queue(fd, peer);
+        }
+        if (failed || !send(fd, peer) ||
+            (peer.closing && peer.output.empty() && !peer.queued && !peer.querying)) {
+            close(fd);
+            continue;
+        }
+        updateEvents(fd, peer);
+    }
+
+    if (count) {
+        requests += count;
+        batches++;
+        largestBatch = std::max<uint64_t>(largestBatch, count);
+    }
+    return count;
+}
+
+void IpcServer::publish(Ipc::Event event, uint32_t key, std::string_view text) {
+    for (int fd : subscribers) {
+        Peer& peer = peers[fd];
+        Subscription& subscription = *peer.subscription;
+        if (!(subscription.mask & Ipc::eventBit(event)) || subscription.overflowed) {
+            continue;
+        }
+        eventsQueued++;
+
+        // A newer state of the same thing replaces the one still queued
+        bool replaced = false;
+        for (size_t i = 0; i < subscription.count; i++) {
+            QueuedEvent& queued = subscription.ring[(subscription.head + i) % kRingSize];
+            if (queued.event == event && queued.key == key) {
+                queued.text.assign(text);
+                eventsCoalesced++;
+                replaced = true;
+                break;
+            }
+        }
+        if (replaced) {
+            continue;
+        }
+
+        // A busy pass may fill the ring by itself; only a subscriber
+        // whose socket is backed up as well has fallen behind
+        if (subscription.count == kRingSize) {
+            drainEvents(peer);
+        }
+        if (subscription.count == kRingSize) {
+            subscription.overflowed = true;
+            continue;
+        }
+        QueuedEvent& slot = subscription.ring[(subscription.head + subscription.count) % kRingSize];
+        slot.event = event;
+        slot.key = key;
+        slot.text.assign(text);
+        subscription.count++;
+    }
+}
+
+void IpcServer::sendEvents() {
+    std::vector<int> dropped;
+    for (int fd : subscribers) {
+        Peer& peer = peers[fd];
+        if (peer.subscription->overflowed) {
+            dropped.push_back(fd);
+            continue;
+        }
+        if (!peer.subscription->count) {
+            continue;
+        }
+        drainEvents(peer);
+        if (!send(fd, peer)) {
+            dropped.push_back(fd);
+            continue;
+        }
+        updateEvents(fd, peer);
+    }
+
+    for (int fd : dropped) {
+        Logger::warning("IPC subscriber fell behind, disconnecting");
+        subscribersDropped++;
+        close(fd);
+    }
+}
+
+void IpcServer::subscribe(int fd, Peer& peer, uint8_t mask) {
+    if (!mask) {
+        if (peer.subscription) {
+            peer.subscription.reset();
+            subscribers.erase(std::find(subscribers.begin(), subscribers.end(), fd));
+        }
+    } else if (peer.subscription) {
+        peer.subscription->mask = mask;
+    } else {
+        peer.subscription = std::make_unique<Subscription>(
+            Subscription{ mask, std::vector<QueuedEvent>(kRingSize), 0, 0, false });
+        subscribers.push_back(fd);
+    }
+
+    subscribedMask = 0;
+    for (int subscriber : subscribers) {
+        subscribedMask |= peers[subscriber].subscription->mask;
+    }
+}
+
+void IpcServer::drainEvents(Peer& peer) {
+    Subscription& subscription = *peer.subscription;
+    while (subscription.count && peer.output.size() - peer.written < kEventBurst) {
+        // The payload is the class byte and the text, framed in place
+        QueuedEvent& queued = subscription.ring[subscription.head];
+        size_t start = peer.output.size();
+        char event = static_cast<char>(queued.event);
+        Ipc::appendFrame(peer.output, static_cast<uint8_t>(Ipc::Status::Event), std::string_view(&event, 1));
+        peer.output += queued.text;
+        uint32_t length = static_cast<uint32_t>(1 + queued.text.size());
+        std::memcpy(&peer.output[start], &length, sizeof(length));
+        subscription.head = (subscription.head + 1) % kRingSize;
+        subscription.count--;
+    }
+}
+
+void IpcServer::acceptPeers() {
+    while (true) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                Logger::warning(std::string("IPC accept failed: ") + std::strerror(errno));
+            }
+            return;
+        }
+        peers.emplace(fd, Peer{ std::string(), std::string(), 0, false, false, false, nextPeerId++,
+                                std::string(), nullptr });
+        loop.addWatch(fd, [this, fd]() { service(fd); });
+    }
+}
+
+void IpcServer::service(int fd) {
+    auto it = peers.find(fd);
+    if (it == peers.end()) {
+        return;
+    }
+    Peer& peer = it->second;
+
+    if (peer.subscription) {
+        drainEvents(peer);
+    }
+    if (!send(fd, peer)) {
+        close(fd);
+        return;
+    }
+    if (peer.closing) {
+        // Only replies were left to send
+        if (peer.output.empty() && !peer.queued && !peer.querying) {
+            close(fd);
+            return;
+        }
+        updateEvents(fd, peer);
+        return;
+    }
+
+    size_t before = peer.input.size();
+    for (int i = 0; i < kReadsPerWakeup && peer.input.size() < kMaxInput; i++) {
+        ssize_t got = read(fd, readBuffer.data(), readBuffer.size());
+        if (got > 0) {
+            peer.input.append(readBuffer.data(), static_cast<size_t>(got));
+            continue;
+        }
+        if (got == 0) {
+            peer.closing = true;
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            close(fd);
+            return;
+        }
+        break;
+    }
+    if (peer.input.size() != before || peer.closing) {
+        queue(fd, peer);
+    }
+    updateEvents(fd, peer);
+}
+
+bool IpcServer::send(int fd, Peer& peer) {
+    while (peer.written < peer.output.size()) {
+        ssize_t sent = ::send(fd, peer.output.data() + peer.written, peer.output.size() - peer.written,
+                              MSG_NOSIGNAL);
+        if (sent < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        peer.written += static_cast<size_t>(sent);
+    }
+    peer.output.clear();
+    peer.written = 0;
+    return true;
+}
+
+void IpcServer::queue(int fd, Peer& peer) {
+    if (!peer.queued) {
+        peer.queued = true;
+        ready.push_back(fd);
+    }
+}
+
+void IpcServer::updateEvents(int fd, const Peer& peer) {
+    // A client that shut down keeps reporting readable; only wait for
+    // it to take the rest of its replies. One that does not read them,
+    // or whose requests are not run yet, is not read either
+    bool readable = !peer.closing && peer.output.size() - peer.written < kMaxOutput &&
+                    peer.input.size() < kMaxInput;
+    loop.setEvents(fd, readable, peer.written < peer.output.size());
+}
+
+void IpcServer::close(int fd) {
+    auto it = peers.find(fd);
+    if (it != peers.end() && it->second.subscription) {
+        subscribe(fd, it->second, 0);
+    }
+    loop.removeWatch(fd);
+    ::close(fd);
+    peers.erase(fd);
+}
+
+} // namespace X
@@ -0,0 +1,261 @@
+#pragma once
+
+#include "ipc_protocol.h"
+#include "query_thread.h"
+#include "../event/event_loop.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace X {
+
+/**
+ * @class IpcServer
+ * @brief Non-blocking Unix domain control socket served from the event loop
+ *
+ * Reading only collects bytes: a readable client is drained into its
+ * input buffer without running anything. dispatch() then runs every
+ * complete request of every client in one go, from the same pass of the
+ * main loop as the X events, so a burst of commands costs one relayout
+ * and one flush of the X connection. A client may pipeline any number of
+ * requests; the replies are written back in order once the batch is done.
+ *
+ * A client whose replies pile up unread is neither served nor read further
+ * until it catches up, and one that sends an oversized frame is
+ * disconnected.
+ *
+ * Queries are answered on a QueryThread from state published at the end
+ * of the pass, after the commands that came before them took effect. A
+ * client's requests after a query wait for its answer, so replies stay
+ * in order; consecutive queries travel together.
+ *
+ * Subscribed clients get events pushed through a fixed ring each. An
+ * event replaces a queued one of the same class and key, so a bar that
+ * falls behind only misses intermediate states; a subscriber whose ring
+ * still overflows is disconnected. Nothing a subscriber does can make
+ * the event loop wait.
+ */
+class IpcServer {
+public:
+    /**
+     * @brief Runs one request
+     * @param op The request code
+     * @param payload The request payload
+     * @param reply Receives the reply payload, empty on entry
+     * @return The reply status
+     */
+    using Handler = std::function<Ipc::Status(Ipc::Op op, std::string_view payload, std::string& reply)>;
+
+    /**
+     * @brief Answers the Query requests of one client; runs on the query thread, must not log
+     * @param requests The framed requests
+     * @param replies Receives the framed replies, one per request
+     */
+    using QueryHandler = std::function<void(std::string_view requests, std::string& replies)>;
+
+    /**
+     * @brief Constructor
+     * @param loop The event loop to serve the socket from
+     */
+    explicit IpcServer(EventLoop& loop);
+
+    /**
+     * @brief Destructor that closes every connection and removes the socket
+     */
+    ~IpcServer();
+
+    IpcServer(const IpcServer&) = delete;
+    IpcServer& operator=(const IpcServer&) = delete;
+
+    /**
+     * @brief Create the socket and start accepting clients
+     * @param path The socket path
+     * @return true on success, false otherwise
+     *
+     * A stale socket left by a crashed instance is replaced; a live one
+     * is not. The socket is accessible to the user only, and a path in
+     * Ipc::fallbackDirectory() is refused unless the directory is private.
+     */
+    bool listen(const std::string& path);
+
+    /**
+     * @brief Set the function that runs requests
+     * @param handler The handler
+     */
+    void setHandler(Handler handler) { this->handler = std::move(handler); }
+
+    /**
+     * @brief Answer queries off the main thread from now on
+     * @param handler The function answering them
+     *
+     * Without a query handler, or if the query thread cannot be set up,
+     * queries go to the handler like any other request.
+     *
+     * At most kQueriesPerJob queries of a client are answered at once, so
+     * their replies cannot run far past kMaxOutput; the rest wait for the
+     * next pass.
+     */
+    void setQueryHandler(QueryHandler handler);
+
+    /**
+     * @brief Hand the queries collected by dispatch() to the query thread
+     *
+     * Called once the state they are to see has been published.
+     */
+    void runQueries();
+
+    /**
+     * @brief Run every complete request received so far and send the replies
+     * @return The number of requests run
+     */
+    size_t dispatch();
+
+    /**
+     * @brief Get the socket path
+     * @return The path, empty if not listening
+     */
+    const std::string& getPath() const { return path; }
+
+    /**
+     * @brief Check if any client subscribed to an event class
+     * @param event The event class
+     * @return true if publishing it reaches someone
+     */
+    bool wants(Ipc::Event event) const { return subscribedMask & Ipc::eventBit(event); }
+
+    /**
+     * @brief Queue an event for every client subscribed to its class
+     * @param event The event class
+     * @param key Queued events of the same class and key are replaced
+     * @param text The event text
+     */
+    void publish(Ipc::Event event, uint32_t key, std::string_view text);
+
+    /**
+     * @brief Send queued events as far as each subscriber takes them
+     *
+     * Subscribers that overflowed their ring are disconnected.
+     */
+    void sendEvents();
+
+private:
+    // Unsent replies beyond this stop a client's requests from being run
+    static constexpr size_t kMaxOutput = 1024 * 1024;
+    // Unrun requests beyond this stop a client from being read
+    static constexpr size_t kMaxInput = 1024 * 1024;
+    static constexpr size_t kQueriesPerJob = 32;
+    static constexpr size_t kRingSize = 64;            // Events queued per subscriber
+    static constexpr size_t kEventBurst = 16 * 1024;   // Event bytes handed to a socket at once
+
+    struct QueuedEvent {
+        Ipc::Event event;
+        uint32_t key;
+        std::string text;   // Capacity reused as the ring turns
+    };
+
+    struct Subscription {
+        uint8_t mask;
+        std::vector<QueuedEvent> ring;
+        size_t head;        // Oldest queued event
+        size_t count;
+        bool overflowed;
+    };
+
+    struct Peer {
+        std::string input;    // Received bytes not yet run
+        std::string output;   // Replies not yet sent
+        size_t written;       // Bytes of output already sent
+        bool closing;         // The client shut down its end
+        bool queued;          // Listed in ready
+        bool querying;        // Queries collected or being answered
+        uint64_t id;          // Tells a reused descriptor apart
+        std::string queries;  // Collected queries, framed
+        std::unique_ptr<Subscription> subscription;
+    };
+
+    EventLoop& loop;
+    int listenFd;
+    std::string path;
+    Handler handler;
+    std::unordered_map<int, Peer> peers;
+    std::vector<int> ready;   // Peers with received bytes to look at
+    std::string readBuffer;   // Reused for every read
+    std::vector<int> asking;  // Peers with collected queries
+    QueryHandler queryHandler;
+    std::unique_ptr<QueryThread> queryThread;
+    uint64_t nextPeerId;
+    std::vector<int> subscribers;
+    uint8_t subscribedMask;   // Union of the subscription masks
+    uint64_t requests;
+    uint64_t batches;         // dispatch() calls that ran something
+    uint64_t largestBatch;
+    uint64_t eventsQueued;
+    uint64_t eventsCoalesced;
+    uint64_t subscribersDropped;
+    uint64_t queries;
+
+    /**
+     * @brief Accept every pending connection
+     */
+    void acceptPeers();
+
+    /**
+     * @brief Handle a client becoming readable or writable
+     * @param fd The client descriptor
+     */
+    void service(int fd);
+
+    /**
+     * @brief Write as much pending output as the socket takes
+     * @param fd The client descriptor
+     * @param peer The client
+     * @return false if the connection failed
+     */
+    bool send(int fd, Peer& peer);
+
+    /**
+     * @brief Take back the answers to a client's queries
+     * @param job The finished job
+     */
+    void answered(QueryThread::Job& job);
+
+    /**
+     * @brief Change what a client is subscribed to
+     * @param fd The client descriptor
+     * @param peer The client
+     * @param mask The event classes, 0 for none
+     */
+    void subscribe(int fd, Peer& peer, uint8_t mask);
+
+    /**
+     * @brief Move queued events into a client's output, a burst at a time
+     * @param peer The client
+     */
+    void drainEvents(Peer& peer);
+
+    /**
+     * @brief Have dispatch() look at a client
+     * @param fd The client descriptor
+     * @param peer The client
+     */
+    void queue(int fd, Peer& peer);
+
+    /**
+     * @brief Poll a client for the events it currently needs
+     * @param fd The client descriptor
+     * @param peer The client
+     */
+    void updateEvents(int fd, const Peer& peer);
+
+    /**
+     * @brief Drop a client
+     * @param fd The client descriptor
+     */
+    void close(int fd);
+};
+
+} // namespace X
@@ -0,0 +1,117 @@
+#include "query_thread.h"
+#include "../../log/logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace X {
+
+QueryThread::QueryThread(EventLoop& loop)
+    : loop(loop), wakeupFd(-1), stopping(false), submitted(0), largestQueue(0) {
+}
+
+QueryThread::~QueryThread() {
+    if (thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeup.notify_one();
+        thread.join();
+    }
+    if (wakeupFd >= 0) {
+        loop.removeWatch(wakeupFd);
+        ::close(wakeupFd);
+    }
+    if (submitted) {
+        Logger::info("IPC query thread: " + std::to_string(submitted) + " jobs, at most " +
+                     std::to_string(largestQueue) + " queued");
+    }
+}
+
+bool QueryThread::start(Work work, Done done) {
+    wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeupFd < 0) {
+        Logger::warning(std::string("Failed to create eventfd: ") + std::strerror(errno));
+        return false;
+    }
+    this->work = std::move(work);
+    this->done = std::move(done);
+    loop.addWatch(wakeupFd, [this]() { collect(); });
+
+    try {
+        thread = std::thread(&QueryThread::run, this);
+    } catch (const std::system_error& e) {
+        Logger::warning(std::string("Failed to start IPC query thread, answering on the main thread: ") +
+                        e.what());
+    }
+    return true;
+}
+
+void QueryThread::submit(Job job) {
+    submitted++;
+    if (!thread.joinable()) {
+        this->work(job);
+        finish(std::move(job));
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+        largestQueue = std::max<uint64_t>(largestQueue, jobs.size());
+    }
+    wakeup.notify_one();
+}
+
+void QueryThread::run() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeup.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if (stopping) {
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        work(job);
+        finish(std::move(job));
+    }
+}
+
+void QueryThread::finish(Job job) {
+    bool first;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        first = finished.empty();
+        finished.push_back(std::move(job));
+    }
+
+    // One wakeup until the main thread collects; a nonblocking eventfd
+    // write only fails when the counter would overflow
+    uint64_t one = 1;
+    if (first && write(wakeupFd, &one, sizeof(one)) < 0) {
+        return;
+    }
+}
+
+void QueryThread::collect() {
+    uint64_t count;
+    while (read(wakeupFd, &count, sizeof(count)) == sizeof(count)) {
+    }
+
+    std::vector<Job> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.swap(finished);
+    }
+    for (Job& job : ready) {
+        done(job);
+    }
+}
+
+} // namespace X
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "../event/event_loop.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace X {
+
+/**
+ * @class QueryThread
+ * @brief Answers control socket queries off the main thread
+ *
+ * The main thread hands over a job with the framed requests of one
+ * client and goes on; the thread writes the framed replies and signals an
+ * eventfd served by the event loop, which hands the finished job back on
+ * the main thread. Taking and returning a job holds a lock only for a
+ * queue operation.
+ *
+ * Should the thread fail to start, jobs run on the main thread but still
+ * come back through the event loop.
+ */
+class QueryThread {
+public:
+    /**
+     * @struct Job
+     * @brief Queries of one client
+     */
+    struct Job {
+        int fd;              // The client descriptor
+        uint64_t peer;       // Tells a reused descriptor apart
+        std::string requests;
+        std::string replies;
+    };
+
+    /**
+     * @brief Answers the requests of a job; runs on the thread, must not log
+     */
+    using Work = std::function<void(Job& job)>;
+
+    /**
+     * @brief Takes back a finished job on the main thread
+     */
+    using Done = std::function<void(Job& job)>;
+
+    /**
+     * @brief Constructor
+     * @param loop The event loop that delivers finished jobs
+     */
+    explicit QueryThread(EventLoop& loop);
+
+    /**
+     * @brief Destructor that stops the thread; unfinished jobs are dropped
+     */
+    ~QueryThread();
+
+    QueryThread(const QueryThread&) = delete;
+    QueryThread& operator=(const QueryThread&) = delete;
+
+    /**
+     * @brief Start answering jobs
+     * @param work The function answering a job
+     * @param done The function taking back a finished job
+     * @return false if finished jobs cannot be delivered
+     */
+    bool start(Work work, Done done);
+
+    /**
+     * @brief Queue a job (main thread only)
+     * @param job The job
+     */
+    void submit(Job job);
+
+private:
+    EventLoop& loop;
+    int wakeupFd;
+    Work work;
+    Done done;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::deque<Job> jobs;       // Submitted, guarded by mutex
+    std::vector<Job> finished;  // Answered, guarded by mutex
+    bool stopping;              // Guarded by mutex
+    uint64_t submitted;
+    uint64_t largestQueue;
+
+    /**
+     * @brief Body of the thread
+     */
+    void run();
+
+    /**
+     * @brief Hand a finished job to the main thread
+     * @param job The job
+     */
+    void finish(Job job);
+
+    /**
+     * @brief Take back the finished jobs on the main thread
+     */
+    void collect();
+};
+
+} // namespace X
@@ -1,6 +1,5 @@
 #include "keyboard.h"
 #include "../../log/logger.h"
-#include <X11/keysym.h>
 
 namespace X {
 namespace Keyboard {
@@ -26,47 +25,31 @@ KeyboardHandler::~KeyboardHandler() {
     Logger::debug("Keyboard handler destroyed");
 }
 
-void KeyboardHandler::grabWMKeys() {
-    Logger::debug("Grabbing window management keys");
-    
-    // Grab Alt+Tab for window switching
-    grabKey(keysymToKeycode(XK_Tab), XCB_MOD_MASK_1);
-    
-    // Grab Alt+F4 for window closing
-    grabKey(keysymToKeycode(XK_F4), XCB_MOD_MASK_1);
-    
-    // Grab Alt+F2 for launching applications
-    grabKey(keysymToKeycode(XK_F2), XCB_MOD_MASK_1);
-    
-    // Grab Alt+Space for window menu
-    grabKey(keysymToKeycode(XK_space), XCB_MOD_MASK_1);
-    
-    // Grab Alt+F1 for main menu
-    grabKey(keysymToKeycode(XK_F1), XCB_MOD_MASK_1);
-    
-    // Grab Alt+Shift+Left/Right for moving windows between workspaces
-    grabKey(keysymToKeycode(XK_Left), XCB_MOD_MASK_1 | XCB_MOD_MASK_SHIFT);
-    grabKey(keysymToKeycode(XK_Right), XCB_MOD_MASK_1 | XCB_MOD_MASK_SHIFT);
-    
-    // Grab Alt+Left/Right for switching workspaces
-    grabKey(keysymToKeycode(XK_Left), XCB_MOD_MASK_1);
-    grabKey(keysymToKeycode(XK_Right), XCB_MOD_MASK_1);
-    
-    // Register default callbacks
-    registerKeyCallback(keysymToKeycode(XK_Tab), XCB_MOD_MASK_1, [this]() {
-        Logger::info("Alt+Tab pressed - Switch window");
-    });
-    
-    registerKeyCallback(keysymToKeycode(XK_F4), XCB_MOD_MASK_1, [this]() {
-        Logger::info("Alt+F4 pressed - Close window");
-    });
-    
-    registerKeyCallback(keysymToKeycode(XK_F2), XCB_MOD_MASK_1, [this]() {
-        Logger::info("Alt+F2 pressed - Launch application");
-    });
+size_t KeyboardHandler::rebind(std::map<std::pair<uint8_t, uint16_t>, std::function<void()>> callbacks) {
+    size_t changed = 0;
+    
+    // Both maps are sorted, so one pass finds what was added and removed
+    auto oldIt = keyCallbacks.begin();
+    auto newIt = callbacks.begin();
+    while (oldIt != keyCallbacks.end() || newIt != callbacks.end()) {
+        if (newIt == callbacks.end() || (oldIt != keyCallbacks.end() && oldIt->first < newIt->first)) {
+            ungrabKey(oldIt->first.first, oldIt->first.second);
+            ++oldIt;
+            changed++;
+        } else if (oldIt == keyCallbacks.end() || newIt->first < oldIt->first) {
+            grabKey(newIt->first.first, newIt->first.second);
+            ++newIt;
+            changed++;
+        } else {
+            ++oldIt;
+            ++newIt;
+        }
+    }
+    keyCallbacks = std::move(callbacks);
     
     // Make sure changes are applied
     connection.flush();
+    return changed;
 }
 
 bool KeyboardHandler::handleKeyPress(xcb_key_press_event_t* event) {
@@ -74,8 +57,10 @@ bool KeyboardHandler::handleKeyPress(xcb_key_press_event_t* event) {
         return false;
     }
     
-    // Create a key identifier from keycode and modifiers
-    std::pair<uint8_t, uint16_t> keyId(event->detail, event->state & 0xFF);
+    // Create a key identifier from keycode and modifiers; keys are also
+    // grabbed with Caps Lock and Num Lock, which must not matter here
+    uint16_t modifiers = event->state & 0xFF & ~(XCB_MOD_MASK_LOCK | XCB_MOD_MASK_2);
+    std::pair<uint8_t, uint16_t> keyId(event->detail, modifiers);
     
     // Look up the callback for this key combination
     auto it = keyCallbacks.find(keyId);
@@ -154,6 +139,17 @@ void KeyboardHandler::grabKey(uint8_t keycode, uint16_t modifiers) {
                  " with modifiers " + std::to_string(modifiers));
 }
 
+void KeyboardHandler::ungrabKey(uint8_t keycode, uint16_t modifiers) {
+    // The same lock variants as grabKey()
+    const uint16_t locks[] = { 0, XCB_MOD_MASK_2, XCB_MOD_MASK_LOCK, XCB_MOD_MASK_2 | XCB_MOD_MASK_LOCK };
+    for (uint16_t lock : locks) {
+        xcb_ungrab_key(connection.getConnection(), keycode, connection.getRootWindow(), modifiers | lock);
+    }
+    
+    Logger::debug("Ungrabbed keycode " + std::to_string(keycode) + 
+                 " with modifiers " + std::to_string(modifiers));
+}
+
 uint8_t KeyboardHandler::keysymToKeycode(xcb_keysym_t keysym) {
     if (!keySymbols) {
         Logger::error("Key symbols not initialized");
@@ -30,9 +30,14 @@ public:
     ~KeyboardHandler();
     
     /**
-     * @brief Grab keys used for window management shortcuts
+     * @brief Replace the key bindings
+     * @param callbacks The callback of every key combination to grab
+     * @return The number of key combinations grabbed or ungrabbed
+     *
+     * Only combinations that were not bound before are grabbed and only
+     * those no longer bound are ungrabbed.
      */
-    void grabWMKeys();
+    size_t rebind(std::map<std::pair<uint8_t, uint16_t>, std::function<void()>> callbacks);
     
     /**
      * @brief Handle a key press event
@@ -49,6 +54,13 @@ public:
      */
     void registerKeyCallback(uint8_t keycode, uint16_t modifiers, 
                             std::function<void()> callback);
+    
+    /**
+     * @brief Convert a keysym to a keycode
+     * @param keysym The keysym to convert
+     * @return The corresponding keycode
+     */
+    uint8_t keysymToKeycode(xcb_keysym_t keysym);
 
 private:
     Connection& connection;
@@ -65,11 +77,12 @@ private:
     void grabKey(uint8_t keycode, uint16_t modifiers);
     
     /**
-     * @brief Convert a keysym to a keycode
-     * @param keysym The keysym to convert
-     * @return The corresponding keycode
+     * @brief Release a key grabbed with grabKey()
+     * @param keycode The keycode to release
+     * @param modifiers The modifier mask
      */
-    uint8_t keysymToKeycode(xcb_keysym_t keysym);
+    void ungrabKey(uint8_t keycode, uint16_t modifiers);
+    
 };
 
 } // namespace Keyboard
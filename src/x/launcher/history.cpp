@@ -0,0 +1,298 @@
+#include "history.h"
+#include "../../log/logger.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace X {
+
+namespace {
+
+constexpr uint32_t kMagic = 0x484c5744;        // "DWLH"
+constexpr uint32_t kVersion = 1;
+constexpr uint16_t kSlotCount = 256;
+constexpr size_t kCommandCapacity = 222;
+constexpr int kProbeLimit = 8;                  // Bounded probe keeps lookups O(1)
+constexpr double kHalfLifeSeconds = 3 * 24 * 60 * 60;
+
+uint32_t fnv1a(const void* data, size_t length, uint32_t hash = 2166136261u) {
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+} // namespace
+
+struct LaunchHistory::Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t slotSize;
+    uint8_t reserved[48];
+};
+
+struct LaunchHistory::Slot {
+    uint32_t seq;           // Odd while the slot is being written, 0 if never used
+    uint32_t checksum;      // FNV-1a over everything after this field
+    uint32_t hash;          // Hash of the command
+    uint32_t count;         // Number of launches
+    int64_t lastUsed;       // Unix time of the last launch
+    double score;           // Frecency score as of lastUsed
+    uint16_t length;        // Length of the command
+    char command[kCommandCapacity];
+};
+
+namespace {
+
+// Covers every field after seq and checksum
+uint32_t slotChecksum(const void* slot, size_t size) {
+    auto bytes = static_cast<const unsigned char*>(slot);
+    size_t offset = 2 * sizeof(uint32_t);
+    return fnv1a(bytes + offset, size - offset);
+}
+
+} // namespace
+
+LaunchHistory::LaunchHistory(const std::string& path)
+    : path(path), fd(-1), mapping(nullptr), mappingSize(0),
+      header(nullptr), slots(nullptr) {
+    static_assert(sizeof(Header) == 64, "history header layout changed");
+    static_assert(sizeof(Slot) == 256, "history slot layout changed");
+
+    if (this->path.empty()) {
+        const char* homeDir = std::getenv("HOME");
+        if (homeDir) {
+            this->path = (std::filesystem::path(homeDir) / ".config" / "doowm" /
+                          "launch_history").string();
+        }
+    }
+
+    if (this->path.empty() || !open()) {
+        Logger::warning("Launch history disabled");
+        return;
+    }
+
+    load();
+    Logger::debug("Launch history loaded: " + std::to_string(ranking.size()) +
+                  " commands from " + this->path);
+}
+
+LaunchHistory::~LaunchHistory() {
+    if (mapping) {
+        // Let the kernel write the pages back; unmapping does not wait for it
+        msync(mapping, mappingSize, MS_ASYNC);
+        munmap(mapping, mappingSize);
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+bool LaunchHistory::open() {
+    try {
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+    } catch (const std::exception& e) {
+        Logger::warning("Failed to create history directory: " + std::string(e.what()));
+        return false;
+    }
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        Logger::warning("Failed to open launch history: " + path);
+        return false;
+    }
+
+    mappingSize = sizeof(Header) + kSlotCount * sizeof(Slot);
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        Logger::warning("Failed to stat launch history: " + path);
+        return false;
+    }
+
+    bool fresh = static_cast<size_t>(st.st_size) != mappingSize;
+    if (fresh) {
+        // Unknown size means an older or foreign layout: start over
+        if (ftruncate(fd, 0) < 0 || ftruncate(fd, mappingSize) < 0) {
+            Logger::warning("Failed to size launch history: " + path);
+            return false;
+        }
+    }
+
+    mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        Logger::warning("Failed to map launch history: " + path);
+        return false;
+    }
+
+    header = static_cast<Header*>(mapping);
+    slots = reinterpret_cast<Slot*>(static_cast<char*>(mapping) + sizeof(Header));
+
+    if (fresh || header->magic != kMagic || header->version != kVersion ||
+        header->slotCount != kSlotCount || header->slotSize != sizeof(Slot)) {
+        std::memset(mapping, 0, mappingSize);
+        header->magic = kMagic;
+        header->version = kVersion;
+        header->slotCount = kSlotCount;
+        header->slotSize = sizeof(Slot);
+    }
+
+    return true;
+}
+
+void LaunchHistory::load() {
+    ranking.clear();
+    for (uint16_t i = 0; i < kSlotCount; i++) {
+        if (isValid(slots[i])) {
+            ranking.push_back(i);
+        } else if (slots[i].seq != 0) {
+            // Torn by a crash mid-write: forget it
+            std::memset(&slots[i], 0, sizeof(Slot));
+        }
+    }
+
+    std::sort(ranking.begin(), ranking.end(), [this](uint16_t a, uint16_t b) {
+        return rankKey(slots[a]) > rankKey(slots[b]);
+    });
+}
+
+void LaunchHistory::record(const std::string& command) {
+    if (!slots || command.empty()) {
+        return;
+    }
+    if (command.size() > kCommandCapacity) {
+        Logger::debug("Command too long for launch history: " + command);
+        return;
+    }
+
+    uint32_t hash = fnv1a(command.data(), command.size());
+    int64_t now = std::time(nullptr);
+
+    uint16_t index = findSlot(hash, command);
+    Slot& slot = slots[index];
+
+    bool existing = isValid(slot) && slot.hash == hash &&
+                    command.compare(0, std::string::npos, slot.command, slot.length) == 0;
+
+    double score = 1.0;
+    uint32_t count = 1;
+    if (existing) {
+        double elapsed = static_cast<double>(std::max<int64_t>(0, now - slot.lastUsed));
+        score += slot.score * std::exp2(-elapsed / kHalfLifeSeconds);
+        count = slot.count + 1;
+    }
+
+    // Odd sequence marks the slot as in-flight until the final store
+    slot.seq |= 1;
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.hash = hash;
+    slot.count = count;
+    slot.lastUsed = now;
+    slot.score = score;
+    slot.length = static_cast<uint16_t>(command.size());
+    std::memset(slot.command, 0, sizeof(slot.command));
+    std::memcpy(slot.command, command.data(), command.size());
+    slot.checksum = slotChecksum(&slot, sizeof(Slot));
+
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.seq += 1;
+
+    // MS_ASYNC only schedules writeback, it never waits for the disk
+    long pageSize = sysconf(_SC_PAGESIZE);
+    auto address = reinterpret_cast<uintptr_t>(&slot);
+    auto page = address & ~static_cast<uintptr_t>(pageSize - 1);
+    msync(reinterpret_cast<void*>(page), address + sizeof(Slot) - page, MS_ASYNC);
+
+    rerank(index);
+}
+
+std::vector<std::string> LaunchHistory::top(size_t count) const {
+    std::vector<std::string> result;
+    for (size_t i = 0; i < ranking.size() && result.size() < count; i++) {
+        const Slot& slot = slots[ranking[i]];
+        result.emplace_back(slot.command, slot.length);
+    }
+    return result;
+}
+
+std::string LaunchHistory::bestMatch(const std::string& prefix) const {
+    for (uint16_t index : ranking) {
+        const Slot& slot = slots[index];
+        if (slot.length >= prefix.size() &&
+            std::memcmp(slot.command, prefix.data(), prefix.size()) == 0) {
+            return std::string(slot.command, slot.length);
+        }
+    }
+    return "";
+}
+
+uint16_t LaunchHistory::findSlot(uint32_t hash, const std::string& command) const {
+    uint16_t victim = hash % kSlotCount;
+    bool victimFree = false;
+
+    for (int probe = 0; probe < kProbeLimit; probe++) {
+        uint16_t index = (hash + probe) % kSlotCount;
+        const Slot& slot = slots[index];
+
+        if (!isValid(slot)) {
+            if (!victimFree) {
+                victim = index;
+                victimFree = true;
+            }
+            continue;
+        }
+
+        if (slot.hash == hash &&
+            command.compare(0, std::string::npos, slot.command, slot.length) == 0) {
+            return index;
+        }
+
+        // Evict the least frecent entry in the window when it is full
+        if (!victimFree && rankKey(slot) < rankKey(slots[victim])) {
+            victim = index;
+        }
+    }
+
+    return victim;
+}
+
+void LaunchHistory::rerank(uint16_t index) {
+    auto current = std::find(ranking.begin(), ranking.end(), index);
+    if (current != ranking.end()) {
+        ranking.erase(current);
+    }
+
+    // The decay factor is shared by every entry, so the relative order of
+    // untouched entries never changes and only this one needs to move
+    double key = rankKey(slots[index]);
+    auto position = std::find_if(ranking.begin(), ranking.end(), [this, key](uint16_t other) {
+        return rankKey(slots[other]) < key;
+    });
+    ranking.insert(position, index);
+}
+
+bool LaunchHistory::isValid(const Slot& slot) {
+    return slot.seq != 0 && (slot.seq & 1) == 0 &&
+           slot.length > 0 && slot.length <= kCommandCapacity &&
+           slot.checksum == slotChecksum(&slot, sizeof(Slot));
+}
+
+double LaunchHistory::rankKey(const Slot& slot) {
+    // score * 2^(-(now - lastUsed) / halfLife) ordered without knowing now
+    return std::log2(slot.score) + static_cast<double>(slot.lastUsed) / kHalfLifeSeconds;
+}
+
+} // namespace X
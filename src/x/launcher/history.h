@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace X {
+
+/**
+ * @class LaunchHistory
+ * @brief Frecency-ranked history of launched commands
+ *
+ * Commands are stored in a small fixed-layout file that is memory-mapped
+ * into the process, so recording a launch is a handful of stores into
+ * the mapping. The kernel writes the dirty page back on its own; the
+ * history never calls fsync on the event loop.
+ *
+ * Each slot is guarded by a sequence number and a checksum. A slot that
+ * was only partially written when the process died is discarded on the
+ * next load instead of corrupting the ranking.
+ */
+class LaunchHistory {
+public:
+    /**
+     * @brief Constructor
+     * @param path Path to the history file (optional)
+     *
+     * Uses ~/.config/doowm/launch_history when no path is given. If the
+     * file cannot be mapped the history stays disabled and every
+     * operation becomes a no-op.
+     */
+    LaunchHistory(const std::string& path = "");
+
+    /**
+     * @brief Destructor that unmaps the history file
+     */
+    ~LaunchHistory();
+
+    LaunchHistory(const LaunchHistory&) = delete;
+    LaunchHistory& operator=(const LaunchHistory&) = delete;
+
+    /**
+     * @brief Check if the history file is mapped
+     * @return true if the history is usable, false otherwise
+     */
+    bool isOpen() const { return slots != nullptr; }
+
+    /**
+     * @brief Record a launch of a command
+     * @param command The command that was launched
+     *
+     * Runs in constant time: the slot lookup probes a bounded window and
+     * only the updated entry moves in the ranking.
+     */
+    void record(const std::string& command);
+
+    /**
+     * @brief Get the highest ranked commands
+     * @param count Maximum number of commands to return
+     * @return Commands ordered from most to least frecent
+     */
+    std::vector<std::string> top(size_t count) const;
+
+    /**
+     * @brief Find the highest ranked command starting with a prefix
+     * @param prefix The prefix typed so far
+     * @return The best matching command or an empty string
+     */
+    std::string bestMatch(const std::string& prefix) const;
+
+private:
+    struct Header;
+    struct Slot;
+
+    std::string path;
+    int fd;
+    void* mapping;
+    size_t mappingSize;
+    Header* header;
+    Slot* slots;
+
+    // Indices of live slots, most frecent first
+    std::vector<uint16_t> ranking;
+
+    /**
+     * @brief Map the history file, creating it if needed
+     * @return true if the file was mapped, false otherwise
+     */
+    bool open();
+
+    /**
+     * @brief Rebuild the ranking from the slots, dropping torn ones
+     */
+    void load();
+
+    /**
+     * @brief Find the slot for a command, or the slot to reuse for it
+     * @param hash Hash of the command
+     * @param command The command
+     * @return Index of the slot
+     */
+    uint16_t findSlot(uint32_t hash, const std::string& command) const;
+
+    /**
+     * @brief Move a slot to its position in the ranking
+     * @param index Index of the slot
+     */
+    void rerank(uint16_t index);
+
+    /**
+     * @brief Check if a slot holds a complete entry
+     * @param slot The slot to check
+     * @return true if the slot is live and its checksum matches
+     */
+    static bool isValid(const Slot& slot);
+
+    /**
+     * @brief Get the time-independent ranking key of a slot
+     * @param slot The slot
+     * @return The ranking key (larger is more frecent)
+     */
+    static double rankKey(const Slot& slot);
+};
+
+} // namespace X
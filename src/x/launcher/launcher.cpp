@@ -1,17 +1,15 @@
 #include "launcher.h"
 #include "../../log/logger.h"
+#include "../process/spawner.h"
 #include <xcb/xcb_aux.h>
 #include <xcb/xcb_icccm.h>
 #include <cstdlib>
-#include <unistd.h>
-#include <sys/types.h>
-#include <sys/wait.h>
 
 namespace X {
 
 Launcher::Launcher(Connection& connection)
-    : connection(connection), visible(false) {
-    createWindow();
+    : connection(connection), window(0), visible(false) {
+    // The window is created on first use to keep it off the startup path
     Logger::debug("Launcher initialized");
 }
 
@@ -25,9 +23,14 @@ Launcher::~Launcher() {
 }
 
 void Launcher::show() {
+    if (!window) {
+        createWindow();
+    }
+    
     if (!visible) {
         // Clear the command
         command.clear();
+        updateSuggestion();
         
         // Map the window
         xcb_map_window(connection.getConnection(), window);
@@ -97,6 +100,15 @@ bool Launcher::handleKeyPress(xcb_key_press_event_t* event) {
         case 22: // Backspace key
             if (!command.empty()) {
                 command.pop_back();
+                updateSuggestion();
+                draw();
+            }
+            return true;
+            
+        case 23: // Tab key
+            // Accept the suggested command from the history
+            if (!suggestion.empty()) {
+                command = suggestion;
                 draw();
             }
             return true;
@@ -126,6 +138,7 @@ bool Launcher::handleKeyPress(xcb_key_press_event_t* event) {
             
             if (key) {
                 command += key;
+                updateSuggestion();
                 draw();
                 return true;
             }
@@ -154,7 +167,7 @@ void Launcher::createWindow() {
     values[1] = XCB_EVENT_MASK_EXPOSURE | XCB_EVENT_MASK_KEY_PRESS;  // Events to receive
     
     // Create the window
-    xcb_create_window(
+    auto cookie = xcb_create_window(
         connection.getConnection(),
         XCB_COPY_FROM_PARENT,  // Depth
         window,                 // Window ID
@@ -166,6 +179,7 @@ void Launcher::createWindow() {
         connection.getScreen()->root_visual,  // Visual
         mask, values            // Attributes
     );
+    connection.track(cookie, ErrorTracker::Request::CreateWindow, window);
     
     // Set window title
     xcb_change_property(
@@ -179,18 +193,8 @@ void Launcher::createWindow() {
         "Run Command"
     );
     
-    // Check if window creation was successful
-    auto cookie = xcb_get_window_attributes(connection.getConnection(), window);
-    auto reply = xcb_get_window_attributes_reply(connection.getConnection(), cookie, nullptr);
-    
-    if (!reply) {
-        Logger::error("Failed to create launcher window");
-        window = 0;  // Set to invalid window ID
-        return;
-    }
-    
-    free(reply);
-    
+    // No round trip to verify creation: it is mapped right after this,
+    // and a failure would surface as an asynchronous X error
     connection.flush();
     Logger::debug("Launcher window created");
 }
@@ -235,47 +239,46 @@ void Launcher::draw() {
         displayText.c_str()
     );
     
+    // Draw the history suggestion below the input
+    if (!suggestion.empty() && suggestion != command) {
+        std::string hintText = "Tab: " + suggestion;
+        xcb_image_text_8(
+            connection.getConnection(),
+            hintText.length(),
+            window,
+            gc,
+            10, 40,     // x, y position for text
+            hintText.c_str()
+        );
+    }
+    
     // Free the graphics context
     xcb_free_gc(connection.getConnection(), gc);
     
     connection.flush();
 }
 
+void Launcher::updateSuggestion() {
+    // The ranking is kept sorted as launches are recorded, so this is a
+    // scan of at most a few hundred entries and never touches the disk
+    suggestion = history.bestMatch(command);
+}
+
 void Launcher::executeCommand() {
     if (command.empty()) {
         return;
     }
     
     Logger::info("Executing command: " + command);
+    history.record(command);
     
     // Call the callback if set
     if (executeCallback) {
         executeCallback(command);
     } else {
-        // Default implementation: fork and exec
-        pid_t pid = fork();
-        
-        if (pid == 0) {
-            // Child process
-            
-            // Close X connection in the child
-            connection.close();
-            
-            // Execute the command
-            // Note: This is a very simple implementation
-            // In a real application, you would want to parse the command properly
-            execl("/bin/sh", "sh", "-c", command.c_str(), nullptr);
-            
-            // If execl returns, there was an error
-            exit(1);
-        } else if (pid < 0) {
-            // Fork failed
-            Logger::error("Failed to fork process for command: " + command);
-        } else {
-            // Parent process
-            // We don't wait for the child to complete
-            Logger::debug("Launched command with PID: " + std::to_string(pid));
-        }
+        // Default implementation: launch without a shared spawner
+        Spawner spawner;
+        spawner.spawn(command);
     }
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../connection/connection.h"
+#include "history.h"
 #include <string>
 #include <functional>
 #include <xcb/xcb.h>
@@ -60,6 +61,8 @@ private:
     xcb_window_t window;
     bool visible;
     std::string command;
+    std::string suggestion;                // Most frecent command matching the input
+    LaunchHistory history;
     std::function<void(const std::string&)> executeCallback;
     
     /**
@@ -72,6 +75,11 @@ private:
      */
     void draw();
     
+    /**
+     * @brief Refresh the completion suggestion for the current input
+     */
+    void updateSuggestion();
+    
     /**
      * @brief Execute the current command
      */
@@ -0,0 +1,328 @@
+#include "layout.h"
+#include "../../log/logger.h"
+#include <algorithm>
+
+namespace X {
+
+namespace {
+
+constexpr float kMinRatio = 0.1f;
+constexpr float kMaxRatio = 0.9f;
+
+float clampRatio(float ratio) {
+    return std::min(kMaxRatio, std::max(kMinRatio, ratio));
+}
+
+} // namespace
+
+Layout::Layout(const Rect& area, Mode mode, unsigned int borderWidth)
+    : area(area),
+      mode(mode),
+      borderWidth(borderWidth),
+      masterCount(1),
+      masterRatio(0.55f),
+      masterDirty(false),
+      stackDirty(false),
+      insertAt(nullptr),
+      relayoutStats("Relayout") {
+    Logger::debug(std::string("Layout initialized in ") +
+                  (mode == Mode::SplitTree ? "split tree" : "master/stack") + " mode");
+}
+
+Layout::~Layout() {
+    if (relayoutStats.count()) {
+        Logger::info(relayoutStats.summary());
+    }
+}
+
+void Layout::insert(Client* client) {
+    if (contains(client)) {
+        return;
+    }
+
+    order.push_back(client);
+    if (mode == Mode::SplitTree) {
+        insertLeaf(client);
+    } else {
+        markColumns(order.size() - 1, order.size() - 1);
+    }
+}
+
+bool Layout::remove(Client* client) {
+    auto it = std::find(order.begin(), order.end(), client);
+    if (it == order.end()) {
+        return false;
+    }
+
+    size_t index = it - order.begin();
+    order.erase(it);
+    if (mode == Mode::SplitTree) {
+        removeLeaf(leaves.at(client));
+    } else {
+        markColumns(index, order.size() + 1);
+    }
+    return true;
+}
+
+bool Layout::contains(const Client* client) const {
+    return std::find(order.begin(), order.end(), client) != order.end();
+}
+
+void Layout::adjustRatio(Client* client, float delta) {
+    if (mode == Mode::SplitTree) {
+        auto it = leaves.find(client);
+        if (it == leaves.end() || !it->second->parent) {
+            return;
+        }
+        Node* leaf = it->second;
+        Node* split = leaf->parent;
+
+        // The ratio is the share of the first child
+        float grow = split->first.get() == leaf ? delta : -delta;
+        split->ratio = clampRatio(split->ratio + grow);
+        markDirty(split);
+        return;
+    }
+
+    auto it = std::find(order.begin(), order.end(), client);
+    if (it == order.end()) {
+        return;
+    }
+    bool isMaster = static_cast<size_t>(it - order.begin()) < masterCount;
+    masterRatio = clampRatio(masterRatio + (isMaster ? delta : -delta));
+    masterDirty = stackDirty = true;
+}
+
+void Layout::setArea(const Rect& newArea) {
+    if (newArea == area) {
+        return;
+    }
+    area = newArea;
+    masterDirty = stackDirty = true;
+    if (root) {
+        root->rect = area;
+        markDirty(root.get());
+    }
+}
+
+void Layout::setBorderWidth(unsigned int width) {
+    if (width == borderWidth) {
+        return;
+    }
+    borderWidth = width;
+    masterDirty = stackDirty = true;
+    if (root) {
+        markDirty(root.get());
+    }
+}
+
+void Layout::setMode(Mode newMode) {
+    if (newMode == mode) {
+        return;
+    }
+    mode = newMode;
+
+    root.reset();
+    leaves.clear();
+    insertAt = nullptr;
+    if (mode == Mode::SplitTree) {
+        for (Client* client : order) {
+            insertLeaf(client);
+        }
+    } else {
+        masterDirty = stackDirty = true;
+    }
+}
+
+size_t Layout::apply() {
+    uint64_t start = LatencyStats::nowMicros();
+
+    size_t moved = 0;
+    if (mode == Mode::SplitTree) {
+        if (root) {
+            visit(root.get(), moved);
+        }
+    } else if (masterDirty || stackDirty) {
+        moved = applyMasterStack();
+    } else {
+        return 0;
+    }
+
+    relayoutStats.record(LatencyStats::nowMicros() - start);
+    if (moved) {
+        Logger::debug("Relayout configured " + std::to_string(moved) + " of " +
+                      std::to_string(order.size()) + " windows");
+    }
+    return moved;
+}
+
+void Layout::markColumns(size_t index, size_t oldCount) {
+    // Column sizes before and after the change
+    size_t oldMasters = std::min(masterCount, oldCount);
+    size_t oldStack = oldCount - oldMasters;
+    size_t masters = std::min(masterCount, order.size());
+    size_t stack = order.size() - masters;
+
+    // The master column changes when a master comes or goes, or when the
+    // stack column appears or disappears and the master width with it
+    if (index < oldMasters || masters != oldMasters || (stack == 0) != (oldStack == 0)) {
+        masterDirty = true;
+    }
+    if (stack != oldStack || index < oldMasters) {
+        stackDirty = true;
+    }
+}
+
+size_t Layout::applyMasterStack() {
+    size_t masters = std::min(masterCount, order.size());
+    size_t stack = order.size() - masters;
+    unsigned int masterWidth = stack ? static_cast<unsigned int>(area.width * masterRatio) : area.width;
+
+    size_t moved = 0;
+    if (masterDirty) {
+        layoutColumn(0, masters, area.x, masterWidth, moved);
+    }
+    if (stackDirty && stack) {
+        layoutColumn(masters, order.size(), area.x + static_cast<int>(masterWidth),
+                     area.width - masterWidth, moved);
+    }
+    masterDirty = stackDirty = false;
+    return moved;
+}
+
+void Layout::layoutColumn(size_t begin, size_t end, int x, unsigned int width, size_t& moved) {
+    // Split the height evenly, spreading the remainder over the column
+    size_t count = end - begin;
+    for (size_t i = 0; i < count; i++) {
+        int top = area.y + static_cast<int>(area.height * i / count);
+        int bottom = area.y + static_cast<int>(area.height * (i + 1) / count);
+        Rect rect{ x, top, width, static_cast<unsigned int>(bottom - top) };
+        if (order[begin + i]->place(rect, borderWidth)) {
+            moved++;
+        }
+    }
+}
+
+void Layout::insertLeaf(Client* client) {
+    auto leaf = std::make_unique<Node>();
+    leaf->client = client;
+    leaf->ratio = 0.5f;
+    Node* added = leaf.get();
+    leaves[client] = added;
+
+    if (!root) {
+        leaf->parent = nullptr;
+        leaf->rect = area;
+        root = std::move(leaf);
+        markDirty(added);
+        insertAt = added;
+        return;
+    }
+
+    // Replace the target leaf with a split holding it and the new client
+    Node* target = insertAt ? insertAt : firstLeaf(root.get());
+    std::unique_ptr<Node>& slot = slotOf(target);
+
+    auto split = std::make_unique<Node>();
+    split->parent = target->parent;
+    split->client = nullptr;
+    split->rect = target->rect;
+    split->sideBySide = target->rect.width >= target->rect.height;
+    split->ratio = 0.5f;
+    Node* splitNode = split.get();
+
+    split->first = std::move(slot);
+    split->first->parent = splitNode;
+    leaf->parent = splitNode;
+    split->second = std::move(leaf);
+    slot = std::move(split);
+
+    markDirty(splitNode);
+    insertAt = added;
+}
+
+void Layout::removeLeaf(Node* leaf) {
+    leaves.erase(leaf->client);
+    Node* split = leaf->parent;
+    if (!split) {
+        root.reset();
+        insertAt = nullptr;
+        return;
+    }
+
+    // The sibling takes over the space of the split
+    std::unique_ptr<Node> sibling =
+        std::move(split->first.get() == leaf ? split->second : split->first);
+    sibling->parent = split->parent;
+    sibling->rect = split->rect;
+    Node* survivor = sibling.get();
+    slotOf(split) = std::move(sibling);
+
+    if (insertAt == leaf) {
+        insertAt = firstLeaf(survivor);
+    }
+    markDirty(survivor);
+}
+
+std::unique_ptr<Layout::Node>& Layout::slotOf(Node* node) {
+    if (!node->parent) {
+        return root;
+    }
+    return node->parent->first.get() == node ? node->parent->first : node->parent->second;
+}
+
+void Layout::markDirty(Node* node) {
+    node->dirty = true;
+    for (Node* parent = node->parent; parent && !parent->dirtyBelow; parent = parent->parent) {
+        parent->dirtyBelow = true;
+    }
+}
+
+void Layout::visit(Node* node, size_t& moved) {
+    if (node->dirty) {
+        layoutSubtree(node, node->rect, moved);
+        return;
+    }
+    if (!node->dirtyBelow) {
+        return;
+    }
+    node->dirtyBelow = false;
+    visit(node->first.get(), moved);
+    visit(node->second.get(), moved);
+}
+
+void Layout::layoutSubtree(Node* node, const Rect& rect, size_t& moved) {
+    node->rect = rect;
+    node->dirty = false;
+    node->dirtyBelow = false;
+
+    if (node->client) {
+        if (node->client->place(rect, borderWidth)) {
+            moved++;
+        }
+        return;
+    }
+
+    Rect first = rect;
+    Rect second = rect;
+    if (node->sideBySide) {
+        first.width = static_cast<unsigned int>(rect.width * node->ratio);
+        second.x = rect.x + static_cast<int>(first.width);
+        second.width = rect.width - first.width;
+    } else {
+        first.height = static_cast<unsigned int>(rect.height * node->ratio);
+        second.y = rect.y + static_cast<int>(first.height);
+        second.height = rect.height - first.height;
+    }
+    layoutSubtree(node->first.get(), first, moved);
+    layoutSubtree(node->second.get(), second, moved);
+}
+
+Layout::Node* Layout::firstLeaf(Node* node) {
+    while (!node->client) {
+        node = node->first.get();
+    }
+    return node;
+}
+
+} // namespace X
@@ -0,0 +1,221 @@
+#pragma once
+
+#include "rect.h"
+#include "../client/client.h"
+#include "../../log/latency_stats.h"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace X {
+
+/**
+ * @class Layout
+ * @brief Tiles clients over an area
+ *
+ * Two modes are available. Master/stack puts the first client in a master
+ * column and splits the rest evenly in a stack column. Split tree divides
+ * the space of the last inserted client between it and the new one, along
+ * its longer side, and keeps the splits in a binary tree.
+ *
+ * Changes only mark the part they affect: a column in master/stack, the
+ * subtree under the changed split in the tree. apply() recomputes just
+ * those parts and queues a configure request for each client whose
+ * rectangle actually changed, without flushing, so the whole relayout
+ * reaches the server in the event loop's next flush.
+ */
+class Layout {
+public:
+    enum class Mode {
+        MasterStack,
+        SplitTree,
+    };
+
+    /**
+     * @brief Constructor
+     * @param area The area to tile
+     * @param mode The tiling mode
+     * @param borderWidth Border width of tiled clients
+     */
+    Layout(const Rect& area, Mode mode, unsigned int borderWidth);
+
+    /**
+     * @brief Destructor
+     */
+    ~Layout();
+
+    Layout(const Layout&) = delete;
+    Layout& operator=(const Layout&) = delete;
+
+    /**
+     * @brief Add a client to the layout
+     * @param client The client
+     */
+    void insert(Client* client);
+
+    /**
+     * @brief Remove a client from the layout
+     * @param client The client
+     * @return true if the client was tiled, false otherwise
+     */
+    bool remove(Client* client);
+
+    /**
+     * @brief Check if a client is tiled
+     * @param client The client
+     * @return true if the client is part of the layout
+     */
+    bool contains(const Client* client) const;
+
+    /**
+     * @brief Grow or shrink the space of a client
+     * @param client The client
+     * @param delta Fraction of the enclosing split to add, negative to shrink
+     */
+    void adjustRatio(Client* client, float delta);
+
+    /**
+     * @brief Change the area to tile
+     * @param area The new area
+     */
+    void setArea(const Rect& area);
+
+    /**
+     * @brief Change the tiling mode
+     * @param mode The new mode
+     */
+    void setMode(Mode mode);
+
+    /**
+     * @brief Change the border width of tiled clients
+     * @param width The new border width
+     */
+    void setBorderWidth(unsigned int width);
+
+    /**
+     * @brief Recompute the changed parts and queue the configure requests
+     * @return The number of clients that were moved or resized
+     */
+    size_t apply();
+
+    /**
+     * @brief Get the number of tiled clients
+     * @return The number of clients
+     */
+    size_t size() const { return order.size(); }
+
+    /**
+     * @brief Get the border width of tiled clients
+     * @return The border width
+     */
+    unsigned int getBorderWidth() const { return borderWidth; }
+
+    /**
+     * @brief Get the tiled clients
+     * @return The clients in insertion order, master first
+     */
+    const std::vector<Client*>& getClients() const { return order; }
+
+private:
+    struct Node {
+        Node* parent;
+        std::unique_ptr<Node> first;    // Left or top
+        std::unique_ptr<Node> second;   // Right or bottom
+        Client* client;                 // Set for leaves only
+        bool sideBySide;                // Split along the x axis
+        float ratio;                    // Share of the first child
+        Rect rect;
+        bool dirty;                     // Subtree must be recomputed
+        bool dirtyBelow;                // Some descendant is dirty
+    };
+
+    Rect area;
+    Mode mode;
+    unsigned int borderWidth;
+    std::vector<Client*> order;
+
+    // Master/stack state
+    size_t masterCount;
+    float masterRatio;
+    bool masterDirty;
+    bool stackDirty;
+
+    // Split tree state
+    std::unique_ptr<Node> root;
+    std::unordered_map<const Client*, Node*> leaves;
+    Node* insertAt;   // Leaf split by the next insertion
+
+    LatencyStats relayoutStats;
+
+    /**
+     * @brief Mark the master/stack columns touched by an insert or removal
+     * @param index Position of the client that was added or removed
+     * @param oldCount Number of clients before the change
+     */
+    void markColumns(size_t index, size_t oldCount);
+
+    /**
+     * @brief Stack clients evenly in a column
+     * @param begin Index of the first client
+     * @param end Index past the last client
+     * @param x Left edge of the column
+     * @param width Width of the column
+     * @param moved Incremented for every client that was configured
+     */
+    void layoutColumn(size_t begin, size_t end, int x, unsigned int width, size_t& moved);
+
+    /**
+     * @brief Recompute the dirty columns
+     * @return The number of clients that were configured
+     */
+    size_t applyMasterStack();
+
+    /**
+     * @brief Add a client to the split tree
+     * @param client The client
+     */
+    void insertLeaf(Client* client);
+
+    /**
+     * @brief Remove a leaf, giving its space to its sibling
+     * @param leaf The leaf
+     */
+    void removeLeaf(Node* leaf);
+
+    /**
+     * @brief Get the owning pointer of a node
+     * @param node The node
+     * @return The parent's child pointer, or the root pointer
+     */
+    std::unique_ptr<Node>& slotOf(Node* node);
+
+    /**
+     * @brief Mark a subtree for recomputation
+     * @param node The root of the subtree
+     */
+    void markDirty(Node* node);
+
+    /**
+     * @brief Recompute the dirty subtrees below a node
+     * @param node The node
+     * @param moved Incremented for every client that was configured
+     */
+    void visit(Node* node, size_t& moved);
+
+    /**
+     * @brief Lay out a subtree in a rectangle
+     * @param node The root of the subtree
+     * @param rect The rectangle
+     * @param moved Incremented for every client that was configured
+     */
+    void layoutSubtree(Node* node, const Rect& rect, size_t& moved);
+
+    /**
+     * @brief Find the leftmost leaf of a subtree
+     * @param node The root of the subtree
+     * @return The leaf
+     */
+    static Node* firstLeaf(Node* node);
+};
+
+} // namespace X
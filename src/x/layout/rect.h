@@ -0,0 +1,23 @@
+#pragma once
+
+namespace X {
+
+/**
+ * @struct Rect
+ * @brief A rectangle on the screen
+ */
+struct Rect {
+    int x;
+    int y;
+    unsigned int width;
+    unsigned int height;
+
+    bool operator==(const Rect& other) const {
+        return x == other.x && y == other.y &&
+               width == other.width && height == other.height;
+    }
+
+    bool operator!=(const Rect& other) const { return !(*this == other); }
+};
+
+} // namespace X
@@ -0,0 +1,229 @@
+#include "monitor_manager.h"
+#include "../../log/logger.h"
+#include "../async/async_requests.h"
+#include <algorithm>
+
+namespace X {
+
+MonitorManager::MonitorManager(Connection& connection)
+    : connection(connection), available(false), firstEvent(0), stale(false), primary(0) {
+    xcb_connection_t* conn = connection.getConnection();
+    const xcb_query_extension_reply_t* extension = xcb_get_extension_data(conn, &xcb_randr_id);
+    Query pending = {};
+    if (extension && extension->present) {
+        // Asked before knowing the version; a server older than 1.5
+        // fails GetMonitors and the replies are dropped
+        auto versionCookie = xcb_randr_query_version(conn, 1, 5);
+        pending = query();
+        ReplyPtr<xcb_randr_query_version_reply_t> version(
+            xcb_randr_query_version_reply(conn, versionCookie, nullptr));
+        available = version && (version->major_version > 1 ||
+                                (version->major_version == 1 && version->minor_version >= 5));
+        if (!available) {
+            xcb_discard_reply(conn, pending.monitors.sequence);
+            xcb_discard_reply(conn, pending.resources.sequence);
+        }
+    }
+
+    if (available) {
+        firstEvent = extension->first_event;
+        xcb_randr_select_input(conn, connection.getRootWindow(),
+                               XCB_RANDR_NOTIFY_MASK_SCREEN_CHANGE |
+                               XCB_RANDR_NOTIFY_MASK_CRTC_CHANGE |
+                               XCB_RANDR_NOTIFY_MASK_OUTPUT_CHANGE);
+    } else {
+        Logger::info("RandR 1.5 not available, using the whole screen as one monitor");
+    }
+    read(pending);
+}
+
+void MonitorManager::prefetchExtension(Connection& connection) {
+    xcb_prefetch_extension_data(connection.getConnection(), &xcb_randr_id);
+}
+
+bool MonitorManager::refresh() {
+    return read(available ? query() : Query{});
+}
+
+MonitorManager::Query MonitorManager::query() {
+    xcb_connection_t* conn = connection.getConnection();
+    xcb_window_t root = connection.getRootWindow();
+    return Query{ xcb_randr_get_monitors(conn, root, 1), xcb_randr_get_screen_resources_current(conn, root) };
+}
+
+bool MonitorManager::read(const Query& pending) {
+    xcb_connection_t* conn = connection.getConnection();
+    std::vector<Monitor> found;
+    std::vector<xcb_randr_output_t> outputs;
+
+    if (available) {
+        ReplyPtr<xcb_randr_get_monitors_reply_t> reply(
+            xcb_randr_get_monitors_reply(conn, pending.monitors, nullptr));
+        if (reply) {
+            auto it = xcb_randr_get_monitors_monitors_iterator(reply.get());
+            for (; it.rem; xcb_randr_monitor_info_next(&it)) {
+                const xcb_randr_monitor_info_t* info = it.data;
+                found.push_back({ info->name, Rect{ info->x, info->y, info->width, info->height },
+                                  info->primary != 0, 0 });
+                outputs.push_back(info->nOutput
+                                  ? xcb_randr_monitor_info_outputs(info)[0]
+                                  : static_cast<xcb_randr_output_t>(XCB_NONE));
+            }
+            readRefreshRates(found, outputs, pending.resources);
+        } else {
+            xcb_discard_reply(conn, pending.resources.sequence);
+        }
+    }
+
+    if (found.empty()) {
+        xcb_screen_t* screen = connection.getScreen();
+        found.push_back({ XCB_ATOM_NONE, Rect{ 0, 0, screen->width_in_pixels, screen->height_in_pixels },
+                          true, 0 });
+    }
+
+    if (found == monitors) {
+        return false;
+    }
+    monitors = std::move(found);
+
+    primary = 0;
+    for (size_t i = 0; i < monitors.size(); i++) {
+        if (monitors[i].primary) {
+            primary = i;
+            break;
+        }
+    }
+    buildIndex();
+
+    for (const Monitor& monitor : monitors) {
+        Logger::info("Monitor " + std::to_string(monitor.area.width) + "x" +
+                     std::to_string(monitor.area.height) + "+" + std::to_string(monitor.area.x) +
+                     "+" + std::to_string(monitor.area.y) +
+                     (monitor.refreshHz ? " at " + std::to_string(monitor.refreshHz) + "Hz" : "") +
+                     (monitor.primary ? " (primary)" : ""));
+    }
+    return true;
+}
+
+bool MonitorManager::handleEvent(const xcb_generic_event_t* event) {
+    if (!available) {
+        return false;
+    }
+    uint8_t type = event->response_type & ~0x80;
+    if (type != firstEvent + XCB_RANDR_SCREEN_CHANGE_NOTIFY && type != firstEvent + XCB_RANDR_NOTIFY) {
+        return false;
+    }
+    stale = true;
+    return true;
+}
+
+bool MonitorManager::takeStale() {
+    bool result = stale;
+    stale = false;
+    return result;
+}
+
+int MonitorManager::indexAt(int x, int y) const {
+    auto edge = std::upper_bound(edges.begin(), edges.end(), x);
+    if (edge == edges.begin() || edge == edges.end()) {
+        return -1;
+    }
+    const auto& slab = slabs[edge - edges.begin() - 1];
+
+    auto it = std::upper_bound(slab.begin(), slab.end(), y,
+                               [](int value, const std::pair<int, size_t>& entry) {
+                                   return value < entry.first;
+                               });
+    if (it == slab.begin()) {
+        return -1;
+    }
+    --it;
+    const Rect& area = monitors[it->second].area;
+    if (y >= area.y + static_cast<int>(area.height)) {
+        return -1;
+    }
+    return static_cast<int>(it->second);
+}
+
+const Monitor& MonitorManager::at(int x, int y) const {
+    int index = indexAt(x, y);
+    return monitors[index >= 0 ? static_cast<size_t>(index) : primary];
+}
+
+void MonitorManager::readRefreshRates(std::vector<Monitor>& found,
+                                      const std::vector<xcb_randr_output_t>& outputs,
+                                      xcb_randr_get_screen_resources_current_cookie_t resourcesCookie) {
+    xcb_connection_t* conn = connection.getConnection();
+
+    // Output to CRTC to mode, each step sent for all monitors at once
+    ReplyPtr<xcb_randr_get_screen_resources_current_reply_t> resources(
+        xcb_randr_get_screen_resources_current_reply(conn, resourcesCookie, nullptr));
+    if (!resources) {
+        return;
+    }
+    xcb_timestamp_t timestamp = resources->config_timestamp;
+
+    std::vector<xcb_randr_get_output_info_cookie_t> outputCookies;
+    for (xcb_randr_output_t output : outputs) {
+        outputCookies.push_back(xcb_randr_get_output_info(conn, output, timestamp));
+    }
+    std::vector<xcb_randr_get_crtc_info_cookie_t> crtcCookies;
+    for (auto cookie : outputCookies) {
+        ReplyPtr<xcb_randr_get_output_info_reply_t> output(
+            xcb_randr_get_output_info_reply(conn, cookie, nullptr));
+        crtcCookies.push_back(xcb_randr_get_crtc_info(conn, output ? output->crtc : XCB_NONE,
+                                                      timestamp));
+    }
+
+    const xcb_randr_mode_info_t* modes = xcb_randr_get_screen_resources_current_modes(resources.get());
+    int modeCount = xcb_randr_get_screen_resources_current_modes_length(resources.get());
+    for (size_t i = 0; i < crtcCookies.size(); i++) {
+        ReplyPtr<xcb_randr_get_crtc_info_reply_t> crtc(
+            xcb_randr_get_crtc_info_reply(conn, crtcCookies[i], nullptr));
+        if (!crtc) {
+            continue;
+        }
+        for (int m = 0; m < modeCount; m++) {
+            const xcb_randr_mode_info_t& mode = modes[m];
+            if (mode.id != crtc->mode) {
+                continue;
+            }
+            double lines = mode.vtotal;
+            if (mode.mode_flags & XCB_RANDR_MODE_FLAG_DOUBLE_SCAN) {
+                lines *= 2;
+            }
+            if (mode.mode_flags & XCB_RANDR_MODE_FLAG_INTERLACE) {
+                lines /= 2;
+            }
+            if (mode.htotal && lines > 0) {
+                found[i].refreshHz = static_cast<unsigned int>(
+                    mode.dot_clock / (mode.htotal * lines) + 0.5);
+            }
+            break;
+        }
+    }
+}
+
+void MonitorManager::buildIndex() {
+    edges.clear();
+    for (const Monitor& monitor : monitors) {
+        edges.push_back(monitor.area.x);
+        edges.push_back(monitor.area.x + static_cast<int>(monitor.area.width));
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    // Slab i spans [edges[i], edges[i + 1])
+    slabs.assign(edges.empty() ? 0 : edges.size() - 1, {});
+    for (size_t i = 0; i < slabs.size(); i++) {
+        for (size_t m = 0; m < monitors.size(); m++) {
+            const Rect& area = monitors[m].area;
+            if (area.x <= edges[i] && edges[i] < area.x + static_cast<int>(area.width)) {
+                slabs[i].emplace_back(area.y, m);
+            }
+        }
+        std::sort(slabs[i].begin(), slabs[i].end());
+    }
+}
+
+} // namespace X
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "../connection/connection.h"
+#include "../layout/rect.h"
+#include <xcb/xcb.h>
+#include <xcb/randr.h>
+#include <utility>
+#include <vector>
+
+namespace X {
+
+/**
+ * @struct Monitor
+ * @brief A RandR monitor, or the whole screen without RandR
+ */
+struct Monitor {
+    xcb_atom_t name;          // Monitor name atom; stable across hotplug
+    Rect area;
+    bool primary;
+    unsigned int refreshHz;   // 0 if unknown
+
+    bool operator==(const Monitor& other) const {
+        return name == other.name && area == other.area && primary == other.primary &&
+               refreshHz == other.refreshHz;
+    }
+    bool operator!=(const Monitor& other) const { return !(*this == other); }
+};
+
+/**
+ * @class MonitorManager
+ * @brief Discovers monitors with RandR 1.5 and finds the monitor at a point
+ *
+ * The monitor rectangles are cut into vertical slabs at every left and
+ * right edge; within a slab the monitors are sorted by their top edge.
+ * A point is looked up with one binary search for the slab and one for
+ * the monitor, in O(log n). Monitors are assumed not to overlap.
+ *
+ * Screen and output change notifications only mark the monitors as
+ * stale; refresh() reads them again once per batch of events.
+ */
+class MonitorManager {
+public:
+    /**
+     * @brief Constructor that reads the monitors and selects RandR events
+     * @param connection The X connection
+     *
+     * The version check and the first monitor queries are sent together,
+     * so reading the monitors costs three round trips, not five.
+     */
+    explicit MonitorManager(Connection& connection);
+
+    /**
+     * @brief Ask for the RandR extension data without waiting
+     * @param connection The X connection
+     *
+     * Lets the constructor find the answer already there.
+     */
+    static void prefetchExtension(Connection& connection);
+
+    MonitorManager(const MonitorManager&) = delete;
+    MonitorManager& operator=(const MonitorManager&) = delete;
+
+    /**
+     * @brief Read the monitors again
+     * @return true if any monitor was added, removed or changed, false otherwise
+     */
+    bool refresh();
+
+    /**
+     * @brief Handle a RandR event
+     * @param event The event
+     * @return true if the event was a RandR notification, false otherwise
+     */
+    bool handleEvent(const xcb_generic_event_t* event);
+
+    /**
+     * @brief Check and clear whether RandR reported changes since the last call
+     * @return true if refresh() is due
+     */
+    bool takeStale();
+
+    /**
+     * @brief Get the monitors
+     * @return The monitors, never empty
+     */
+    const std::vector<Monitor>& getMonitors() const { return monitors; }
+
+    /**
+     * @brief Find the monitor containing a point
+     * @param x The x coordinate on the root window
+     * @param y The y coordinate on the root window
+     * @return Index of the monitor, or -1 if the point is on none
+     */
+    int indexAt(int x, int y) const;
+
+    /**
+     * @brief Find the monitor containing a point, or the primary one
+     * @param x The x coordinate on the root window
+     * @param y The y coordinate on the root window
+     * @return The monitor
+     */
+    const Monitor& at(int x, int y) const;
+
+private:
+    /**
+     * @struct Query
+     * @brief Outstanding requests for the monitors and the modes of their outputs
+     */
+    struct Query {
+        xcb_randr_get_monitors_cookie_t monitors;
+        xcb_randr_get_screen_resources_current_cookie_t resources;
+    };
+
+    Connection& connection;
+    bool available;       // RandR 1.5 or later
+    uint8_t firstEvent;   // Event base of the extension
+    bool stale;
+    std::vector<Monitor> monitors;
+    size_t primary;
+
+    std::vector<int> edges;   // Distinct left and right edges, sorted
+    std::vector<std::vector<std::pair<int, size_t>>> slabs;   // Top edge and monitor, per slab
+
+    /**
+     * @brief Send the requests read() needs without waiting
+     * @return The cookies of the requests
+     */
+    Query query();
+
+    /**
+     * @brief Take the monitors from the replies of query()
+     * @param pending The cookies returned by query()
+     * @return true if any monitor was added, removed or changed, false otherwise
+     */
+    bool read(const Query& pending);
+
+    /**
+     * @brief Fill in the refresh rates of monitors from their first outputs
+     * @param found The monitors
+     * @param outputs The first output of each monitor, or XCB_NONE
+     * @param resources The GetScreenResourcesCurrent request
+     */
+    void readRefreshRates(std::vector<Monitor>& found, const std::vector<xcb_randr_output_t>& outputs,
+                          xcb_randr_get_screen_resources_current_cookie_t resources);
+
+    /**
+     * @brief Rebuild the slabs used by indexAt()
+     */
+    void buildIndex();
+};
+
+} // namespace X
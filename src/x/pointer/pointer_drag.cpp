@@ -0,0 +1,377 @@
+#include "pointer_drag.h"
+#include "../../log/logger.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace X {
+
+namespace {
+
+constexpr unsigned int kMinSize = 32;
+constexpr int kSnapDistance = 12;
+constexpr uint16_t kDragModifier = XCB_MOD_MASK_1;
+constexpr uint8_t kMoveButton = 1;
+constexpr uint8_t kResizeButton = 3;
+
+} // namespace
+
+PointerDrag::PointerDrag(Connection& connection, EventLoop& eventLoop, ClientManager& clients,
+                         WorkspaceManager& workspaces, MonitorManager& monitors)
+    : connection(connection),
+      eventLoop(eventLoop),
+      clients(clients),
+      workspaces(workspaces),
+      monitors(monitors),
+      timerFd(-1),
+      frameMicros(1000000 / 60),
+      fixedRate(false),
+      outlineGc(0),
+      sync(connection),
+      syncEnabled(true),
+      active(false),
+      outline(false),
+      mode(Mode::Move),
+      window(0),
+      start{ 0, 0, 0, 0 },
+      startX(0),
+      startY(0),
+      pointerX(0),
+      pointerY(0),
+      pointerTime(XCB_CURRENT_TIME),
+      pending(false),
+      pendingSince(0),
+      drawn{ 0, 0, 0, 0 },
+      beganAt(0),
+      motions(0),
+      configures(0),
+      syncTimeouts(0),
+      frameLagStats("Drag frame lag"),
+      syncedLagStats("Drag frame lag (sync)") {
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerFd < 0) {
+        Logger::warning(std::string("Failed to create drag timer: ") + std::strerror(errno));
+        return;
+    }
+    eventLoop.addWatch(timerFd, [this]() { tick(); });
+}
+
+PointerDrag::~PointerDrag() {
+    if (timerFd >= 0) {
+        eventLoop.removeWatch(timerFd);
+        ::close(timerFd);
+    }
+    if (outlineGc) {
+        xcb_free_gc(connection.getConnection(), outlineGc);
+    }
+    if (frameLagStats.count()) {
+        Logger::info(frameLagStats.summary());
+    }
+    if (syncedLagStats.count()) {
+        Logger::info(syncedLagStats.summary());
+    }
+}
+
+void PointerDrag::grabButtons() {
+    xcb_connection_t* conn = connection.getConnection();
+    uint16_t eventMask = XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE |
+                         XCB_EVENT_MASK_POINTER_MOTION;
+
+    // Also grab with Caps Lock and Num Lock, like the key grabs
+    const uint16_t locks[] = { 0, XCB_MOD_MASK_LOCK, XCB_MOD_MASK_2,
+                               XCB_MOD_MASK_LOCK | XCB_MOD_MASK_2 };
+    for (uint8_t button : { kMoveButton, kResizeButton }) {
+        for (uint16_t lock : locks) {
+            xcb_grab_button(conn, 0, connection.getRootWindow(), eventMask,
+                            XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC, XCB_NONE, XCB_NONE,
+                            button, kDragModifier | lock);
+        }
+    }
+}
+
+void PointerDrag::setRefreshRate(unsigned int hz) {
+    if (hz) {
+        frameMicros = 1000000 / hz;
+        fixedRate = true;
+    }
+}
+
+bool PointerDrag::begin(const xcb_button_press_event_t* event) {
+    if (active || !(event->state & kDragModifier) ||
+        (event->detail != kMoveButton && event->detail != kResizeButton)) {
+        return false;
+    }
+
+    // The grab is on the root window; the index knows which client is
+    // on top at the pointer without asking the server
+    Client* client = clients.getIndex().at(event->root_x, event->root_y, [this](const Client* candidate) {
+        return workspaces.isVisible(candidate);
+    });
+    if (!client || !client->isPlaced()) {
+        return false;
+    }
+
+    workspaces.setFloating(client);
+    workspaces.focus(client);
+
+    active = true;
+    mode = event->detail == kMoveButton ? Mode::Move : Mode::Resize;
+    window = client->getId();
+    start = client->getGeometry();
+    startX = pointerX = event->root_x;
+    startY = pointerY = event->root_y;
+    pointerTime = event->time;
+    pending = false;
+    beganAt = LatencyStats::nowMicros();
+    motions = 0;
+    configures = 0;
+    syncTimeouts = 0;
+
+    // Pace the drag by the monitor it starts on; 60Hz if RandR cannot tell
+    if (!fixedRate) {
+        unsigned int hz = monitors.at(event->root_x, event->root_y).refreshHz;
+        frameMicros = 1000000 / (hz ? hz : 60);
+    }
+
+    // Only a resize makes the client repaint, and in outline mode the
+    // client is not configured until the drag ends
+    if (syncEnabled && !outline && mode == Mode::Resize) {
+        sync.probe(window);
+    }
+
+    if (outline) {
+        drawn = start;
+        drawOutline(drawn);
+        connection.flush();
+    }
+    armTimer(true);
+    return true;
+}
+
+void PointerDrag::motion(const xcb_motion_notify_event_t* event) {
+    pointerX = event->root_x;
+    pointerY = event->root_y;
+    pointerTime = event->time;
+    motions++;
+    if (!pending) {
+        pending = true;
+        pendingSince = LatencyStats::nowMicros();
+    }
+}
+
+void PointerDrag::end() {
+    if (!active) {
+        return;
+    }
+    armTimer(false);
+    active = false;
+
+    if (outline) {
+        drawOutline(drawn);
+    }
+
+    // Place the client where the pointer was released; an outstanding
+    // acknowledge is not waited for
+    bool synced = sync.isAttached();
+    if (Client* client = clients.find(window)) {
+        configure(client, target());
+        int monitor = monitors.indexAt(pointerX, pointerY);
+        if (monitor >= 0) {
+            workspaces.moveToMonitor(client, static_cast<size_t>(monitor));
+        }
+    }
+    size_t acknowledged = sync.getAcknowledged();
+    sync.detach();
+    connection.flush();
+
+    uint64_t elapsed = LatencyStats::nowMicros() - beganAt;
+    std::stringstream ss;
+    ss << (mode == Mode::Move ? "Move" : "Resize") << (outline ? " (outline)" : "")
+       << ": " << configures << " configures for " << motions << " motion events in "
+       << elapsed / 1000 << "ms";
+    if (elapsed) {
+        ss << " (" << configures * 1000000 / elapsed << " configures/s)";
+    }
+    if (synced || syncTimeouts) {
+        ss << ", sync: " << acknowledged << " frames acknowledged, "
+           << syncTimeouts << " timeouts";
+    }
+    Logger::info(ss.str());
+}
+
+void PointerDrag::tick() {
+    uint64_t expirations;
+    while (read(timerFd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+    }
+    if (!active || !pending) {
+        return;
+    }
+
+    if (sync.isWaiting()) {
+        uint64_t now = LatencyStats::nowMicros();
+        if (!sync.hasTimedOut(now)) {
+            // Keep the motion for the frame after the acknowledge
+            return;
+        }
+        syncTimeouts++;
+        sync.detach();
+        Logger::warning("Window " + std::to_string(window) +
+                        " did not acknowledge a sync request, resizing unsynchronised");
+    }
+    pending = false;
+
+    Rect rect = target();
+    bool synced = sync.isAttached();
+    if (outline) {
+        // Erase the old outline and draw the new one
+        drawOutline(drawn);
+        drawn = rect;
+        drawOutline(drawn);
+    } else {
+        Client* client = clients.find(window);
+        if (!client) {
+            // The client went away under the pointer
+            armTimer(false);
+            active = false;
+            sync.detach();
+            return;
+        }
+        configure(client, rect);
+    }
+    (synced ? syncedLagStats : frameLagStats).record(LatencyStats::nowMicros() - pendingSince);
+    connection.flush();
+}
+
+Rect PointerDrag::target() const {
+    int dx = pointerX - startX;
+    int dy = pointerY - startY;
+
+    if (mode == Mode::Move) {
+        return snap(Rect{ start.x + dx, start.y + dy, start.width, start.height });
+    }
+
+    int width = std::max(static_cast<int>(kMinSize), static_cast<int>(start.width) + dx);
+    int height = std::max(static_cast<int>(kMinSize), static_cast<int>(start.height) + dy);
+    return snap(Rect{ start.x, start.y, static_cast<unsigned int>(width), static_cast<unsigned int>(height) });
+}
+
+Rect PointerDrag::snap(const Rect& rect) const {
+    int left = rect.x;
+    int right = rect.x + static_cast<int>(rect.width);
+    int top = rect.y;
+    int bottom = rect.y + static_cast<int>(rect.height);
+    bool move = mode == Mode::Move;
+
+    // Smallest correction per axis; a resize only moves the right and
+    // bottom edges
+    int snapX = kSnapDistance + 1;
+    int snapY = kSnapDistance + 1;
+    auto consider = [](int edge, int target, int& best) {
+        if (std::abs(target - edge) < std::abs(best)) {
+            best = target - edge;
+        }
+    };
+    auto considerX = [&](int target) {
+        if (move) {
+            consider(left, target, snapX);
+        }
+        consider(right, target, snapX);
+    };
+    auto considerY = [&](int target) {
+        if (move) {
+            consider(top, target, snapY);
+        }
+        consider(bottom, target, snapY);
+    };
+
+    const Rect& screen = monitors.at(pointerX, pointerY).area;
+    considerX(screen.x);
+    considerX(screen.x + static_cast<int>(screen.width));
+    considerY(screen.y);
+    considerY(screen.y + static_cast<int>(screen.height));
+
+    std::vector<Client*> nearby;
+    Rect reach{ left - kSnapDistance, top - kSnapDistance,
+                rect.width + 2 * kSnapDistance, rect.height + 2 * kSnapDistance };
+    xcb_window_t dragged = window;
+    clients.getIndex().query(reach, [this, dragged](const Client* client) {
+        return client->getId() != dragged && workspaces.isVisible(client);
+    }, nearby);
+    for (const Client* client : nearby) {
+        const Rect& other = client->getGeometry();
+        considerX(other.x);
+        considerX(other.x + static_cast<int>(other.width));
+        considerY(other.y);
+        considerY(other.y + static_cast<int>(other.height));
+    }
+
+    Rect snapped = rect;
+    if (std::abs(snapX) <= kSnapDistance) {
+        if (move) {
+            snapped.x += snapX;
+        } else if (static_cast<int>(rect.width) + snapX >= static_cast<int>(kMinSize)) {
+            snapped.width = static_cast<unsigned int>(static_cast<int>(rect.width) + snapX);
+        }
+    }
+    if (std::abs(snapY) <= kSnapDistance) {
+        if (move) {
+            snapped.y += snapY;
+        } else if (static_cast<int>(rect.height) + snapY >= static_cast<int>(kMinSize)) {
+            snapped.height = static_cast<unsigned int>(static_cast<int>(rect.height) + snapY);
+        }
+    }
+    return snapped;
+}
+
+void PointerDrag::configure(Client* client, const Rect& rect) {
+    if (rect == client->getGeometry()) {
+        return;
+    }
+
+    // A request without a configure would never be acknowledged
+    sync.request(pointerTime);
+    client->place(rect, workspaces.getBorderWidth());
+    configures++;
+}
+
+void PointerDrag::armTimer(bool enabled) {
+    if (timerFd < 0) {
+        return;
+    }
+
+    itimerspec spec = {};
+    if (enabled) {
+        spec.it_interval.tv_sec = frameMicros / 1000000;
+        spec.it_interval.tv_nsec = (frameMicros % 1000000) * 1000;
+        spec.it_value = spec.it_interval;
+    }
+    if (timerfd_settime(timerFd, 0, &spec, nullptr) < 0) {
+        Logger::warning(std::string("Failed to set drag timer: ") + std::strerror(errno));
+    }
+}
+
+void PointerDrag::drawOutline(const Rect& rect) {
+    xcb_connection_t* conn = connection.getConnection();
+    if (!outlineGc) {
+        // XOR over everything on screen, so drawing twice erases
+        xcb_screen_t* screen = connection.getScreen();
+        outlineGc = xcb_generate_id(conn);
+        uint32_t mask = XCB_GC_FUNCTION | XCB_GC_FOREGROUND | XCB_GC_LINE_WIDTH |
+                        XCB_GC_SUBWINDOW_MODE;
+        uint32_t values[4] = { XCB_GX_XOR, screen->white_pixel ^ screen->black_pixel, 2,
+                               XCB_SUBWINDOW_MODE_INCLUDE_INFERIORS };
+        xcb_create_gc(conn, outlineGc, connection.getRootWindow(), mask, values);
+    }
+
+    xcb_rectangle_t outlineRect = {
+        static_cast<int16_t>(rect.x), static_cast<int16_t>(rect.y),
+        static_cast<uint16_t>(rect.width - 1), static_cast<uint16_t>(rect.height - 1)
+    };
+    xcb_poly_rectangle(conn, connection.getRootWindow(), outlineGc, 1, &outlineRect);
+}
+
+} // namespace X
@@ -0,0 +1,193 @@
+#pragma once
+
+#include "../client/client_manager.h"
+#include "../connection/connection.h"
+#include "../event/event_loop.h"
+#include "../layout/rect.h"
+#include "../monitor/monitor_manager.h"
+#include "../workspace/workspace_manager.h"
+#include "sync_request.h"
+#include "../../log/latency_stats.h"
+#include <xcb/xcb.h>
+#include <cstdint>
+
+namespace X {
+
+/**
+ * @class PointerDrag
+ * @brief Moves and resizes clients with Alt+drag
+ *
+ * Alt+Button1 moves a client and Alt+Button3 resizes it from its bottom
+ * right corner; either makes the client float. The passive button grab
+ * keeps the pointer while the button is held.
+ *
+ * Motion events only record the pointer position. A timer running at
+ * the refresh rate of the monitor the drag starts on sends at most one
+ * configure request per frame, so a slow client is never buried under
+ * requests for positions the pointer has already left. In outline mode only an XOR rectangle
+ * follows the pointer and the client is configured once, on release.
+ *
+ * A client that supports _NET_WM_SYNC_REQUEST is additionally sent the
+ * next size only after it has repainted at the previous one. A client
+ * that does not acknowledge in time is dragged unsynchronised for the
+ * rest of the drag.
+ *
+ * Edges that come within a few pixels of a visible client's edge or of
+ * the monitor's edge snap to it; the candidates come from the client
+ * index rather than a scan of every client.
+ *
+ * A client dropped on another monitor joins the workspace shown there.
+ */
+class PointerDrag {
+public:
+    /**
+     * @brief Constructor
+     * @param connection The X connection
+     * @param eventLoop The event loop that runs the frame timer
+     * @param clients The client registry
+     * @param workspaces The workspaces
+     * @param monitors The monitors
+     */
+    PointerDrag(Connection& connection, EventLoop& eventLoop, ClientManager& clients,
+                WorkspaceManager& workspaces, MonitorManager& monitors);
+
+    /**
+     * @brief Destructor
+     */
+    ~PointerDrag();
+
+    PointerDrag(const PointerDrag&) = delete;
+    PointerDrag& operator=(const PointerDrag&) = delete;
+
+    /**
+     * @brief Grab Alt+Button1 and Alt+Button3 on the root window
+     */
+    void grabButtons();
+
+    /**
+     * @brief Start a drag if the press is one of ours
+     * @param event The button press event
+     * @return true if a drag started, false otherwise
+     */
+    bool begin(const xcb_button_press_event_t* event);
+
+    /**
+     * @brief Record the pointer position during a drag
+     * @param event The motion event
+     */
+    void motion(const xcb_motion_notify_event_t* event);
+
+    /**
+     * @brief Finish the drag, placing the client at the final position
+     */
+    void end();
+
+    /**
+     * @brief Handle an extension event
+     * @param event The event
+     * @return true if the event was consumed, false otherwise
+     */
+    bool handleEvent(const xcb_generic_event_t* event) { return sync.handleEvent(event); }
+
+    /**
+     * @brief Check if a drag is in progress
+     * @return true while a button grabbed by us is held
+     */
+    bool isActive() const { return active; }
+
+    /**
+     * @brief Follow the pointer with an outline instead of the client
+     * @param enabled Whether to use outline mode
+     */
+    void setOutline(bool enabled) { outline = enabled; }
+
+    /**
+     * @brief Set how often the client is configured during a drag
+     * @param hz The rate to use instead of the monitor's refresh rate
+     */
+    void setRefreshRate(unsigned int hz);
+
+    /**
+     * @brief Set whether resizes wait for _NET_WM_SYNC_REQUEST acknowledges
+     * @param enabled Whether to synchronise with clients that support it
+     */
+    void setSync(bool enabled) { syncEnabled = enabled; }
+
+private:
+    enum class Mode {
+        Move,
+        Resize,
+    };
+
+    Connection& connection;
+    EventLoop& eventLoop;
+    ClientManager& clients;
+    WorkspaceManager& workspaces;
+    MonitorManager& monitors;
+    int timerFd;
+    uint64_t frameMicros;
+    bool fixedRate;             // Set by setRefreshRate(), ignores the monitors
+    xcb_gcontext_t outlineGc;   // Created on the first outline drag
+    SyncRequest sync;
+    bool syncEnabled;
+
+    bool active;
+    bool outline;
+    Mode mode;
+    xcb_window_t window;
+    Rect start;                 // Client geometry when the drag began
+    int16_t startX;             // Pointer position when the drag began
+    int16_t startY;
+    int16_t pointerX;           // Latest pointer position
+    int16_t pointerY;
+    xcb_timestamp_t pointerTime;   // Time of the latest pointer event
+    bool pending;               // Pointer moved since the last frame
+    uint64_t pendingSince;
+    Rect drawn;                 // Outline currently on screen
+
+    uint64_t beganAt;
+    size_t motions;
+    size_t configures;
+    size_t syncTimeouts;
+    LatencyStats frameLagStats;       // First unhandled motion to configure
+    LatencyStats syncedLagStats;      // The same, for clients synchronised by sync
+
+    /**
+     * @brief Handle a frame timer expiry
+     */
+    void tick();
+
+    /**
+     * @brief Compute the client rectangle for the latest pointer position
+     * @return The rectangle including the border
+     */
+    Rect target() const;
+
+    /**
+     * @brief Snap the moving edges of a rectangle to nearby edges
+     * @param rect The rectangle including the border
+     * @return The snapped rectangle
+     */
+    Rect snap(const Rect& rect) const;
+
+    /**
+     * @brief Configure the client, synchronised if it is attached to sync
+     * @param client The dragged client
+     * @param rect The rectangle including the border
+     */
+    void configure(Client* client, const Rect& rect);
+
+    /**
+     * @brief Start or stop the frame timer
+     * @param enabled Whether the timer should run
+     */
+    void armTimer(bool enabled);
+
+    /**
+     * @brief Draw or erase the outline (XOR drawing toggles it)
+     * @param rect The rectangle
+     */
+    void drawOutline(const Rect& rect);
+};
+
+} // namespace X
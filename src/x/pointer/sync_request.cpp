@@ -0,0 +1,208 @@
+#include "sync_request.h"
+#include "../../log/logger.h"
+#include "../async/async_requests.h"
+
+namespace X {
+
+// Only needed here, so kept out of async_requests.h
+template <>
+struct ReplyOf<xcb_sync_initialize_cookie_t> { using type = xcb_sync_initialize_reply_t; };
+
+template <>
+struct ReplyOf<xcb_sync_query_counter_cookie_t> { using type = xcb_sync_query_counter_reply_t; };
+
+namespace {
+
+// A client that misses this is treated as unresponsive
+constexpr uint64_t kAcknowledgeTimeoutMicros = 200000;
+
+int64_t toInt64(const xcb_sync_int64_t& value) {
+    return (static_cast<int64_t>(value.hi) << 32) | value.lo;
+}
+
+xcb_sync_int64_t fromInt64(int64_t value) {
+    return xcb_sync_int64_t{ static_cast<int32_t>(value >> 32), static_cast<uint32_t>(value) };
+}
+
+} // namespace
+
+SyncRequest::SyncRequest(Connection& connection)
+    : connection(connection),
+      available(false),
+      firstEvent(0),
+      probing(false),
+      generation(0),
+      window(0),
+      counter(0),
+      alarm(0),
+      value(0),
+      waiting(false),
+      sentAt(0),
+      acknowledged(0),
+      acknowledgeStats("Sync acknowledge") {
+    xcb_connection_t* conn = connection.getConnection();
+    const xcb_query_extension_reply_t* extension = xcb_get_extension_data(conn, &xcb_sync_id);
+    if (!extension || !extension->present) {
+        Logger::info("XSync extension not available, resizing without _NET_WM_SYNC_REQUEST");
+        return;
+    }
+
+    connection.prefetchAtoms({ "WM_PROTOCOLS", "_NET_WM_SYNC_REQUEST",
+                               "_NET_WM_SYNC_REQUEST_COUNTER" });
+    initialize(xcb_sync_initialize(conn, XCB_SYNC_MAJOR_VERSION, XCB_SYNC_MINOR_VERSION),
+               extension->first_event);
+}
+
+Task SyncRequest::initialize(xcb_sync_initialize_cookie_t cookie, uint8_t firstEvent) {
+    auto version = co_await connection.getAsync().reply(cookie);
+    if (!version) {
+        Logger::warning("Failed to initialize the XSync extension");
+        co_return;
+    }
+    available = true;
+    this->firstEvent = firstEvent;
+}
+
+SyncRequest::~SyncRequest() {
+    detach();
+    if (acknowledgeStats.count()) {
+        Logger::info(acknowledgeStats.summary());
+    }
+}
+
+void SyncRequest::probe(xcb_window_t window) {
+    if (!available || probing || alarm) {
+        return;
+    }
+    xcb_connection_t* conn = connection.getConnection();
+    this->window = window;
+    probing = true;
+    attach(xcb_get_property(conn, 0, window, connection.getAtom("WM_PROTOCOLS"), XCB_ATOM_ATOM, 0, 32),
+           xcb_get_property(conn, 0, window, connection.getAtom("_NET_WM_SYNC_REQUEST_COUNTER"),
+                            XCB_ATOM_CARDINAL, 0, 2),
+           generation);
+}
+
+Task SyncRequest::attach(xcb_get_property_cookie_t protocolsCookie, xcb_get_property_cookie_t counterCookie,
+                         uint64_t probe) {
+    AsyncRequests& async = connection.getAsync();
+    auto protocols = co_await async.reply(protocolsCookie);
+    auto counterReply = co_await async.reply(counterCookie);
+
+    // The drag may have ended while the replies were outstanding
+    if (probe != generation) {
+        co_return;
+    }
+    if (!supportsProtocol(protocols.get()) || !counterReply ||
+        xcb_get_property_value_length(counterReply.get()) < 4) {
+        probing = false;
+        co_return;
+    }
+
+    // With two counters the first one is the basic counter used here
+    xcb_connection_t* conn = connection.getConnection();
+    xcb_sync_counter_t probed = *static_cast<xcb_sync_counter_t*>(xcb_get_property_value(counterReply.get()));
+    auto current = co_await async.reply(xcb_sync_query_counter(conn, probed));
+    if (probe != generation) {
+        co_return;
+    }
+    probing = false;
+    if (!current) {
+        Logger::warning("Window " + std::to_string(window) + " has an invalid sync counter");
+        co_return;
+    }
+    counter = probed;
+    value = toInt64(current->counter_value);
+
+    // Every increase of the counter past the alarm value reports the
+    // new value; a delta of one keeps the alarm armed for the next frame
+    xcb_sync_create_alarm_value_list_t values = {};
+    values.counter = counter;
+    values.valueType = XCB_SYNC_VALUETYPE_ABSOLUTE;
+    values.value = fromInt64(value + 1);
+    values.testType = XCB_SYNC_TESTTYPE_POSITIVE_COMPARISON;
+    values.delta = fromInt64(1);
+    values.events = 1;
+    alarm = xcb_generate_id(conn);
+    xcb_sync_create_alarm_aux(conn, alarm,
+                              XCB_SYNC_CA_COUNTER | XCB_SYNC_CA_VALUE_TYPE | XCB_SYNC_CA_VALUE |
+                              XCB_SYNC_CA_TEST_TYPE | XCB_SYNC_CA_DELTA | XCB_SYNC_CA_EVENTS,
+                              &values);
+
+    waiting = false;
+    acknowledged = 0;
+}
+
+void SyncRequest::detach() {
+    if (probing) {
+        // The probe's coroutine sees this when its replies come in
+        generation++;
+        probing = false;
+    }
+    if (alarm) {
+        xcb_sync_destroy_alarm(connection.getConnection(), alarm);
+        alarm = 0;
+    }
+    counter = 0;
+    waiting = false;
+}
+
+void SyncRequest::request(xcb_timestamp_t time) {
+    if (!alarm) {
+        return;
+    }
+    value++;
+
+    xcb_client_message_event_t event = {};
+    event.response_type = XCB_CLIENT_MESSAGE;
+    event.format = 32;
+    event.window = window;
+    event.type = connection.getAtom("WM_PROTOCOLS");
+    event.data.data32[0] = connection.getAtom("_NET_WM_SYNC_REQUEST");
+    event.data.data32[1] = time;
+    event.data.data32[2] = static_cast<uint32_t>(value);
+    event.data.data32[3] = static_cast<uint32_t>(value >> 32);
+    xcb_send_event(connection.getConnection(), 0, window, XCB_EVENT_MASK_NO_EVENT,
+                   reinterpret_cast<const char*>(&event));
+
+    waiting = true;
+    sentAt = LatencyStats::nowMicros();
+}
+
+bool SyncRequest::hasTimedOut(uint64_t now) const {
+    return waiting && now - sentAt > kAcknowledgeTimeoutMicros;
+}
+
+bool SyncRequest::handleEvent(const xcb_generic_event_t* event) {
+    if (!available || (event->response_type & ~0x80) != firstEvent + XCB_SYNC_ALARM_NOTIFY) {
+        return false;
+    }
+
+    // Notifications of an alarm already destroyed are dropped
+    auto notify = reinterpret_cast<const xcb_sync_alarm_notify_event_t*>(event);
+    if (notify->alarm == alarm && waiting && toInt64(notify->counter_value) >= value) {
+        waiting = false;
+        acknowledged++;
+        acknowledgeStats.record(LatencyStats::nowMicros() - sentAt);
+    }
+    return true;
+}
+
+bool SyncRequest::supportsProtocol(const xcb_get_property_reply_t* reply) {
+    if (!reply || reply->format != 32) {
+        return false;
+    }
+    auto mutableReply = const_cast<xcb_get_property_reply_t*>(reply);
+    auto atoms = static_cast<const xcb_atom_t*>(xcb_get_property_value(mutableReply));
+    int count = xcb_get_property_value_length(mutableReply) / 4;
+
+    xcb_atom_t syncRequest = connection.getAtom("_NET_WM_SYNC_REQUEST");
+    for (int i = 0; i < count; i++) {
+        if (atoms[i] == syncRequest) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace X
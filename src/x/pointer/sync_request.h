@@ -0,0 +1,147 @@
+#pragma once
+
+#include "../connection/connection.h"
+#include "../async/task.h"
+#include "../../log/latency_stats.h"
+#include <xcb/xcb.h>
+#include <xcb/sync.h>
+#include <cstdint>
+
+namespace X {
+
+/**
+ * @class SyncRequest
+ * @brief _NET_WM_SYNC_REQUEST handshake with the client being resized
+ *
+ * A client that lists _NET_WM_SYNC_REQUEST in WM_PROTOCOLS publishes an
+ * XSync counter in _NET_WM_SYNC_REQUEST_COUNTER. Before each configure
+ * the window manager sends the client a new counter value; the client
+ * sets its counter to that value once it has repainted at the new size.
+ * An XSync alarm on the counter reports this as an AlarmNotify event, so
+ * the next size is sent only after the previous frame is on screen.
+ *
+ * One handshake is attached at a time, for the client under a drag.
+ * Every reply is awaited on the event loop, never waited for.
+ */
+class SyncRequest {
+public:
+    /**
+     * @brief Constructor that starts initializing the XSync extension
+     * @param connection The X connection
+     *
+     * The handshake is unavailable until the reply is in.
+     */
+    explicit SyncRequest(Connection& connection);
+
+    /**
+     * @brief Destructor that reports acknowledge latencies
+     */
+    ~SyncRequest();
+
+    SyncRequest(const SyncRequest&) = delete;
+    SyncRequest& operator=(const SyncRequest&) = delete;
+
+    /**
+     * @brief Check if the server supports XSync
+     * @return true once the extension is initialized, false otherwise
+     */
+    bool isAvailable() const { return available; }
+
+    /**
+     * @brief Ask for the protocols and the sync counter of a window
+     * @param window The client window
+     *
+     * The client is attached once the replies are in and it turns out to
+     * take part in the handshake; until then the drag runs unsynchronised.
+     */
+    void probe(xcb_window_t window);
+
+    /**
+     * @brief Stop synchronising with the attached client
+     *
+     * A probe still waiting for its replies is abandoned.
+     */
+    void detach();
+
+    /**
+     * @brief Check if a client is attached
+     * @return true if configures are being synchronised
+     */
+    bool isAttached() const { return alarm != 0; }
+
+    /**
+     * @brief Send the client the counter value to set after its next frame
+     * @param time Timestamp of the input event that caused the configure
+     *
+     * Call right before the configure request. The request is not flushed.
+     */
+    void request(xcb_timestamp_t time);
+
+    /**
+     * @brief Check if the last request is still unacknowledged
+     * @return true while waiting for the client to repaint
+     */
+    bool isWaiting() const { return waiting; }
+
+    /**
+     * @brief Check if the client has taken too long to acknowledge
+     * @param now The current time in microseconds
+     * @return true if the last request is overdue
+     */
+    bool hasTimedOut(uint64_t now) const;
+
+    /**
+     * @brief Handle an XSync event
+     * @param event The event
+     * @return true if the event was an XSync alarm notification, false otherwise
+     */
+    bool handleEvent(const xcb_generic_event_t* event);
+
+    /**
+     * @brief Get the number of requests the attached client acknowledged
+     * @return The number of acknowledged frames since the client was attached
+     */
+    size_t getAcknowledged() const { return acknowledged; }
+
+private:
+    Connection& connection;
+    bool available;
+    uint8_t firstEvent;   // Event base of the extension
+
+    bool probing;
+    uint64_t generation;  // Bumped by detach() to abandon an outstanding probe
+    xcb_window_t window;
+
+    xcb_sync_counter_t counter;
+    xcb_sync_alarm_t alarm;
+    int64_t value;        // Last value sent to the client
+    bool waiting;
+    uint64_t sentAt;
+    size_t acknowledged;
+    LatencyStats acknowledgeStats;   // Request to AlarmNotify
+
+    /**
+     * @brief Enable the handshake once the extension is initialized
+     * @param cookie The cookie of the initialize request
+     * @param firstEvent Event base of the extension
+     */
+    Task initialize(xcb_sync_initialize_cookie_t cookie, uint8_t firstEvent);
+
+    /**
+     * @brief Read the replies of probe() and set up the alarm
+     * @param protocolsCookie The WM_PROTOCOLS request
+     * @param counterCookie The _NET_WM_SYNC_REQUEST_COUNTER request
+     * @param probe The generation the probe was sent in
+     */
+    Task attach(xcb_get_property_cookie_t protocolsCookie, xcb_get_property_cookie_t counterCookie,
+                uint64_t probe);
+
+    /**
+     * @brief Check if WM_PROTOCOLS lists _NET_WM_SYNC_REQUEST
+     * @param reply The WM_PROTOCOLS reply, may be nullptr
+     * @return true if the protocol is supported, false otherwise
+     */
+    bool supportsProtocol(const xcb_get_property_reply_t* reply);
+};
+
+} // namespace X
@@ -0,0 +1,222 @@
+#include "child_tracker.h"
+#include "../../log/logger.h"
+#include <cerrno>
+#include <csignal>
+#include <sstream>
+#include <vector>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace X {
+
+namespace {
+
+// Launches whose first window has not shown up after this long are dropped
+constexpr uint64_t kFirstWindowTimeoutMicros = 60ull * 1000 * 1000;
+
+int pidfdOpen(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+std::string describeStatus(int status) {
+    if (WIFEXITED(status)) {
+        return "exited with status " + std::to_string(WEXITSTATUS(status));
+    }
+    if (WIFSIGNALED(status)) {
+        return "killed by signal " + std::to_string(WTERMSIG(status));
+    }
+    return "stopped";
+}
+
+} // namespace
+
+ChildTracker::ChildTracker(EventLoop& loop)
+    : loop(loop), usePidfd(false), signalFd(-1),
+      firstWindowStats("Spawn to first window") {
+    int probe = pidfdOpen(getpid());
+    if (probe >= 0) {
+        ::close(probe);
+        usePidfd = true;
+        Logger::debug("Child tracker using pidfd");
+        return;
+    }
+
+    if (watchSignals()) {
+        Logger::debug("Child tracker using signalfd");
+    }
+}
+
+ChildTracker::~ChildTracker() {
+    for (auto& entry : children) {
+        if (entry.second.pidfd >= 0) {
+            loop.removeWatch(entry.second.pidfd);
+            ::close(entry.second.pidfd);
+        }
+    }
+    children.clear();
+
+    if (signalFd >= 0) {
+        loop.removeWatch(signalFd);
+        ::close(signalFd);
+    }
+
+    if (firstWindowStats.count()) {
+        Logger::info(firstWindowStats.summary());
+    }
+}
+
+void ChildTracker::track(pid_t pid, const std::string& origin) {
+    if (pid <= 0) {
+        return;
+    }
+
+    expirePendingWindows();
+    pendingWindows[pid] = { origin, LatencyStats::nowMicros() };
+
+    int pidfd = -1;
+    if (usePidfd) {
+        pidfd = pidfdOpen(pid);
+        if (pidfd < 0) {
+            Logger::warning("pidfd_open failed for PID " + std::to_string(pid));
+        }
+    }
+
+    children[pid] = { origin, pidfd };
+    if (pidfd >= 0) {
+        loop.addWatch(pidfd, [this, pid]() { reap(pid); });
+    } else if (usePidfd) {
+        // Without a pidfd, have SIGCHLD report the exit; the child may be
+        // gone already, so try once as well
+        watchSignals();
+        reap(pid);
+    }
+}
+
+bool ChildTracker::awaitingWindow() {
+    expirePendingWindows();
+    return !pendingWindows.empty();
+}
+
+void ChildTracker::windowMapped(pid_t pid, xcb_window_t window) {
+    expirePendingWindows();
+    auto it = pendingWindows.find(pid);
+    if (it == pendingWindows.end()) {
+        return;
+    }
+
+    uint64_t elapsed = LatencyStats::nowMicros() - it->second.spawnedAt;
+    firstWindowStats.record(elapsed);
+
+    std::stringstream ss;
+    ss << "First window 0x" << std::hex << window << std::dec
+       << " of '" << it->second.origin << "' (PID " << pid << ") mapped "
+       << elapsed / 1000 << "ms after launch";
+    Logger::info(ss.str());
+
+    pendingWindows.erase(it);
+}
+
+void ChildTracker::reap(pid_t pid) {
+    int status = 0;
+    pid_t result = waitpid(pid, &status, WNOHANG);
+    if (result == 0) {
+        // Still running
+        return;
+    }
+
+    auto it = children.find(pid);
+    if (it == children.end()) {
+        return;
+    }
+
+    if (result == pid) {
+        Logger::debug("Child " + std::to_string(pid) + " (" + it->second.origin + ") " +
+                      describeStatus(status));
+    }
+
+    if (it->second.pidfd >= 0) {
+        loop.removeWatch(it->second.pidfd);
+        ::close(it->second.pidfd);
+    }
+    children.erase(it);
+    pendingWindows.erase(pid);
+}
+
+void ChildTracker::reapAll() {
+    // Drain the queued signals; several exits may have been merged
+    signalfd_siginfo info;
+    while (read(signalFd, &info, sizeof(info)) == sizeof(info)) {
+    }
+
+    // Children with a pidfd are reaped through it
+    if (usePidfd) {
+        std::vector<pid_t> unwatched;
+        for (const auto& entry : children) {
+            if (entry.second.pidfd < 0) {
+                unwatched.push_back(entry.first);
+            }
+        }
+        for (pid_t pid : unwatched) {
+            reap(pid);
+        }
+        return;
+    }
+
+    int status = 0;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        auto it = children.find(pid);
+        if (it == children.end()) {
+            Logger::debug("Reaped untracked child " + std::to_string(pid));
+            continue;
+        }
+        Logger::debug("Child " + std::to_string(pid) + " (" + it->second.origin + ") " +
+                      describeStatus(status));
+        children.erase(it);
+        pendingWindows.erase(pid);
+    }
+}
+
+bool ChildTracker::watchSignals() {
+    if (signalFd >= 0) {
+        return true;
+    }
+
+    // Take SIGCHLD through a descriptor instead of a handler. The signal
+    // must be blocked for signalfd to receive it; Spawner unblocks it
+    // again in the children.
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask, nullptr);
+
+    signalFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signalFd < 0) {
+        Logger::error("Failed to create signalfd, launched processes will not be reaped");
+        return false;
+    }
+
+    loop.addWatch(signalFd, [this]() { reapAll(); });
+    return true;
+}
+
+void ChildTracker::expirePendingWindows() {
+    uint64_t now = LatencyStats::nowMicros();
+    for (auto it = pendingWindows.begin(); it != pendingWindows.end();) {
+        if (now - it->second.spawnedAt > kFirstWindowTimeoutMicros) {
+            it = pendingWindows.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace X
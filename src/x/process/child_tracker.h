@@ -0,0 +1,113 @@
+#pragma once
+
+#include "../../log/latency_stats.h"
+#include "../event/event_loop.h"
+#include <xcb/xcb.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <sys/types.h>
+
+namespace X {
+
+/**
+ * @class ChildTracker
+ * @brief Reaps launched processes from the event loop
+ *
+ * Every tracked child gets a pidfd that is watched by the event loop,
+ * so its exit status is collected as soon as it terminates and no
+ * zombies are left behind. On kernels without pidfd_open the tracker
+ * falls back to a signalfd for SIGCHLD and reaps every exited child; a
+ * child whose pidfd_open fails alone is reaped on SIGCHLD as well.
+ *
+ * The tracker also remembers when each child was launched and reports
+ * the time until its first window is mapped, matched by _NET_WM_PID.
+ */
+class ChildTracker {
+public:
+    /**
+     * @brief Constructor
+     * @param loop The event loop to watch children from
+     */
+    ChildTracker(EventLoop& loop);
+
+    /**
+     * @brief Destructor that stops watching children
+     */
+    ~ChildTracker();
+
+    ChildTracker(const ChildTracker&) = delete;
+    ChildTracker& operator=(const ChildTracker&) = delete;
+
+    /**
+     * @brief Start tracking a launched process
+     * @param pid The PID of the child
+     * @param origin What launched the child, for the log
+     */
+    void track(pid_t pid, const std::string& origin);
+
+    /**
+     * @brief Check if any launched process is still expected to map a window
+     * @return true if a first-window latency is still pending
+     */
+    bool awaitingWindow();
+
+    /**
+     * @brief Report that a window owned by a process is being mapped
+     * @param pid The _NET_WM_PID of the window
+     * @param window The window being mapped
+     */
+    void windowMapped(pid_t pid, xcb_window_t window);
+
+    /**
+     * @brief Get the number of children that have not exited yet
+     * @return The number of live children
+     */
+    size_t size() const { return children.size(); }
+
+private:
+    struct Child {
+        std::string origin;
+        int pidfd;
+    };
+
+    struct PendingWindow {
+        std::string origin;
+        uint64_t spawnedAt;
+    };
+
+    EventLoop& loop;
+    bool usePidfd;
+    int signalFd;
+    std::unordered_map<pid_t, Child> children;
+    // Launches whose first window has not been mapped; a child that
+    // exited can no longer map one and is dropped when reaped
+    std::unordered_map<pid_t, PendingWindow> pendingWindows;
+    LatencyStats firstWindowStats;
+
+    /**
+     * @brief Collect the exit status of one child
+     * @param pid The PID of the child
+     */
+    void reap(pid_t pid);
+
+    /**
+     * @brief Collect the exit status of every exited child
+     *
+     * With pidfds, only the children that could not get one are looked at.
+     */
+    void reapAll();
+
+    /**
+     * @brief Start reaping on SIGCHLD, if not done already
+     * @return false if the signalfd could not be created
+     */
+    bool watchSignals();
+
+    /**
+     * @brief Forget launches whose window never appeared
+     */
+    void expirePendingWindows();
+};
+
+} // namespace X
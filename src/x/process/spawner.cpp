@@ -0,0 +1,208 @@
+#include "spawner.h"
+#include "../../log/logger.h"
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <spawn.h>
+#include <unistd.h>
+
+extern char** environ;
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34))
+#define DOOWM_HAVE_CLOSEFROM 1
+#endif
+
+namespace X {
+
+namespace {
+
+const char* methodName(Spawner::Method method) {
+    return method == Spawner::Method::Fork ? "fork" : "posix_spawn";
+}
+
+// Builds the NULL-terminated argument vector expected by exec
+std::vector<char*> toArgv(const std::vector<std::string>& args) {
+    std::vector<char*> argv;
+    argv.reserve(args.size() + 1);
+    for (const auto& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    return argv;
+}
+
+} // namespace
+
+Spawner::Spawner()
+    : method(Method::PosixSpawn),
+      spawnStats("Launch latency (posix_spawn)"),
+      forkStats("Launch latency (fork)") {
+    const char* override = std::getenv("DOOWM_SPAWN_METHOD");
+    if (override && std::strcmp(override, "fork") == 0) {
+        method = Method::Fork;
+    }
+    Logger::debug(std::string("Spawner initialized, method: ") + methodName(method));
+}
+
+Spawner::~Spawner() {
+    if (spawnStats.count()) {
+        Logger::info(spawnStats.summary());
+    }
+    if (forkStats.count()) {
+        Logger::info(forkStats.summary());
+    }
+}
+
+pid_t Spawner::spawn(const std::string& command) {
+    if (command.empty()) {
+        return -1;
+    }
+
+    bool direct = isSimpleCommand(command);
+    std::vector<std::string> args;
+    if (direct) {
+        args = splitWords(command);
+    } else {
+        args = { "/bin/sh", "-c", command };
+    }
+
+    uint64_t start = LatencyStats::nowMicros();
+    pid_t pid = method == Method::Fork ? spawnFork(args) : spawnPosix(args, direct);
+    uint64_t elapsed = LatencyStats::nowMicros() - start;
+
+    if (pid < 0) {
+        Logger::error("Failed to launch command: " + command);
+        return -1;
+    }
+
+    LatencyStats& stats = method == Method::Fork ? forkStats : spawnStats;
+    stats.record(elapsed);
+
+    Logger::debug("Launched command with PID " + std::to_string(pid) + " via " +
+                  methodName(method) + (direct ? " (direct exec)" : " (shell)") +
+                  " in " + std::to_string(elapsed) + "us");
+    return pid;
+}
+
+const LatencyStats& Spawner::getStats(Method method) const {
+    return method == Method::Fork ? forkStats : spawnStats;
+}
+
+pid_t Spawner::spawnPosix(const std::vector<std::string>& args, bool searchPath) {
+    posix_spawnattr_t attr;
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_init(&attr);
+    posix_spawn_file_actions_init(&actions);
+
+    // Detach from our session and undo any signal state the window
+    // manager set up for itself (blocked SIGCHLD, ignored SIGPIPE)
+    short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+#ifdef POSIX_SPAWN_SETSID
+    flags |= POSIX_SPAWN_SETSID;
+#else
+    flags |= POSIX_SPAWN_SETPGROUP;
+#endif
+    posix_spawnattr_setflags(&attr, flags);
+
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+
+    sigset_t defaults;
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGCHLD);
+    sigaddset(&defaults, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+
+#ifdef DOOWM_HAVE_CLOSEFROM
+    // Descriptors we own are close-on-exec already; this also catches
+    // ones opened by libraries that did not ask for it
+    posix_spawn_file_actions_addclosefrom_np(&actions, STDERR_FILENO + 1);
+#endif
+
+    auto argv = toArgv(args);
+    pid_t pid = -1;
+    int result = searchPath
+        ? posix_spawnp(&pid, argv[0], &actions, &attr, argv.data(), environ)
+        : posix_spawn(&pid, argv[0], &actions, &attr, argv.data(), environ);
+
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+
+    if (result != 0) {
+        Logger::warning("posix_spawn failed for " + args[0] + ": " + std::strerror(result));
+        return -1;
+    }
+    return pid;
+}
+
+pid_t Spawner::spawnFork(const std::vector<std::string>& args) {
+    // Everything the child touches is prepared before forking
+    auto argv = toArgv(args);
+    sigset_t mask;
+    sigemptyset(&mask);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        // Child process
+        setsid();
+        sigprocmask(SIG_SETMASK, &mask, nullptr);
+        signal(SIGCHLD, SIG_DFL);
+        signal(SIGPIPE, SIG_DFL);
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+
+    if (pid < 0) {
+        Logger::warning(std::string("fork failed: ") + std::strerror(errno));
+        return -1;
+    }
+    return pid;
+}
+
+bool Spawner::isSimpleCommand(const std::string& command) {
+    bool sawWord = false;
+    bool firstWord = true;
+    for (char c : command) {
+        if (c == ' ' || c == '\t') {
+            if (sawWord) {
+                firstWord = false;
+            }
+            continue;
+        }
+        sawWord = true;
+
+        bool plain = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                     (c >= '0' && c <= '9') || std::strchr("-_./:,+@%", c);
+        // "FOO=bar cmd" is an assignment, which only the shell understands
+        if (c == '=' && !firstWord) {
+            plain = true;
+        }
+        if (!plain) {
+            return false;
+        }
+    }
+    return sawWord;
+}
+
+std::vector<std::string> Spawner::splitWords(const std::string& command) {
+    std::vector<std::string> words;
+    std::string current;
+    for (char c : command) {
+        if (c == ' ' || c == '\t') {
+            if (!current.empty()) {
+                words.push_back(current);
+                current.clear();
+            }
+        } else {
+            current += c;
+        }
+    }
+    if (!current.empty()) {
+        words.push_back(current);
+    }
+    return words;
+}
+
+} // namespace X
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "../../log/latency_stats.h"
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+namespace X {
+
+/**
+ * @class Spawner
+ * @brief Launches external commands without forking the window manager
+ *
+ * Commands are started with posix_spawn, which glibc implements with a
+ * vfork-style clone so the page tables of the window manager are never
+ * copied. The child gets its own session, a clean signal mask and no
+ * inherited descriptors besides stdin, stdout and stderr.
+ *
+ * Simple commands (words without shell syntax) are executed directly;
+ * anything else goes through /bin/sh -c.
+ */
+class Spawner {
+public:
+    /**
+     * @enum Method
+     * @brief How child processes are created
+     */
+    enum class Method {
+        PosixSpawn,  // posix_spawn, the default
+        Fork         // fork + exec, kept to compare launch latency
+    };
+
+    /**
+     * @brief Constructor
+     *
+     * The method can be overridden with DOOWM_SPAWN_METHOD=fork.
+     */
+    Spawner();
+
+    /**
+     * @brief Destructor that reports the launch latency statistics
+     */
+    ~Spawner();
+
+    /**
+     * @brief Launch a command
+     * @param command The command line to run
+     * @return The PID of the child, or -1 on failure
+     */
+    pid_t spawn(const std::string& command);
+
+    /**
+     * @brief Set the method used to create child processes
+     * @param method The new method
+     */
+    void setMethod(Method method) { this->method = method; }
+
+    /**
+     * @brief Get the launch latency statistics of a method
+     * @param method The method
+     * @return Time spent in the parent to start a child, per method
+     */
+    const LatencyStats& getStats(Method method) const;
+
+    /**
+     * @brief Check if a command can be executed without a shell
+     * @param command The command line
+     * @return true if the command contains only plain words
+     */
+    static bool isSimpleCommand(const std::string& command);
+
+private:
+    Method method;
+    LatencyStats spawnStats;
+    LatencyStats forkStats;
+
+    /**
+     * @brief Start a child with posix_spawn
+     * @param argv The argument vector
+     * @param searchPath Whether to look the program up in PATH
+     * @return The PID of the child, or -1 on failure
+     */
+    pid_t spawnPosix(const std::vector<std::string>& argv, bool searchPath);
+
+    /**
+     * @brief Start a child with fork and exec
+     * @param argv The argument vector
+     * @return The PID of the child, or -1 on failure
+     */
+    pid_t spawnFork(const std::vector<std::string>& argv);
+
+    /**
+     * @brief Split a simple command into words
+     * @param command The command line
+     * @return The words of the command
+     */
+    static std::vector<std::string> splitWords(const std::string& command);
+};
+
+} // namespace X
@@ -0,0 +1,234 @@
+#include "rule_matcher.h"
+#include "../../log/logger.h"
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+namespace X {
+
+namespace {
+
+/**
+ * Split a line into words; double quotes keep spaces inside a word.
+ */
+std::vector<std::string> tokenize(const std::string& line) {
+    std::vector<std::string> words;
+    std::string word;
+    bool quoted = false;
+    bool any = false;
+    for (char c : line) {
+        if (c == '"') {
+            quoted = !quoted;
+            any = true;
+        } else if (!quoted && (c == ' ' || c == '\t')) {
+            if (any) {
+                words.push_back(word);
+            }
+            word.clear();
+            any = false;
+        } else {
+            word += c;
+            any = true;
+        }
+    }
+    if (any) {
+        words.push_back(word);
+    }
+    return words;
+}
+
+bool parseIndex(const std::string& value, size_t& index) {
+    char* end = nullptr;
+    unsigned long number = std::strtoul(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || number == 0) {
+        return false;
+    }
+    index = number - 1;
+    return true;
+}
+
+} // namespace
+
+RuleMatcher::RuleMatcher() {
+    compile({});
+}
+
+void RuleMatcher::compile(std::vector<Rule> newRules) {
+    rules = std::move(newRules);
+    conditions.assign(rules.size(), 0);
+    always.clear();
+    for (FieldIndex& index : fields) {
+        index.exact.clear();
+        index.trie.assign(1, TrieNode());
+    }
+
+    for (uint32_t i = 0; i < rules.size(); i++) {
+        const std::string* patterns[FieldCount] = { &rules[i].className, &rules[i].instance,
+                                                    &rules[i].title };
+        for (int field = 0; field < FieldCount; field++) {
+            // A lone '*' is the same as no pattern
+            const std::string& pattern = *patterns[field];
+            if (pattern.empty() || pattern == "*") {
+                continue;
+            }
+            insert(fields[field], pattern, i);
+            conditions[i]++;
+        }
+        if (!conditions[i]) {
+            always.push_back(i);
+        }
+    }
+}
+
+RuleActions RuleMatcher::match(const std::string& className, const std::string& instance,
+                               const std::string& title) const {
+    // Each field yields every rule whose pattern for it matches; a rule
+    // applies if all of its patterns turned up
+    std::vector<uint32_t> hits;
+    lookup(fields[Class], className, hits);
+    lookup(fields[Instance], instance, hits);
+    lookup(fields[Title], title, hits);
+    std::sort(hits.begin(), hits.end());
+
+    std::vector<uint32_t> matched(always);
+    for (size_t i = 0; i < hits.size();) {
+        size_t run = i;
+        while (run < hits.size() && hits[run] == hits[i]) {
+            run++;
+        }
+        if (run - i == conditions[hits[i]]) {
+            matched.push_back(hits[i]);
+        }
+        i = run;
+    }
+    std::sort(matched.begin(), matched.end());
+
+    RuleActions actions;
+    for (uint32_t i : matched) {
+        const Rule& rule = rules[i];
+        if (rule.workspace) {
+            actions.workspace = rule.workspace;
+        }
+        if (rule.monitor) {
+            actions.monitor = rule.monitor;
+        }
+        if (rule.floating) {
+            actions.floating = rule.floating;
+        }
+    }
+    return actions;
+}
+
+size_t RuleMatcher::parse(const std::string& text, std::vector<Rule>& out,
+                          std::vector<std::string>* problems) {
+    auto report = [problems](const std::string& message) {
+        if (problems) {
+            problems->push_back(message);
+        } else {
+            Logger::warning(message);
+        }
+    };
+
+    std::istringstream stream(text);
+    std::string line;
+    size_t number = 0;
+    size_t errors = 0;
+    while (std::getline(stream, line)) {
+        number++;
+        std::vector<std::string> words = tokenize(line);
+        if (words.empty() || words[0][0] == '#') {
+            continue;
+        }
+
+        Rule rule;
+        bool actions = false;
+        bool valid = true;
+        for (const std::string& word : words) {
+            if (word == "->") {
+                actions = true;
+                continue;
+            }
+            size_t equals = word.find('=');
+            std::string key = word.substr(0, equals);
+            std::string value = equals == std::string::npos ? std::string() : word.substr(equals + 1);
+            size_t index = 0;
+            if (!actions && key == "class") {
+                rule.className = value;
+            } else if (!actions && key == "instance") {
+                rule.instance = value;
+            } else if (!actions && key == "title") {
+                rule.title = value;
+            } else if (actions && key == "workspace" && parseIndex(value, index)) {
+                rule.workspace = static_cast<unsigned int>(index);
+            } else if (actions && key == "monitor" && parseIndex(value, index)) {
+                rule.monitor = index;
+            } else if (actions && word == "floating") {
+                rule.floating = true;
+            } else if (actions && word == "tiled") {
+                rule.floating = false;
+            } else {
+                report("Rules line " + std::to_string(number) + ": unknown \"" + word + "\"");
+                valid = false;
+                break;
+            }
+        }
+        if (!valid || !actions) {
+            if (valid) {
+                report("Rules line " + std::to_string(number) + ": missing \"->\"");
+            }
+            errors++;
+            continue;
+        }
+        out.push_back(std::move(rule));
+    }
+    return errors;
+}
+
+void RuleMatcher::insert(FieldIndex& index, const std::string& pattern, uint32_t rule) {
+    if (pattern.back() != '*') {
+        index.exact[pattern].push_back(rule);
+        return;
+    }
+
+    uint32_t node = 0;
+    for (size_t i = 0; i + 1 < pattern.size(); i++) {
+        char c = pattern[i];
+        auto& children = index.trie[node].children;
+        auto it = std::lower_bound(children.begin(), children.end(), std::make_pair(c, 0u),
+                                   [](const auto& a, const auto& b) { return a.first < b.first; });
+        if (it != children.end() && it->first == c) {
+            node = it->second;
+            continue;
+        }
+        uint32_t child = static_cast<uint32_t>(index.trie.size());
+        children.insert(it, { c, child });
+        index.trie.emplace_back();
+        node = child;
+    }
+    index.trie[node].rules.push_back(rule);
+}
+
+void RuleMatcher::lookup(const FieldIndex& index, const std::string& value, std::vector<uint32_t>& out) {
+    auto exact = index.exact.find(value);
+    if (exact != index.exact.end()) {
+        out.insert(out.end(), exact->second.begin(), exact->second.end());
+    }
+
+    uint32_t node = 0;
+    for (char c : value) {
+        const auto& children = index.trie[node].children;
+        if (children.empty()) {
+            break;
+        }
+        auto it = std::lower_bound(children.begin(), children.end(), std::make_pair(c, 0u),
+                                   [](const auto& a, const auto& b) { return a.first < b.first; });
+        if (it == children.end() || it->first != c) {
+            break;
+        }
+        node = it->second;
+        const auto& ending = index.trie[node].rules;
+        out.insert(out.end(), ending.begin(), ending.end());
+    }
+}
+
+} // namespace X
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace X {
+
+/**
+ * @struct Rule
+ * @brief A user rule: which windows it applies to and what it does to them
+ *
+ * Empty patterns match anything; a pattern ending in '*' matches by
+ * prefix, any other pattern must match exactly. A rule applies if all
+ * its patterns match.
+ */
+struct Rule {
+    std::string className;
+    std::string instance;
+    std::string title;
+    std::optional<unsigned int> workspace;
+    std::optional<size_t> monitor;   // Put it on the workspace shown there
+    std::optional<bool> floating;
+};
+
+/**
+ * @struct RuleActions
+ * @brief What the rules matching a window ask for
+ */
+struct RuleActions {
+    std::optional<unsigned int> workspace;
+    std::optional<size_t> monitor;
+    std::optional<bool> floating;
+};
+
+/**
+ * @class RuleMatcher
+ * @brief Window rules compiled for lookup by WM_CLASS and title
+ *
+ * Every pattern goes into a hash table (exact patterns) or a prefix trie
+ * (patterns ending in '*') for its field. Matching a window costs three
+ * hash lookups and one trie walk per field, bounded by the length of the
+ * strings, plus the rules that actually match; the total number of rules
+ * does not enter into it.
+ *
+ * Rules file lines look like
+ *
+ *     class=Firefox title=Private* -> workspace=2 floating
+ *
+ * with the conditions class=, instance= and title=, and the actions
+ * workspace=N (from 1), monitor=N (from 1), floating and tiled. Later
+ * rules override earlier ones. Empty lines and lines starting with '#'
+ * are ignored. The file is read along with the configuration, see Config.
+ */
+class RuleMatcher {
+public:
+    /**
+     * @brief Constructor for a matcher without rules
+     */
+    RuleMatcher();
+
+    /**
+     * @brief Compile rules, replacing any compiled before
+     * @param rules The rules, in order of increasing precedence
+     */
+    void compile(std::vector<Rule> rules);
+
+    /**
+     * @brief Find what the rules ask for a window
+     * @param className The class part of WM_CLASS
+     * @param instance The instance part of WM_CLASS
+     * @param title The window title
+     * @return The actions of all matching rules; later rules win
+     */
+    RuleActions match(const std::string& className, const std::string& instance,
+                      const std::string& title) const;
+
+    /**
+     * @brief Parse a rules file
+     * @param text The file contents
+     * @param rules Receives the rules
+     * @param problems Receives a message per skipped line; nullptr to log them
+     * @return The number of lines that could not be parsed
+     *
+     * Lines that cannot be parsed are skipped. Does not log when given
+     * problems, so it can run on any thread.
+     */
+    static size_t parse(const std::string& text, std::vector<Rule>& rules,
+                        std::vector<std::string>* problems = nullptr);
+
+    /**
+     * @brief Get the number of compiled rules
+     * @return The number of rules
+     */
+    size_t size() const { return rules.size(); }
+
+private:
+    enum Field : uint8_t {
+        Class,
+        Instance,
+        Title,
+        FieldCount
+    };
+
+    struct TrieNode {
+        std::vector<std::pair<char, uint32_t>> children;   // Sorted by character
+        std::vector<uint32_t> rules;                        // Prefixes ending here
+    };
+
+    struct FieldIndex {
+        std::unordered_map<std::string, std::vector<uint32_t>> exact;
+        std::vector<TrieNode> trie;   // Node 0 is the root
+    };
+
+    std::vector<Rule> rules;
+    std::vector<uint8_t> conditions;   // Non-empty patterns per rule
+    std::vector<uint32_t> always;      // Rules without patterns
+    FieldIndex fields[FieldCount];
+
+    /**
+     * @brief Add a pattern of a rule to the index of its field
+     * @param index The field index
+     * @param pattern The pattern, not empty
+     * @param rule The rule number
+     */
+    static void insert(FieldIndex& index, const std::string& pattern, uint32_t rule);
+
+    /**
+     * @brief Collect the rules whose pattern for a field matches a value
+     * @param index The field index
+     * @param value The value of the field
+     * @param out Receives the rule numbers
+     */
+    static void lookup(const FieldIndex& index, const std::string& value, std::vector<uint32_t>& out);
+};
+
+} // namespace X
@@ -0,0 +1,275 @@
+#include "stacking_order.h"
+#include "../../log/logger.h"
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace X {
+
+StackingOrder::StackingOrder(Connection& connection)
+    : connection(connection), disordered(false), version(0), sent(0), skipped(0) {
+}
+
+StackingOrder::~StackingOrder() {
+    if (sent || skipped) {
+        Logger::info("Stacking: " + std::to_string(sent) + " restacks sent, " +
+                     std::to_string(skipped) + " skipped as already in place");
+    }
+}
+
+void StackingOrder::add(xcb_window_t window, Layer layer, bool mapped) {
+    if (index.count(window)) {
+        return;
+    }
+    order.push_back({ window, layer, mapped, false });
+    index.emplace(window, std::prev(order.end()));
+    version++;
+    if (mapped) {
+        disordered = true;
+    }
+}
+
+void StackingOrder::remove(xcb_window_t window) {
+    auto it = index.find(window);
+    if (it == index.end()) {
+        return;
+    }
+    order.erase(it->second);
+    index.erase(it);
+    version++;
+}
+
+void StackingOrder::setMapped(xcb_window_t window, bool mapped) {
+    auto it = index.find(window);
+    if (it == index.end()) {
+        return;
+    }
+    Entry& entry = *it->second;
+    if (mapped && !entry.mapped && !entry.owned) {
+        disordered = true;
+    }
+    entry.mapped = mapped;
+}
+
+void StackingOrder::restacked(xcb_window_t window, xcb_window_t below) {
+    auto it = index.find(window);
+    if (it == index.end() || it->second->owned) {
+        return;
+    }
+    Iterator entry = it->second;
+
+    Iterator position = order.begin();
+    if (below != XCB_NONE) {
+        auto sibling = index.find(below);
+        if (sibling == index.end()) {
+            return;
+        }
+        position = std::next(sibling->second);
+    }
+    if (position == entry) {
+        return;
+    }
+    order.splice(position, order, entry);
+    version++;
+    if (entry->mapped) {
+        disordered = true;
+    }
+}
+
+void StackingOrder::setLayer(xcb_window_t window, Layer layer) {
+    // A frame we just created may not have had its CreateNotify yet;
+    // the server puts new windows on top
+    add(window, layer, false);
+    Iterator entry = index[window];
+    entry->layer = layer;
+    entry->owned = true;
+    version++;
+    raise(window);
+}
+
+bool StackingOrder::raise(xcb_window_t window) {
+    auto it = index.find(window);
+    if (it == index.end()) {
+        return false;
+    }
+    Iterator entry = it->second;
+
+    // Directly above the highest window of the same or a lower layer, or
+    // else below everything of the layers above
+    Iterator floor = highestAtOrBelow(entry, entry->layer);
+    if (floor != order.end()) {
+        return stack(entry, floor, true);
+    }
+    if (entry->layer != Layer::OverrideRedirect) {
+        Iterator ceiling = lowestAtOrAbove(entry, static_cast<Layer>(static_cast<int>(entry->layer) + 1));
+        if (ceiling != order.end()) {
+            return stack(entry, ceiling, false);
+        }
+    }
+    skipped++;
+    return false;
+}
+
+bool StackingOrder::lower(xcb_window_t window) {
+    auto it = index.find(window);
+    if (it == index.end()) {
+        return false;
+    }
+    Iterator entry = it->second;
+
+    // Directly above the highest window of the layers below, or else below
+    // everything of the same or a higher layer
+    if (entry->layer != Layer::Normal) {
+        Iterator floor = highestAtOrBelow(entry, static_cast<Layer>(static_cast<int>(entry->layer) - 1));
+        if (floor != order.end()) {
+            return stack(entry, floor, true);
+        }
+    }
+    Iterator ceiling = lowestAtOrAbove(entry, entry->layer);
+    if (ceiling != order.end()) {
+        return stack(entry, ceiling, false);
+    }
+    skipped++;
+    return false;
+}
+
+size_t StackingOrder::restore() {
+    if (!disordered) {
+        return 0;
+    }
+    disordered = false;
+
+    std::vector<Iterator> mapped;
+    for (Iterator it = order.begin(); it != order.end(); ++it) {
+        if (it->mapped) {
+            mapped.push_back(it);
+        }
+    }
+    auto byLayer = [](Iterator a, Iterator b) { return a->layer < b->layer; };
+    if (std::is_sorted(mapped.begin(), mapped.end(), byLayer)) {
+        return 0;
+    }
+
+    // Heaviest subsequence already in layer order. Windows of others must
+    // stay where they are, so each outweighs all of ours together; of
+    // ours, the fewest possible are left out. With four layers this is
+    // linear
+    size_t n = mapped.size();
+    uint64_t foreignWeight = n + 1;
+    constexpr size_t kLayers = static_cast<size_t>(Layer::Count);
+    std::array<uint64_t, kLayers> best{};
+    std::array<size_t, kLayers> bestEnd{};
+    std::vector<size_t> previous(n, n);
+    for (size_t i = 0; i < n; i++) {
+        size_t layer = static_cast<size_t>(mapped[i]->layer);
+        size_t from = 0;
+        for (size_t k = 1; k <= layer; k++) {
+            if (best[k] > best[from]) {
+                from = k;
+            }
+        }
+        uint64_t weight = best[from] + (mapped[i]->owned ? 1 : foreignWeight);
+        previous[i] = best[from] ? bestEnd[from] : n;
+        if (weight > best[layer]) {
+            best[layer] = weight;
+            bestEnd[layer] = i;
+        }
+    }
+
+    std::vector<bool> kept(n, false);
+    size_t last = std::max_element(best.begin(), best.end()) - best.begin();
+    for (size_t i = bestEnd[last]; i != n; i = previous[i]) {
+        kept[i] = true;
+    }
+
+    // Move the rest of ours into place bottom up, each relative to the
+    // window that ends up directly below it
+    std::vector<size_t> target(n);
+    for (size_t i = 0; i < n; i++) {
+        target[i] = i;
+    }
+    std::stable_sort(target.begin(), target.end(), [&mapped](size_t a, size_t b) {
+        return mapped[a]->layer < mapped[b]->layer;
+    });
+
+    size_t restacks = 0;
+    for (size_t position = 0; position < n; position++) {
+        size_t i = target[position];
+        if (kept[i] || !mapped[i]->owned) {
+            continue;
+        }
+        bool moved = position > 0 ? stack(mapped[i], mapped[target[position - 1]], true)
+                                  : stack(mapped[i], mapped[target[1]], false);
+        if (moved) {
+            restacks++;
+        }
+    }
+    return restacks;
+}
+
+void StackingOrder::getOwned(std::vector<xcb_window_t>& out) const {
+    for (const Entry& entry : order) {
+        if (entry.owned) {
+            out.push_back(entry.window);
+        }
+    }
+}
+
+StackingOrder::Iterator StackingOrder::highestAtOrBelow(Iterator except, Layer maxLayer) {
+    for (Iterator it = order.end(); it != order.begin();) {
+        --it;
+        if (it != except && it->mapped && it->layer <= maxLayer) {
+            return it;
+        }
+    }
+    return order.end();
+}
+
+StackingOrder::Iterator StackingOrder::lowestAtOrAbove(Iterator except, Layer minLayer) {
+    for (Iterator it = order.begin(); it != order.end(); ++it) {
+        if (it != except && it->mapped && it->layer >= minLayer) {
+            return it;
+        }
+    }
+    return order.end();
+}
+
+bool StackingOrder::stack(Iterator entry, Iterator sibling, bool above) {
+    // Already in place if the nearest mapped window on that side is the
+    // sibling
+    Iterator nearest = order.end();
+    if (above) {
+        for (Iterator it = entry; it != order.begin();) {
+            --it;
+            if (it->mapped) {
+                nearest = it;
+                break;
+            }
+        }
+    } else {
+        for (Iterator it = std::next(entry); it != order.end(); ++it) {
+            if (it->mapped) {
+                nearest = it;
+                break;
+            }
+        }
+    }
+    if (nearest == sibling) {
+        skipped++;
+        return false;
+    }
+
+    uint32_t values[2] = { sibling->window,
+                           static_cast<uint32_t>(above ? XCB_STACK_MODE_ABOVE : XCB_STACK_MODE_BELOW) };
+    auto cookie = xcb_configure_window(connection.getConnection(), entry->window,
+                                       XCB_CONFIG_WINDOW_SIBLING | XCB_CONFIG_WINDOW_STACK_MODE,
+                                       values);
+    connection.track(cookie, ErrorTracker::Request::ConfigureWindow, entry->window);
+
+    order.splice(above ? std::next(sibling) : sibling, order, entry);
+    version++;
+    sent++;
+    return true;
+}
+
+} // namespace X
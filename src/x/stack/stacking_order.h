@@ -0,0 +1,196 @@
+#pragma once
+
+#include "../connection/connection.h"
+#include <xcb/xcb.h>
+#include <cstdint>
+#include <list>
+#include <vector>
+#include <unordered_map>
+
+namespace X {
+
+/**
+ * @class StackingOrder
+ * @brief Local model of the stacking order of the root window's children
+ *
+ * Every child of the root window is kept bottom to top together with its
+ * layer and whether it is mapped. The model follows the window manager's
+ * own restacks as they are sent and the rest of the world through
+ * CreateNotify, ConfigureNotify, MapNotify, UnmapNotify, ReparentNotify
+ * and DestroyNotify on the root window.
+ *
+ * A restack is computed against the model: it becomes at most one
+ * sibling-relative configure, and none at all if the window already is
+ * where it should be among the mapped windows. Only windows handed over
+ * with setLayer(), the frames, are ever restacked on our own initiative.
+ */
+class StackingOrder {
+public:
+    /**
+     * @enum Layer
+     * @brief Stacking layers, bottom to top
+     */
+    enum class Layer : uint8_t {
+        Normal,
+        Floating,
+        Fullscreen,
+        OverrideRedirect,
+        Count
+    };
+
+    /**
+     * @brief Constructor
+     * @param connection The X connection
+     */
+    explicit StackingOrder(Connection& connection);
+
+    /**
+     * @brief Destructor that reports how many restacks were skipped
+     */
+    ~StackingOrder();
+
+    StackingOrder(const StackingOrder&) = delete;
+    StackingOrder& operator=(const StackingOrder&) = delete;
+
+    /**
+     * @brief Add a child of the root window on top of the stack
+     * @param window The window ID
+     * @param layer The layer
+     * @param mapped Whether the window is mapped
+     *
+     * New and reparented windows start on top; a window already known is
+     * left where it is.
+     */
+    void add(xcb_window_t window, Layer layer, bool mapped);
+
+    /**
+     * @brief Forget a window that was destroyed or left the root window
+     * @param window The window ID
+     */
+    void remove(xcb_window_t window);
+
+    /**
+     * @brief Record that a window was mapped or unmapped
+     * @param window The window ID
+     * @param mapped Whether the window is mapped now
+     */
+    void setMapped(xcb_window_t window, bool mapped);
+
+    /**
+     * @brief Record a restack reported by a ConfigureNotify
+     * @param window The window ID
+     * @param below The sibling now directly below the window, or XCB_NONE
+     *
+     * Ignored for windows we stack ourselves, whose position in the model
+     * is never older than the notification.
+     */
+    void restacked(xcb_window_t window, xcb_window_t below);
+
+    /**
+     * @brief Put a window in a layer and raise it to the top of the layer
+     * @param window The window ID
+     * @param layer The layer
+     *
+     * The window is stacked by the window manager from now on.
+     */
+    void setLayer(xcb_window_t window, Layer layer);
+
+    /**
+     * @brief Raise a window to the top of its layer
+     * @param window The window ID
+     * @return true if a restack was sent, false if none was needed
+     *
+     * The request is not flushed.
+     */
+    bool raise(xcb_window_t window);
+
+    /**
+     * @brief Lower a window to the bottom of its layer
+     * @param window The window ID
+     * @return true if a restack was sent, false if none was needed
+     *
+     * The request is not flushed.
+     */
+    bool lower(xcb_window_t window);
+
+    /**
+     * @brief Bring our windows back into layer order after outside changes
+     * @return The number of restacks sent
+     *
+     * Windows placed by others are never moved. Of ours, only those
+     * outside the longest run already in layer order are restacked.
+     * The requests are not flushed.
+     */
+    size_t restore();
+
+    /**
+     * @brief Check if a window is a known child of the root window
+     * @param window The window ID
+     * @return true if the window is in the model, false otherwise
+     */
+    bool contains(xcb_window_t window) const { return index.count(window) > 0; }
+
+    /**
+     * @brief Get the number of windows in the model
+     * @return The number of children of the root window
+     */
+    size_t size() const { return order.size(); }
+
+    /**
+     * @brief Get a counter that changes whenever the order changes
+     * @return The version of the model
+     */
+    uint64_t getVersion() const { return version; }
+
+    /**
+     * @brief List the windows stacked by us, bottom to top
+     * @param out Receives the window IDs
+     */
+    void getOwned(std::vector<xcb_window_t>& out) const;
+
+private:
+    struct Entry {
+        xcb_window_t window;
+        Layer layer;
+        bool mapped;
+        bool owned;   // Stacked by us, see setLayer()
+    };
+    using Iterator = std::list<Entry>::iterator;
+
+    Connection& connection;
+    std::list<Entry> order;   // Bottom to top
+    std::unordered_map<xcb_window_t, Iterator> index;
+    bool disordered;          // Outside changes since the last restore()
+    uint64_t version;
+    uint64_t sent;
+    uint64_t skipped;
+
+    /**
+     * @brief Find the highest mapped window in a layer or below
+     * @param except A window to leave out
+     * @param maxLayer The highest layer that matches
+     * @return The entry, or order.end() if none matches
+     */
+    Iterator highestAtOrBelow(Iterator except, Layer maxLayer);
+
+    /**
+     * @brief Find the lowest mapped window in a layer or above
+     * @param except A window to leave out
+     * @param minLayer The lowest layer that matches
+     * @return The entry, or order.end() if none matches
+     */
+    Iterator lowestAtOrAbove(Iterator except, Layer minLayer);
+
+    /**
+     * @brief Stack a window directly above or below a sibling
+     * @param entry The window
+     * @param sibling The mapped sibling
+     * @param above Whether to stack above the sibling
+     * @return true if a restack was sent, false if it already was there
+     *
+     * Unmapped windows in between do not count.
+     */
+    bool stack(Iterator entry, Iterator sibling, bool above);
+};
+
+} // namespace X
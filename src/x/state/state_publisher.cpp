@@ -0,0 +1,122 @@
+#include "state_publisher.h"
+#include "../../log/logger.h"
+
+namespace X {
+
+StatePublisher::StatePublisher(ClientManager& clients, WorkspaceManager& workspaces, MonitorManager& monitors)
+    : clients(clients), workspaces(workspaces), monitors(monitors), published(0), clientsCopied(0),
+      chunksCopied(0) {
+    // Clients managed so far go into the first snapshot like new ones
+    ClientChanges& changes = clients.getChanges();
+    changes.setEnabled(true);
+    std::vector<Client*> all;
+    clients.getAll(all);
+    for (const Client* client : all) {
+        changes.mark(client->getId());
+    }
+
+    last = std::make_shared<const StateSnapshot>(StateSnapshot{ 0, {}, {}, {}, {}, 0, XCB_NONE, {} });
+    snapshot.store(last, std::memory_order_release);
+    publish();
+}
+
+StatePublisher::~StatePublisher() {
+    clients.getChanges().setEnabled(false);
+    if (published) {
+        Logger::info("State snapshots: " + std::to_string(published) + " published, " +
+                     std::to_string(clientsCopied) + " client entries and " +
+                     std::to_string(chunksCopied) + " chunks copied");
+    }
+}
+
+bool StatePublisher::publish() {
+    std::shared_ptr<StateSnapshot> next = build();
+    if (!next) {
+        return false;
+    }
+    last = next;
+    snapshot.store(last, std::memory_order_release);
+    published++;
+    return true;
+}
+
+std::shared_ptr<StateSnapshot> StatePublisher::build() {
+    // The small parts are rebuilt and compared every time
+    std::vector<WorkspaceState> workspaceStates(workspaces.getCount());
+    for (unsigned int i = 0; i < workspaceStates.size(); i++) {
+        workspaceStates[i] = { workspaces.getMonitor(i), workspaces.getClientCount(i) };
+    }
+    const std::vector<Monitor>& monitorList = monitors.getMonitors();
+    std::vector<int> shown(monitorList.size());
+    for (size_t i = 0; i < shown.size(); i++) {
+        shown[i] = workspaces.shownOn(i);
+    }
+    Client* focusedClient = workspaces.getFocused();
+    xcb_window_t focused = focusedClient ? focusedClient->getId() : XCB_NONE;
+    const std::string& focusedTitle = focusedClient ? focusedClient->getTitle() : std::string();
+
+    clients.getChanges().take(changed);
+    if (changed.empty() && workspaceStates == last->workspaces && monitorList == last->monitors &&
+        shown == last->shown && workspaces.getCurrent() == last->current && focused == last->focused &&
+        focusedTitle == last->focusedTitle) {
+        return nullptr;
+    }
+
+    auto next = std::make_shared<StateSnapshot>(StateSnapshot{
+        last->version + 1, last->clients, std::move(workspaceStates), monitorList, std::move(shown),
+        workspaces.getCurrent(), focused, focusedTitle });
+
+    // Chunks still shared with the last snapshot are copied on first write
+    std::vector<std::pair<size_t, StateSnapshot::Chunk*>> copies;
+    auto edit = [&](uint32_t slot) -> ClientState& {
+        size_t index = slot / StateSnapshot::kChunkSize;
+        for (const auto& copy : copies) {
+            if (copy.first == index) {
+                return (*copy.second)[slot % StateSnapshot::kChunkSize];
+            }
+        }
+        if (index >= next->clients.size()) {
+            next->clients.resize(index + 1);
+        }
+        auto chunk = next->clients[index]
+                         ? std::make_shared<StateSnapshot::Chunk>(*next->clients[index])
+                         : std::make_shared<StateSnapshot::Chunk>(StateSnapshot::kChunkSize,
+                                                                  ClientState{ XCB_NONE, 0, false, {}, {} });
+        copies.emplace_back(index, chunk.get());
+        next->clients[index] = std::move(chunk);
+        chunksCopied++;
+        return (*copies.back().second)[slot % StateSnapshot::kChunkSize];
+    };
+
+    for (xcb_window_t window : changed) {
+        Client* client = clients.find(window);
+        auto it = slots.find(window);
+        if (!client) {
+            if (it != slots.end()) {
+                edit(it->second) = ClientState{ XCB_NONE, 0, false, {}, {} };
+                freeSlots.push_back(it->second);
+                slots.erase(it);
+            }
+            continue;
+        }
+
+        if (it == slots.end()) {
+            uint32_t slot = static_cast<uint32_t>(slots.size());
+            if (!freeSlots.empty()) {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+            }
+            it = slots.emplace(window, slot).first;
+        }
+        ClientState& state = edit(it->second);
+        state.window = window;
+        state.workspace = client->getWorkspace();
+        state.floating = client->isFloating();
+        state.geometry = client->getGeometry();
+        state.title = client->getTitle();
+        clientsCopied++;
+    }
+    return next;
+}
+
+} // namespace X
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "../client/client_manager.h"
+#include "../layout/rect.h"
+#include "../monitor/monitor_manager.h"
+#include "../workspace/workspace_manager.h"
+#include <xcb/xcb.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace X {
+
+/**
+ * @struct ClientState
+ * @brief What a snapshot holds about a client
+ */
+struct ClientState {
+    xcb_window_t window;   // XCB_NONE for an unused slot
+    unsigned int workspace;
+    bool floating;
+    Rect geometry;         // Including the border
+    std::string title;
+};
+
+/**
+ * @struct WorkspaceState
+ * @brief What a snapshot holds about a workspace
+ */
+struct WorkspaceState {
+    int monitor;   // -1 if not shown
+    size_t clients;
+
+    bool operator==(const WorkspaceState& other) const {
+        return monitor == other.monitor && clients == other.clients;
+    }
+};
+
+/**
+ * @struct StateSnapshot
+ * @brief Immutable copy of the window manager state at the end of a pass
+ *
+ * Clients are kept in fixed-size chunks shared between snapshots; a
+ * chunk is copied only when one of its clients changed. Unused slots
+ * have no window.
+ */
+struct StateSnapshot {
+    static constexpr size_t kChunkSize = 64;
+    using Chunk = std::vector<ClientState>;
+
+    uint64_t version;   // Increases with every published change
+    std::vector<std::shared_ptr<const Chunk>> clients;
+    std::vector<WorkspaceState> workspaces;
+    std::vector<Monitor> monitors;
+    std::vector<int> shown;   // Workspace on each monitor, -1 for none
+    unsigned int current;
+    xcb_window_t focused;     // XCB_NONE if no client has the focus
+    std::string focusedTitle;
+};
+
+/**
+ * @class StatePublisher
+ * @brief Publishes a StateSnapshot after every pass that changed something
+ *
+ * Readers on other threads take the current snapshot with one atomic
+ * load and keep it as long as they like; the main thread never waits
+ * for them and never changes a published snapshot. Publishing costs the
+ * changed clients, reported through ClientChanges, plus a pointer per
+ * chunk and the few workspaces and monitors; the number of clients that
+ * did not change hardly enters into it.
+ */
+class StatePublisher {
+public:
+    /**
+     * @brief Constructor that starts tracking changes and publishes the current state
+     * @param clients The client registry
+     * @param workspaces The workspace manager
+     * @param monitors The monitor manager
+     */
+    StatePublisher(ClientManager& clients, WorkspaceManager& workspaces, MonitorManager& monitors);
+
+    /**
+     * @brief Destructor that stops tracking and reports statistics
+     */
+    ~StatePublisher();
+
+    StatePublisher(const StatePublisher&) = delete;
+    StatePublisher& operator=(const StatePublisher&) = delete;
+
+    /**
+     * @brief Publish a new snapshot if anything changed (main thread only)
+     * @return true if a snapshot was published, false otherwise
+     */
+    bool publish();
+
+    /**
+     * @brief Get the latest snapshot (any thread)
+     * @return The snapshot, never nullptr
+     */
+    std::shared_ptr<const StateSnapshot> current() const { return snapshot.load(std::memory_order_acquire); }
+
+private:
+    ClientManager& clients;
+    WorkspaceManager& workspaces;
+    MonitorManager& monitors;
+    std::atomic<std::shared_ptr<const StateSnapshot>> snapshot;
+    std::shared_ptr<const StateSnapshot> last;   // The same, without the atomic load
+    std::unordered_map<xcb_window_t, uint32_t> slots;
+    std::vector<uint32_t> freeSlots;
+    std::vector<xcb_window_t> changed;   // Reused for every publish
+    uint64_t published;
+    uint64_t clientsCopied;
+    uint64_t chunksCopied;
+
+    /**
+     * @brief Build a snapshot from the last one and the changed clients
+     * @return The snapshot, or nullptr if nothing changed
+     */
+    std::shared_ptr<StateSnapshot> build();
+};
+
+} // namespace X
@@ -0,0 +1,68 @@
+#include "frame_pool.h"
+#include "../../log/logger.h"
+
+namespace X {
+
+FramePool::FramePool(Connection& connection, size_t capacity)
+    : connection(connection), capacity(capacity), created(0), reused(0), destroyed(0) {
+    frames.reserve(capacity);
+}
+
+FramePool::~FramePool() {
+    xcb_connection_t* conn = connection.getConnection();
+    for (xcb_window_t frame : frames) {
+        xcb_destroy_window(conn, frame);
+    }
+    if (created) {
+        Logger::info("Frame pool: " + std::to_string(created) + " created, " +
+                     std::to_string(reused) + " reused, " +
+                     std::to_string(destroyed) + " destroyed over capacity");
+    }
+}
+
+xcb_window_t FramePool::acquire() {
+    if (!frames.empty()) {
+        xcb_window_t frame = frames.back();
+        frames.pop_back();
+        reused++;
+        return frame;
+    }
+
+    // Override-redirect keeps our own frames out of CreateNotify handling;
+    // without a background the client's contents are never cleared over
+    xcb_window_t frame = connection.generateId();
+    uint32_t mask = XCB_CW_BORDER_PIXEL | XCB_CW_OVERRIDE_REDIRECT | XCB_CW_EVENT_MASK;
+    uint32_t values[3];
+    values[0] = 0x000000;
+    values[1] = 1;
+    values[2] = XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT | XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY;
+
+    auto cookie = xcb_create_window(
+        connection.getConnection(),
+        XCB_COPY_FROM_PARENT,
+        frame,
+        connection.getRootWindow(),
+        0, 0, 1, 1,
+        0,
+        XCB_WINDOW_CLASS_INPUT_OUTPUT,
+        connection.getScreen()->root_visual,
+        mask, values
+    );
+    connection.track(cookie, ErrorTracker::Request::CreateWindow, frame);
+    created++;
+    return frame;
+}
+
+void FramePool::release(xcb_window_t frame) {
+    xcb_connection_t* conn = connection.getConnection();
+    if (frames.size() >= capacity) {
+        xcb_destroy_window(conn, frame);
+        destroyed++;
+        return;
+    }
+
+    connection.track(xcb_unmap_window(conn, frame), ErrorTracker::Request::UnmapWindow, frame);
+    frames.push_back(frame);
+}
+
+} // namespace X
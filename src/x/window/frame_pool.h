@@ -0,0 +1,68 @@
+#pragma once
+
+#include "../connection/connection.h"
+#include <xcb/xcb.h>
+#include <cstddef>
+#include <vector>
+
+namespace X {
+
+/**
+ * @class FramePool
+ * @brief Recycles the frame windows clients are reparented into
+ *
+ * A released frame is unmapped and kept for the next client instead of
+ * being destroyed, so workloads that open and close many windows do not
+ * create and destroy an X window per client. At most a fixed number of
+ * frames is kept; any beyond that are destroyed.
+ */
+class FramePool {
+public:
+    /**
+     * @brief Constructor
+     * @param connection The X connection
+     * @param capacity Maximum number of idle frames kept
+     */
+    FramePool(Connection& connection, size_t capacity = 64);
+
+    /**
+     * @brief Destructor that destroys the idle frames and reports reuse
+     */
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    /**
+     * @brief Get an unmapped frame, reusing an idle one if there is any
+     * @return The frame window ID
+     *
+     * The frame is a child of the root window and redirects the map and
+     * configure requests of its child. Requests are not flushed.
+     */
+    xcb_window_t acquire();
+
+    /**
+     * @brief Return a frame whose client has been reparented away or destroyed
+     * @param frame The frame window ID
+     *
+     * Requests are not flushed.
+     */
+    void release(xcb_window_t frame);
+
+    /**
+     * @brief Get the number of idle frames
+     * @return The number of frames ready for reuse
+     */
+    size_t idle() const { return frames.size(); }
+
+private:
+    Connection& connection;
+    size_t capacity;
+    std::vector<xcb_window_t> frames;   // Idle frames, reused last in first out
+    size_t created;
+    size_t reused;
+    size_t destroyed;
+};
+
+} // namespace X
@@ -1,6 +1,8 @@
 #include "window.h"
 #include "../../log/logger.h"
 #include <xcb/xcb_icccm.h>
+#include <utility>
+#include <vector>
 
 namespace X {
 
@@ -57,16 +59,28 @@ void Window::initialize() {
 
 void Window::map() {
     Logger::debug("Mapping window: " + std::to_string(windowId));
-    xcb_map_window(connection.getConnection(), windowId);
+    connection.track(xcb_map_window(connection.getConnection(), windowId),
+                     ErrorTracker::Request::MapWindow, windowId);
     connection.flush();
 }
 
 void Window::unmap() {
     Logger::debug("Unmapping window: " + std::to_string(windowId));
-    xcb_unmap_window(connection.getConnection(), windowId);
+    connection.track(xcb_unmap_window(connection.getConnection(), windowId),
+                     ErrorTracker::Request::UnmapWindow, windowId);
     connection.flush();
 }
 
+void Window::queueMap() {
+    connection.track(xcb_map_window(connection.getConnection(), windowId),
+                     ErrorTracker::Request::MapWindow, windowId);
+}
+
+void Window::queueUnmap() {
+    connection.track(xcb_unmap_window(connection.getConnection(), windowId),
+                     ErrorTracker::Request::UnmapWindow, windowId);
+}
+
 void Window::configure(int x, int y, unsigned int width, unsigned int height, 
                       unsigned int borderWidth, uint32_t stackMode) {
     uint32_t mask = XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y |
@@ -81,7 +95,8 @@ void Window::configure(int x, int y, unsigned int width, unsigned int height,
     values[4] = borderWidth;
     values[5] = stackMode;
     
-    xcb_configure_window(connection.getConnection(), windowId, mask, values);
+    connection.track(xcb_configure_window(connection.getConnection(), windowId, mask, values),
+                     ErrorTracker::Request::ConfigureWindow, windowId);
     connection.flush();
     
     Logger::debug("Configured window " + std::to_string(windowId) + 
@@ -92,13 +107,28 @@ void Window::configure(int x, int y, unsigned int width, unsigned int height,
                  ", border=" + std::to_string(borderWidth));
 }
 
+void Window::configure(int x, int y, unsigned int width, unsigned int height) {
+    uint32_t mask = XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y |
+                    XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT;
+    
+    uint32_t values[4];
+    values[0] = x;
+    values[1] = y;
+    values[2] = width;
+    values[3] = height;
+    
+    connection.track(xcb_configure_window(connection.getConnection(), windowId, mask, values),
+                     ErrorTracker::Request::ConfigureWindow, windowId);
+}
+
 void Window::move(int x, int y) {
     uint32_t mask = XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y;
     uint32_t values[2];
     values[0] = x;
     values[1] = y;
     
-    xcb_configure_window(connection.getConnection(), windowId, mask, values);
+    connection.track(xcb_configure_window(connection.getConnection(), windowId, mask, values),
+                     ErrorTracker::Request::ConfigureWindow, windowId);
     connection.flush();
     
     Logger::debug("Moved window " + std::to_string(windowId) + 
@@ -112,7 +142,8 @@ void Window::resize(unsigned int width, unsigned int height) {
     values[0] = width;
     values[1] = height;
     
-    xcb_configure_window(connection.getConnection(), windowId, mask, values);
+    connection.track(xcb_configure_window(connection.getConnection(), windowId, mask, values),
+                     ErrorTracker::Request::ConfigureWindow, windowId);
     connection.flush();
     
     Logger::debug("Resized window " + std::to_string(windowId) + 
@@ -125,7 +156,8 @@ void Window::setBorderWidth(unsigned int width) {
     uint32_t values[1];
     values[0] = width;
     
-    xcb_configure_window(connection.getConnection(), windowId, mask, values);
+    connection.track(xcb_configure_window(connection.getConnection(), windowId, mask, values),
+                     ErrorTracker::Request::ConfigureWindow, windowId);
     connection.flush();
     
     Logger::debug("Set border width of window " + std::to_string(windowId) + 
@@ -137,7 +169,8 @@ void Window::setBorderColor(uint32_t color) {
     uint32_t values[1];
     values[0] = color;
     
-    xcb_change_window_attributes(connection.getConnection(), windowId, mask, values);
+    connection.track(xcb_change_window_attributes(connection.getConnection(), windowId, mask, values),
+                     ErrorTracker::Request::ChangeAttributes, windowId);
     connection.flush();
     
     Logger::debug("Set border color of window " + std::to_string(windowId) + 
@@ -146,12 +179,13 @@ void Window::setBorderColor(uint32_t color) {
 
 void Window::focus() {
     // Set input focus to this window
-    xcb_set_input_focus(
+    auto cookie = xcb_set_input_focus(
         connection.getConnection(),
         XCB_INPUT_FOCUS_POINTER_ROOT,
         windowId,
         XCB_CURRENT_TIME
     );
+    connection.track(cookie, ErrorTracker::Request::SetInputFocus, windowId);
     
     // Raise the window to the top
     raise();
@@ -166,7 +200,8 @@ void Window::raise() {
     uint32_t values[1];
     values[0] = XCB_STACK_MODE_ABOVE;
     
-    xcb_configure_window(connection.getConnection(), windowId, mask, values);
+    connection.track(xcb_configure_window(connection.getConnection(), windowId, mask, values),
+                     ErrorTracker::Request::ConfigureWindow, windowId);
     connection.flush();
     
     Logger::debug("Raised window: " + std::to_string(windowId));
@@ -177,7 +212,8 @@ void Window::lower() {
     uint32_t values[1];
     values[0] = XCB_STACK_MODE_BELOW;
     
-    xcb_configure_window(connection.getConnection(), windowId, mask, values);
+    connection.track(xcb_configure_window(connection.getConnection(), windowId, mask, values),
+                     ErrorTracker::Request::ConfigureWindow, windowId);
     connection.flush();
     
     Logger::debug("Lowered window: " + std::to_string(windowId));
@@ -216,60 +252,219 @@ bool Window::getGeometry(int& x, int& y, unsigned int& width,
 }
 
 bool Window::shouldManage(Connection& connection, xcb_window_t windowId) {
-    // Get window attributes to check if it's viewable
-    xcb_get_window_attributes_cookie_t attr_cookie = 
-        xcb_get_window_attributes(connection.getConnection(), windowId);
-    
-    xcb_get_window_attributes_reply_t* attr_reply = 
-        xcb_get_window_attributes_reply(connection.getConnection(), attr_cookie, nullptr);
-    
-    if (!attr_reply) {
-        return false;
+    return readManage(connection, queryManage(connection, windowId)).shouldManage(true);
+}
+
+namespace {
+
+const std::pair<const char*, Window::ManageInfo::Type> kWindowTypes[] = {
+    { "_NET_WM_WINDOW_TYPE_NORMAL", Window::ManageInfo::Type::Normal },
+    { "_NET_WM_WINDOW_TYPE_DIALOG", Window::ManageInfo::Type::Dialog },
+    { "_NET_WM_WINDOW_TYPE_UTILITY", Window::ManageInfo::Type::Utility },
+    { "_NET_WM_WINDOW_TYPE_TOOLBAR", Window::ManageInfo::Type::Toolbar },
+    { "_NET_WM_WINDOW_TYPE_SPLASH", Window::ManageInfo::Type::Splash },
+    { "_NET_WM_WINDOW_TYPE_MENU", Window::ManageInfo::Type::Menu },
+    { "_NET_WM_WINDOW_TYPE_DOCK", Window::ManageInfo::Type::Dock },
+    { "_NET_WM_WINDOW_TYPE_DESKTOP", Window::ManageInfo::Type::Desktop },
+    { "_NET_WM_WINDOW_TYPE_NOTIFICATION", Window::ManageInfo::Type::Notification },
+    { "_NET_WM_WINDOW_TYPE_DROPDOWN_MENU", Window::ManageInfo::Type::Popup },
+    { "_NET_WM_WINDOW_TYPE_POPUP_MENU", Window::ManageInfo::Type::Popup },
+    { "_NET_WM_WINDOW_TYPE_TOOLTIP", Window::ManageInfo::Type::Popup },
+    { "_NET_WM_WINDOW_TYPE_COMBO", Window::ManageInfo::Type::Popup },
+    { "_NET_WM_WINDOW_TYPE_DND", Window::ManageInfo::Type::Popup },
+};
+
+std::string propertyString(const xcb_get_property_reply_t* reply) {
+    if (!reply || reply->format != 8) {
+        return std::string();
     }
-    
-    // Check if the window is already mapped (viewable)
-    bool viewable = attr_reply->map_state == XCB_MAP_STATE_VIEWABLE;
-    bool override_redirect = attr_reply->override_redirect;
-    free(attr_reply);
-    
-    // Don't manage windows with override_redirect set
-    if (override_redirect) {
-        return false;
+    auto mutableReply = const_cast<xcb_get_property_reply_t*>(reply);
+    return std::string(static_cast<const char*>(xcb_get_property_value(mutableReply)),
+                       xcb_get_property_value_length(mutableReply));
+}
+
+Window::ManageInfo parseManage(Connection& connection,
+                               const xcb_get_window_attributes_reply_t* attributes,
+                               const xcb_get_geometry_reply_t* geometry,
+                               const xcb_get_property_reply_t* windowClass,
+                               const xcb_get_property_reply_t* windowType,
+                               const xcb_get_property_reply_t* transientFor,
+                               const xcb_get_property_reply_t* title,
+                               const xcb_get_property_reply_t* legacyTitle) {
+    Window::ManageInfo info{};
+    info.exists = attributes != nullptr;
+    if (!attributes) {
+        return info;
     }
-    
-    // Get window type
-    xcb_get_property_cookie_t type_cookie = xcb_get_property(
-        connection.getConnection(),
-        0,
-        windowId,
-        XCB_ATOM_WM_CLASS,
-        XCB_ATOM_STRING,
-        0,
-        1024
-    );
-    
-    xcb_get_property_reply_t* type_reply = 
-        xcb_get_property_reply(connection.getConnection(), type_cookie, nullptr);
-    
-    bool should_manage = true;
-    
-    if (type_reply) {
-        // Check window class to exclude certain windows
-        if (type_reply->type == XCB_ATOM_STRING && type_reply->format == 8) {
-            const char* class_str = (const char*)xcb_get_property_value(type_reply);
-            int len = xcb_get_property_value_length(type_reply);
-            std::string window_class(class_str, len);
-            
-            // Don't manage desktop, dock, or other special windows
-            if (window_class.find("desktop") != std::string::npos ||
-                window_class.find("dock") != std::string::npos) {
-                should_manage = false;
+    info.overrideRedirect = attributes->override_redirect;
+    info.viewable = attributes->map_state == XCB_MAP_STATE_VIEWABLE;
+
+    if (geometry) {
+        info.x = geometry->x;
+        info.y = geometry->y;
+        info.width = geometry->width;
+        info.height = geometry->height;
+    }
+
+    // WM_CLASS is the instance and the class, each NUL-terminated
+    std::string classes = propertyString(windowClass);
+    size_t split = classes.find('\0');
+    info.instance = classes.substr(0, split);
+    if (split != std::string::npos) {
+        size_t end = classes.find('\0', split + 1);
+        info.className = classes.substr(split + 1, end == std::string::npos ? end : end - split - 1);
+    }
+
+    info.netTitle = Connection::parseWindowTitle(title, legacyTitle, info.title);
+
+    if (transientFor && transientFor->type == XCB_ATOM_WINDOW && transientFor->format == 32 &&
+        xcb_get_property_value_length(const_cast<xcb_get_property_reply_t*>(transientFor)) >= 4) {
+        info.transientFor = *static_cast<const xcb_window_t*>(
+            xcb_get_property_value(const_cast<xcb_get_property_reply_t*>(transientFor)));
+    }
+
+    // The first type we know wins; without one, transients are dialogs
+    info.type = info.transientFor != XCB_NONE ? Window::ManageInfo::Type::Dialog
+                                              : Window::ManageInfo::Type::Normal;
+    if (windowType && windowType->type == XCB_ATOM_ATOM && windowType->format == 32) {
+        auto mutableReply = const_cast<xcb_get_property_reply_t*>(windowType);
+        auto types = static_cast<const xcb_atom_t*>(xcb_get_property_value(mutableReply));
+        int count = xcb_get_property_value_length(mutableReply) / 4;
+        bool found = false;
+        for (int i = 0; i < count && !found; i++) {
+            for (const auto& known : kWindowTypes) {
+                if (types[i] == connection.getAtom(known.first)) {
+                    info.type = known.second;
+                    found = true;
+                    break;
+                }
             }
         }
-        free(type_reply);
     }
-    
-    return viewable && should_manage;
+    return info;
+}
+
+} // namespace
+
+bool Window::ManageInfo::shouldManage(bool requireViewable) const {
+    if (!exists || overrideRedirect || (requireViewable && !viewable)) {
+        return false;
+    }
+    switch (type) {
+        case Type::Dock:
+        case Type::Desktop:
+        case Type::Notification:
+        case Type::Popup:
+            return false;
+        default:
+            return true;
+    }
+}
+
+bool Window::ManageInfo::shouldFloat() const {
+    switch (type) {
+        case Type::Dialog:
+        case Type::Utility:
+        case Type::Toolbar:
+        case Type::Splash:
+        case Type::Menu:
+            return true;
+        default:
+            return transientFor != XCB_NONE;
+    }
+}
+
+void Window::prefetchManageAtoms(Connection& connection) {
+    std::vector<std::string> names = { "_NET_WM_WINDOW_TYPE", "_NET_WM_NAME", "UTF8_STRING" };
+    for (const auto& known : kWindowTypes) {
+        names.push_back(known.first);
+    }
+    connection.prefetchAtoms(names);
+}
+
+Window::ManageQuery Window::queryManage(Connection& connection, xcb_window_t windowId) {
+    xcb_connection_t* conn = connection.getConnection();
+    ManageQuery query;
+    
+    // Everything needed to classify the window, in one batch
+    query.attributes = xcb_get_window_attributes(conn, windowId);
+    query.geometry = xcb_get_geometry(conn, windowId);
+    query.windowClass = xcb_get_property(conn, 0, windowId, XCB_ATOM_WM_CLASS,
+                                         XCB_ATOM_STRING, 0, 1024);
+    query.windowType = xcb_get_property(conn, 0, windowId, connection.getAtom("_NET_WM_WINDOW_TYPE"),
+                                        XCB_ATOM_ATOM, 0, 32);
+    query.transientFor = xcb_get_property(conn, 0, windowId, XCB_ATOM_WM_TRANSIENT_FOR,
+                                          XCB_ATOM_WINDOW, 0, 1);
+    query.title = connection.requestWindowTitle(windowId);
+    
+    return query;
+}
+
+void Window::discardManage(Connection& connection, const ManageQuery& query) {
+    xcb_connection_t* conn = connection.getConnection();
+    xcb_discard_reply(conn, query.attributes.sequence);
+    xcb_discard_reply(conn, query.geometry.sequence);
+    xcb_discard_reply(conn, query.windowClass.sequence);
+    xcb_discard_reply(conn, query.windowType.sequence);
+    xcb_discard_reply(conn, query.transientFor.sequence);
+    xcb_discard_reply(conn, query.title.name.sequence);
+    xcb_discard_reply(conn, query.title.legacyName.sequence);
+}
+
+bool Window::requeryManage(Connection& connection, xcb_window_t windowId, ManageQuery& query,
+                           xcb_atom_t property) {
+    xcb_connection_t* conn = connection.getConnection();
+    
+    if (property == XCB_ATOM_WM_CLASS) {
+        xcb_discard_reply(conn, query.windowClass.sequence);
+        query.windowClass = xcb_get_property(conn, 0, windowId, XCB_ATOM_WM_CLASS,
+                                             XCB_ATOM_STRING, 0, 1024);
+    } else if (property == XCB_ATOM_WM_TRANSIENT_FOR) {
+        xcb_discard_reply(conn, query.transientFor.sequence);
+        query.transientFor = xcb_get_property(conn, 0, windowId, XCB_ATOM_WM_TRANSIENT_FOR,
+                                              XCB_ATOM_WINDOW, 0, 1);
+    } else if (property == connection.getAtom("_NET_WM_WINDOW_TYPE")) {
+        xcb_discard_reply(conn, query.windowType.sequence);
+        query.windowType = xcb_get_property(conn, 0, windowId, connection.getAtom("_NET_WM_WINDOW_TYPE"),
+                                            XCB_ATOM_ATOM, 0, 32);
+    } else if (property == XCB_ATOM_WM_NAME || property == connection.getAtom("_NET_WM_NAME")) {
+        xcb_discard_reply(conn, query.title.name.sequence);
+        xcb_discard_reply(conn, query.title.legacyName.sequence);
+        query.title = connection.requestWindowTitle(windowId);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+Window::ManageInfo Window::readManage(Connection& connection, const ManageQuery& query) {
+    xcb_connection_t* conn = connection.getConnection();
+    ReplyPtr<xcb_get_window_attributes_reply_t> attributes(
+        xcb_get_window_attributes_reply(conn, query.attributes, nullptr));
+    ReplyPtr<xcb_get_geometry_reply_t> geometry(xcb_get_geometry_reply(conn, query.geometry, nullptr));
+    ReplyPtr<xcb_get_property_reply_t> windowClass(xcb_get_property_reply(conn, query.windowClass, nullptr));
+    ReplyPtr<xcb_get_property_reply_t> windowType(xcb_get_property_reply(conn, query.windowType, nullptr));
+    ReplyPtr<xcb_get_property_reply_t> transientFor(xcb_get_property_reply(conn, query.transientFor, nullptr));
+    ReplyPtr<xcb_get_property_reply_t> title(xcb_get_property_reply(conn, query.title.name, nullptr));
+    ReplyPtr<xcb_get_property_reply_t> legacyTitle(
+        xcb_get_property_reply(conn, query.title.legacyName, nullptr));
+    
+    return parseManage(connection, attributes.get(), geometry.get(), windowClass.get(), windowType.get(),
+                       transientFor.get(), title.get(), legacyTitle.get());
+}
+
+Async<Window::ManageInfo> Window::readManageAsync(Connection& connection, ManageQuery query) {
+    AsyncRequests& async = connection.getAsync();
+    auto attributes = co_await async.reply(query.attributes);
+    auto geometry = co_await async.reply(query.geometry);
+    auto windowClass = co_await async.reply(query.windowClass);
+    auto windowType = co_await async.reply(query.windowType);
+    auto transientFor = co_await async.reply(query.transientFor);
+    auto title = co_await async.reply(query.title.name);
+    auto legacyTitle = co_await async.reply(query.title.legacyName);
+    
+    co_return parseManage(connection, attributes.get(), geometry.get(), windowClass.get(), windowType.get(),
+                          transientFor.get(), title.get(), legacyTitle.get());
 }
 
 } // namespace X
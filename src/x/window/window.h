@@ -1,7 +1,9 @@
 #pragma once
 
 #include "../connection/connection.h"
+#include "../async/task.h"
 #include <xcb/xcb.h>
+#include <cstdint>
 #include <string>
 
 namespace X {
@@ -54,6 +56,19 @@ public:
      */
     void unmap();
     
+    /**
+     * @brief Queue a map request without flushing or logging
+     * 
+     * For batches of windows that should change state together, such as
+     * a workspace switch; the caller flushes once at the end.
+     */
+    void queueMap();
+    
+    /**
+     * @brief Queue an unmap request without flushing or logging
+     */
+    void queueUnmap();
+    
     /**
      * @brief Configure window properties
      * @param x X position
@@ -66,6 +81,19 @@ public:
     void configure(int x, int y, unsigned int width, unsigned int height, 
                   unsigned int borderWidth, uint32_t stackMode = XCB_STACK_MODE_ABOVE);
     
+    /**
+     * @brief Set position and size, leaving border and stacking alone
+     * @param x X position
+     * @param y Y position
+     * @param width Width
+     * @param height Height
+     * 
+     * Unlike the other setters this neither flushes nor logs, so a layout
+     * can queue one request per window and have the event loop send them
+     * together.
+     */
+    void configure(int x, int y, unsigned int width, unsigned int height);
+    
     /**
      * @brief Move the window
      * @param x New X position
@@ -132,6 +160,124 @@ public:
      * @return true if the window should be managed, false otherwise
      */
     static bool shouldManage(Connection& connection, xcb_window_t windowId);
+    
+    /**
+     * @struct ManageQuery
+     * @brief Outstanding requests needed to decide whether to manage a window
+     */
+    struct ManageQuery {
+        xcb_get_window_attributes_cookie_t attributes;
+        xcb_get_geometry_cookie_t geometry;
+        xcb_get_property_cookie_t windowClass;
+        xcb_get_property_cookie_t windowType;     // _NET_WM_WINDOW_TYPE
+        xcb_get_property_cookie_t transientFor;   // WM_TRANSIENT_FOR
+        Connection::TitleQuery title;             // _NET_WM_NAME and WM_NAME
+    };
+    
+    /**
+     * @struct ManageInfo
+     * @brief What a window is, read from the replies of a ManageQuery
+     */
+    struct ManageInfo {
+        /**
+         * @enum Type
+         * @brief The window type, from _NET_WM_WINDOW_TYPE or WM_TRANSIENT_FOR
+         */
+        enum class Type : uint8_t {
+            Normal,
+            Dialog,
+            Utility,
+            Toolbar,
+            Splash,
+            Menu,
+            Dock,
+            Desktop,
+            Notification,
+            Popup,          // Tooltips, dropdown and popup menus, combo boxes, DND
+        };
+        
+        bool exists;                  // The attributes could be read
+        bool overrideRedirect;
+        bool viewable;
+        Type type;
+        xcb_window_t transientFor;    // XCB_NONE if not transient
+        int x;                        // Requested geometry, without the border
+        int y;
+        unsigned int width;
+        unsigned int height;
+        std::string instance;         // First part of WM_CLASS
+        std::string className;        // Second part of WM_CLASS
+        std::string title;            // UTF-8, capped
+        bool netTitle;                // The title came from _NET_WM_NAME
+        
+        /**
+         * @brief Apply the management policy
+         * @param requireViewable Only manage windows that are already mapped
+         * @return true if the window should be managed, false otherwise
+         *
+         * Windows found at startup must already be viewable; a window asking
+         * to be mapped is by definition not viewable yet. Docks, desktops,
+         * notifications and popups are mapped but left alone.
+         */
+        bool shouldManage(bool requireViewable) const;
+        
+        /**
+         * @brief Check if the window should float rather than be tiled
+         * @return true for dialogs, transients and other auxiliary windows
+         */
+        bool shouldFloat() const;
+    };
+    
+    /**
+     * @brief Intern the atoms queryManage() needs without waiting
+     * @param connection The X connection
+     */
+    static void prefetchManageAtoms(Connection& connection);
+    
+    /**
+     * @brief Send the requests used by readManage() without waiting
+     * @param connection The X connection
+     * @param windowId The window ID to check
+     * @return The cookies of the requests
+     *
+     * Lets callers send the queries for many windows before collecting
+     * any reply, paying for a single round trip instead of one per window.
+     */
+    static ManageQuery queryManage(Connection& connection, xcb_window_t windowId);
+    
+    /**
+     * @brief Tell XCB that the replies of a ManageQuery will never be read
+     * @param connection The X connection
+     * @param query The cookies returned by queryManage()
+     */
+    static void discardManage(Connection& connection, const ManageQuery& query);
+    
+    /**
+     * @brief Send again the request for a property that changed since queryManage()
+     * @param connection The X connection
+     * @param windowId The window ID the query was sent for
+     * @param query The cookies returned by queryManage(), updated in place
+     * @param property The atom of the property that changed
+     * @return true if the query reads the property, false otherwise
+     */
+    static bool requeryManage(Connection& connection, xcb_window_t windowId, ManageQuery& query,
+                              xcb_atom_t property);
+    
+    /**
+     * @brief Collect the replies of previously sent queries
+     * @param connection The X connection
+     * @param query The cookies returned by queryManage()
+     * @return What the window is
+     */
+    static ManageInfo readManage(Connection& connection, const ManageQuery& query);
+    
+    /**
+     * @brief Collect the replies of previously sent queries without blocking the event loop
+     * @param connection The X connection
+     * @param query The cookies returned by queryManage()
+     * @return What the window is
+     */
+    static Async<ManageInfo> readManageAsync(Connection& connection, ManageQuery query);
 
 private:
     Connection& connection;
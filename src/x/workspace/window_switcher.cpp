@@ -0,0 +1,119 @@
+#include "window_switcher.h"
+#include "../../log/logger.h"
+
+namespace X {
+
+namespace {
+
+constexpr uint8_t kEscapeKeycode = 9;
+
+} // namespace
+
+WindowSwitcher::WindowSwitcher(Connection& connection, ClientManager& clients,
+                               WorkspaceManager& workspaces, const uint8_t altKeys[2])
+    : connection(connection),
+      clients(clients),
+      workspaces(workspaces),
+      altKeys{ altKeys[0], altKeys[1] },
+      normalColor(0x3388FF),
+      highlightColor(0xFFAA00),
+      active(false),
+      candidate(0) {
+}
+
+void WindowSwitcher::cycle() {
+    const Client* from;
+    if (active) {
+        from = clients.find(candidate);
+    } else {
+        // Alt has to be held by now; grab the keyboard to see it released.
+        // The reply is not needed: if the grab fails, a key event without
+        // Alt ends the cycle instead
+        xcb_connection_t* conn = connection.getConnection();
+        auto cookie = xcb_grab_keyboard(conn, 0, connection.getRootWindow(), XCB_CURRENT_TIME,
+                                        XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
+        xcb_discard_reply(conn, cookie.sequence);
+        active = true;
+        from = workspaces.getFocused();
+    }
+
+    Client* next = nextVisible(from);
+    if (!next) {
+        finish(false);
+        return;
+    }
+    highlight(next);
+}
+
+bool WindowSwitcher::handleKeyPress(const xcb_key_press_event_t* event) {
+    if (!active) {
+        return false;
+    }
+
+    if (event->detail == kEscapeKeycode) {
+        finish(false);
+        return true;
+    }
+
+    // Alt was released without us seeing it
+    if (!(event->state & XCB_MOD_MASK_1)) {
+        finish(true);
+    }
+    return false;
+}
+
+bool WindowSwitcher::handleKeyRelease(const xcb_key_release_event_t* event) {
+    if (!active || (event->detail != altKeys[0] && event->detail != altKeys[1])) {
+        return false;
+    }
+    finish(true);
+    return true;
+}
+
+Client* WindowSwitcher::nextVisible(const Client* from) const {
+    const MruList& mru = workspaces.getMru();
+
+    for (Client* client = from ? MruList::next(from) : nullptr; client; client = MruList::next(client)) {
+        if (workspaces.isVisible(client)) {
+            return client;
+        }
+    }
+
+    // Wrap around, ending with the starting client itself
+    for (Client* client = mru.front(); client; client = MruList::next(client)) {
+        if (workspaces.isVisible(client)) {
+            return client;
+        }
+        if (client == from) {
+            break;
+        }
+    }
+    return nullptr;
+}
+
+void WindowSwitcher::highlight(Client* client) {
+    if (Client* previous = clients.find(candidate)) {
+        previous->getFrame().setBorderColor(normalColor);
+    }
+    client->getFrame().setBorderColor(highlightColor);
+    candidate = client->getId();
+}
+
+void WindowSwitcher::finish(bool focus) {
+    active = false;
+    xcb_ungrab_keyboard(connection.getConnection(), XCB_CURRENT_TIME);
+
+    Client* client = clients.find(candidate);
+    candidate = 0;
+    if (client) {
+        client->getFrame().setBorderColor(normalColor);
+        if (focus && workspaces.isVisible(client)) {
+            // The only focus change and raise of the whole cycle
+            workspaces.focus(client);
+            Logger::debug("Switched to window " + std::to_string(client->getId()));
+        }
+    }
+    connection.flush();
+}
+
+} // namespace X
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "workspace_manager.h"
+#include "../client/client_manager.h"
+#include "../connection/connection.h"
+#include <xcb/xcb.h>
+
+namespace X {
+
+/**
+ * @class WindowSwitcher
+ * @brief Alt+Tab through the visible clients in most recently used order
+ *
+ * The first Alt+Tab grabs the keyboard so the release of Alt is seen.
+ * Every Tab only moves a highlight, drawn with the border color, to the
+ * next client in focus order; the focus change and the raise happen
+ * once, when Alt is released. Escape cancels.
+ */
+class WindowSwitcher {
+public:
+    /**
+     * @brief Constructor
+     * @param connection The X connection
+     * @param clients The client registry
+     * @param workspaces The workspaces
+     * @param altKeys Keycodes of the left and right Alt keys
+     */
+    WindowSwitcher(Connection& connection, ClientManager& clients,
+                   WorkspaceManager& workspaces, const uint8_t altKeys[2]);
+
+    /**
+     * @brief Start cycling or move to the next client
+     */
+    void cycle();
+
+    /**
+     * @brief Handle a key press while cycling
+     * @param event The key press event
+     * @return true if the event was consumed, false otherwise
+     */
+    bool handleKeyPress(const xcb_key_press_event_t* event);
+
+    /**
+     * @brief Handle a key release while cycling
+     * @param event The key release event
+     * @return true if the event ended the cycle, false otherwise
+     */
+    bool handleKeyRelease(const xcb_key_release_event_t* event);
+
+    /**
+     * @brief Check if Alt+Tab cycling is in progress
+     * @return true while Alt is held after an Alt+Tab
+     */
+    bool isActive() const { return active; }
+
+    /**
+     * @brief Set the border colors
+     * @param normal The color of managed clients
+     * @param highlighted The color of the client selected by the cycle
+     */
+    void setColors(uint32_t normal, uint32_t highlighted) {
+        normalColor = normal;
+        highlightColor = highlighted;
+    }
+
+private:
+    Connection& connection;
+    ClientManager& clients;
+    WorkspaceManager& workspaces;
+    uint8_t altKeys[2];
+    uint32_t normalColor;
+    uint32_t highlightColor;
+    bool active;
+    xcb_window_t candidate;   // Highlighted client; looked up again since it may go away
+
+    /**
+     * @brief Find the next visible client in focus order, wrapping around
+     * @param from The client to start after, or nullptr to start at the front
+     * @return The client, or nullptr if no client is visible
+     */
+    Client* nextVisible(const Client* from) const;
+
+    /**
+     * @brief Move the highlight to another client
+     * @param client The client to highlight
+     */
+    void highlight(Client* client);
+
+    /**
+     * @brief End the cycle
+     * @param focus Whether to focus the highlighted client
+     */
+    void finish(bool focus);
+};
+
+} // namespace X
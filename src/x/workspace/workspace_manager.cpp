@@ -0,0 +1,382 @@
+#include "workspace_manager.h"
+#include "../../log/logger.h"
+#include <algorithm>
+
+namespace X {
+
+WorkspaceManager::WorkspaceManager(Connection& connection, StackingOrder& stack,
+                                   ClientIndex& index, unsigned int count, const std::vector<Monitor>& monitors,
+                                   Layout::Mode mode, unsigned int borderWidth)
+    : connection(connection),
+      stack(stack),
+      index(index),
+      monitors(monitors),
+      shown(monitors.size(), -1),
+      current(0),
+      borderWidth(borderWidth),
+      focused(nullptr),
+      switchStats("Workspace switch") {
+    for (unsigned int i = 0; i < count; i++) {
+        const Rect& area = monitors[i < monitors.size() ? i : 0].area;
+        workspaces.push_back({ std::make_unique<Layout>(area, mode, borderWidth), {}, area, -1 });
+    }
+    for (size_t m = 0; m < monitors.size() && m < count; m++) {
+        assign(static_cast<unsigned int>(m), static_cast<int>(m));
+        if (monitors[m].primary) {
+            current = static_cast<unsigned int>(m);
+        }
+    }
+    Logger::debug("Workspace manager initialized with " + std::to_string(count) + " workspaces");
+}
+
+WorkspaceManager::~WorkspaceManager() {
+    if (switchStats.count()) {
+        Logger::info(switchStats.summary());
+    }
+}
+
+void WorkspaceManager::add(Client* client) {
+    add(client, current);
+}
+
+void WorkspaceManager::add(Client* client, unsigned int index) {
+    attach(client, index < workspaces.size() ? index : current);
+    mru.append(client);
+
+    // The client window left the root window for its frame
+    stack.remove(client->getId());
+    stack.setLayer(client->getFrame().getId(), client->isFloating()
+                   ? StackingOrder::Layer::Floating : StackingOrder::Layer::Normal);
+}
+
+bool WorkspaceManager::remove(Client* client) {
+    forget(client);
+    mru.remove(client);
+
+    // The frame goes back to the pool unmapped, or is destroyed
+    stack.setMapped(client->getFrame().getId(), false);
+    return detach(client);
+}
+
+bool WorkspaceManager::contains(const Client* client) const {
+    return !client->isFloating() && workspaces[client->getWorkspace()].layout->contains(client);
+}
+
+void WorkspaceManager::setFloating(Client* client) {
+    if (client->isFloating()) {
+        return;
+    }
+    detach(client);
+    client->setFloating(true);
+    attach(client, client->getWorkspace());
+    stack.setLayer(client->getFrame().getId(), StackingOrder::Layer::Floating);
+}
+
+void WorkspaceManager::switchTo(unsigned int index) {
+    if (index >= workspaces.size() || index == current) {
+        return;
+    }
+    uint64_t start = LatencyStats::nowMicros();
+
+    Workspace& incoming = workspaces[index];
+    Workspace& outgoing = workspaces[current];
+    int monitor = outgoing.monitor;
+
+    if (incoming.monitor >= 0) {
+        // Already shown on another monitor: the two trade places and
+        // both stay mapped
+        assign(current, incoming.monitor);
+        assign(index, monitor);
+        outgoing.layout->apply();
+        incoming.layout->apply();
+    } else {
+        // Put the incoming clients in place, then show them before hiding
+        // the outgoing ones; all of it goes out with the focus change below
+        assign(index, monitor);
+        incoming.layout->apply();
+        setVisible(index, true);
+        assign(current, -1);
+        setVisible(current, false);
+    }
+    current = index;
+
+    focus(mostRecent(index));
+
+    switchStats.record(LatencyStats::nowMicros() - start);
+    Logger::debug("Switched to workspace " + std::to_string(index) + ": " +
+                  std::to_string(incoming.layout->size() + incoming.floating.size()) + " mapped, " +
+                  std::to_string(outgoing.layout->size() + outgoing.floating.size()) + " unmapped");
+}
+
+void WorkspaceManager::switchBy(int delta) {
+    switchTo(neighbour(delta));
+}
+
+void WorkspaceManager::moveFocusedBy(int delta) {
+    if (!focused || focused->getWorkspace() != current) {
+        return;
+    }
+    unsigned int target = neighbour(delta);
+    if (target == current) {
+        return;
+    }
+
+    Client* client = focused;
+    detach(client);
+    translate(client, workspaces[current].area, workspaces[target].area);
+    attach(client, target);
+
+    if (workspaces[target].monitor < 0) {
+        hide(client);
+    }
+
+    focus(mostRecent(current));
+    Logger::debug("Moved window " + std::to_string(client->getId()) +
+                  " to workspace " + std::to_string(target));
+}
+
+void WorkspaceManager::focus(Client* client) {
+    focused = client;
+    if (client) {
+        if (isVisible(client)) {
+            current = client->getWorkspace();
+        }
+        mru.touch(client);
+        client->focus();
+        stack.raise(client->getFrame().getId());
+        index.raise(client);
+        connection.flush();
+        return;
+    }
+
+    // Nothing left to focus: let the pointer decide
+    auto cookie = xcb_set_input_focus(connection.getConnection(), XCB_INPUT_FOCUS_POINTER_ROOT,
+                                      XCB_INPUT_FOCUS_POINTER_ROOT, XCB_CURRENT_TIME);
+    connection.track(cookie, ErrorTracker::Request::SetInputFocus, connection.getRootWindow());
+    connection.flush();
+}
+
+void WorkspaceManager::focusDirection(ClientIndex::Direction direction) {
+    if (!focused || !isVisible(focused) || !focused->isPlaced()) {
+        return;
+    }
+    const Client* from = focused;
+    Client* target = index.nearest(from->getGeometry(), direction, [this, from](const Client* client) {
+        return client != from && isVisible(client);
+    });
+    if (target) {
+        focus(target);
+    }
+}
+
+void WorkspaceManager::show(Client* client) {
+    client->show();
+    stack.setMapped(client->getFrame().getId(), true);
+}
+
+void WorkspaceManager::hide(Client* client) {
+    client->hide();
+    stack.setMapped(client->getFrame().getId(), false);
+}
+
+void WorkspaceManager::forget(const Client* client) {
+    if (focused == client) {
+        focused = nullptr;
+    }
+}
+
+void WorkspaceManager::setBorderWidth(unsigned int width) {
+    if (width == borderWidth) {
+        return;
+    }
+    borderWidth = width;
+    for (Workspace& workspace : workspaces) {
+        workspace.layout->setBorderWidth(width);
+        for (Client* client : workspace.floating) {
+            if (client->isPlaced()) {
+                client->place(client->getGeometry(), width);
+            }
+        }
+    }
+}
+
+void WorkspaceManager::apply(std::vector<unsigned int>* changed) {
+    for (unsigned int i = 0; i < workspaces.size(); i++) {
+        if (workspaces[i].monitor >= 0 && workspaces[i].layout->apply() && changed) {
+            changed->push_back(i);
+        }
+    }
+}
+
+void WorkspaceManager::setMonitors(const std::vector<Monitor>& next) {
+    // Monitors without a name only exist without RandR and match by position
+    std::vector<int> placement(next.size(), -1);
+    std::vector<bool> matched(monitors.size(), false);
+    size_t kept = 0;
+    for (size_t j = 0; j < next.size(); j++) {
+        for (size_t i = 0; i < monitors.size(); i++) {
+            if (!matched[i] && monitors[i].name == next[j].name &&
+                (next[j].name != XCB_ATOM_NONE || i == j)) {
+                matched[i] = true;
+                placement[j] = shown[i];
+                kept += shown[i] >= 0;
+                break;
+            }
+        }
+    }
+
+    // Added monitors take over the workspaces of removed ones, which stay
+    // mapped, before any hidden workspace is shown
+    std::vector<unsigned int> orphans;
+    for (size_t i = 0; i < monitors.size(); i++) {
+        if (!matched[i] && shown[i] >= 0) {
+            orphans.push_back(static_cast<unsigned int>(shown[i]));
+        }
+    }
+    std::vector<bool> picked(workspaces.size(), false);
+    std::vector<unsigned int> revealed;
+    size_t moved = 0;
+    for (size_t j = 0; j < next.size(); j++) {
+        if (placement[j] >= 0) {
+            continue;
+        }
+        if (moved < orphans.size()) {
+            placement[j] = static_cast<int>(orphans[moved++]);
+            continue;
+        }
+        for (unsigned int w = 0; w < workspaces.size(); w++) {
+            if (workspaces[w].monitor < 0 && !picked[w]) {
+                picked[w] = true;
+                placement[j] = static_cast<int>(w);
+                revealed.push_back(w);
+                break;
+            }
+        }
+    }
+
+    monitors = next;
+    shown.assign(monitors.size(), -1);
+    for (Workspace& workspace : workspaces) {
+        workspace.monitor = -1;
+    }
+    for (size_t j = 0; j < monitors.size(); j++) {
+        if (placement[j] >= 0) {
+            assign(static_cast<unsigned int>(placement[j]), static_cast<int>(j));
+        }
+    }
+    for (unsigned int index : revealed) {
+        workspaces[index].layout->apply();
+        setVisible(index, true);
+    }
+    for (size_t i = moved; i < orphans.size(); i++) {
+        setVisible(orphans[i], false);
+    }
+
+    if (workspaces[current].monitor < 0) {
+        for (size_t j = 0; j < monitors.size(); j++) {
+            if (shown[j] >= 0 && (monitors[j].primary || workspaces[current].monitor < 0)) {
+                current = static_cast<unsigned int>(shown[j]);
+            }
+        }
+    }
+    if (!focused || !isVisible(focused)) {
+        focus(mostRecent(current));
+    }
+
+    Logger::info("Monitors changed: " + std::to_string(kept) + " workspaces kept, " +
+                 std::to_string(moved) + " moved, " + std::to_string(revealed.size()) +
+                 " shown, " + std::to_string(orphans.size() - moved) + " hidden");
+}
+
+void WorkspaceManager::moveToMonitor(Client* client, size_t monitor) {
+    int index = shownOn(monitor);
+    if (index < 0 || static_cast<unsigned int>(index) == client->getWorkspace()) {
+        return;
+    }
+    detach(client);
+    attach(client, static_cast<unsigned int>(index));
+    if (focused == client) {
+        current = static_cast<unsigned int>(index);
+    }
+}
+
+void WorkspaceManager::setVisible(unsigned int index, bool visible) {
+    Workspace& workspace = workspaces[index];
+    for (Client* client : workspace.layout->getClients()) {
+        visible ? show(client) : hide(client);
+    }
+    for (Client* client : workspace.floating) {
+        visible ? show(client) : hide(client);
+    }
+}
+
+void WorkspaceManager::assign(unsigned int index, int monitor) {
+    Workspace& workspace = workspaces[index];
+    if (workspace.monitor >= 0 && shown[workspace.monitor] == static_cast<int>(index)) {
+        shown[workspace.monitor] = -1;
+    }
+    workspace.monitor = monitor;
+    if (monitor < 0) {
+        return;
+    }
+    shown[monitor] = static_cast<int>(index);
+
+    const Rect& area = monitors[monitor].area;
+    if (area == workspace.area) {
+        return;
+    }
+    for (Client* client : workspace.floating) {
+        translate(client, workspace.area, area);
+    }
+    workspace.layout->setArea(area);
+    workspace.area = area;
+}
+
+void WorkspaceManager::translate(Client* client, const Rect& from, const Rect& to) {
+    if (!client->isFloating() || !client->isPlaced() || (from.x == to.x && from.y == to.y)) {
+        return;
+    }
+    Rect rect = client->getGeometry();
+    rect.x += to.x - from.x;
+    rect.y += to.y - from.y;
+    client->place(rect, borderWidth);
+}
+
+Client* WorkspaceManager::mostRecent(unsigned int index) const {
+    for (Client* client = mru.front(); client; client = MruList::next(client)) {
+        if (client->getWorkspace() == index) {
+            return client;
+        }
+    }
+    return nullptr;
+}
+
+void WorkspaceManager::attach(Client* client, unsigned int index) {
+    client->setWorkspace(index);
+    if (client->isFloating()) {
+        workspaces[index].floating.push_back(client);
+    } else {
+        workspaces[index].layout->insert(client);
+    }
+}
+
+bool WorkspaceManager::detach(Client* client) {
+    Workspace& workspace = workspaces[client->getWorkspace()];
+    if (!client->isFloating()) {
+        return workspace.layout->remove(client);
+    }
+
+    auto it = std::find(workspace.floating.begin(), workspace.floating.end(), client);
+    if (it == workspace.floating.end()) {
+        return false;
+    }
+    workspace.floating.erase(it);
+    return true;
+}
+
+unsigned int WorkspaceManager::neighbour(int delta) const {
+    int count = static_cast<int>(workspaces.size());
+    return static_cast<unsigned int>(((static_cast<int>(current) + delta) % count + count) % count);
+}
+
+} // namespace X
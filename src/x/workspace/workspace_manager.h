@@ -0,0 +1,319 @@
+#pragma once
+
+#include "../client/client.h"
+#include "../client/mru_list.h"
+#include "../connection/connection.h"
+#include "../layout/layout.h"
+#include "../monitor/monitor_manager.h"
+#include "../stack/stacking_order.h"
+#include "../../log/latency_stats.h"
+#include <memory>
+#include <vector>
+
+namespace X {
+
+/**
+ * @class WorkspaceManager
+ * @brief Groups clients into workspaces, one visible per monitor
+ *
+ * Every workspace tiles its clients with its own layout; floating
+ * clients, which were moved or resized by hand, keep their geometry
+ * relative to the monitor. Hidden workspaces keep their layouts up to
+ * date but only configure their clients when they are shown.
+ *
+ * The current workspace is the one on the monitor with the focus.
+ * Switching to a workspace already visible on another monitor swaps the
+ * two. When monitors change, only workspaces whose monitor was resized,
+ * added or removed are laid out again.
+ *
+ * A switch queues the map requests of the incoming frames before the
+ * unmap requests of the outgoing ones and sends them with a single
+ * flush, so the screen never shows the empty root window in between.
+ * Only frames are unmapped; the client windows stay mapped inside them,
+ * so hiding a workspace causes no UnmapNotify on any client.
+ */
+class WorkspaceManager {
+public:
+    /**
+     * @brief Constructor
+     * @param connection The X connection
+     * @param stack The stacking order of the frames
+     * @param index The spatial index of the clients
+     * @param count The number of workspaces
+     * @param monitors The monitors, one workspace is shown on each
+     * @param mode The tiling mode of every workspace
+     * @param borderWidth Border width of tiled clients
+     */
+    WorkspaceManager(Connection& connection, StackingOrder& stack, ClientIndex& index,
+                     unsigned int count,
+                     const std::vector<Monitor>& monitors, Layout::Mode mode,
+                     unsigned int borderWidth);
+
+    /**
+     * @brief Destructor
+     */
+    ~WorkspaceManager();
+
+    /**
+     * @brief Put a new client on the current workspace
+     * @param client The client
+     */
+    void add(Client* client);
+
+    /**
+     * @brief Put a new client on a given workspace
+     * @param client The client
+     * @param index The workspace index; the current one if out of range
+     */
+    void add(Client* client, unsigned int index);
+
+    /**
+     * @brief Take a client off its workspace
+     * @param client The client
+     * @return true if the client was on a workspace, false otherwise
+     */
+    bool remove(Client* client);
+
+    /**
+     * @brief Check if a client is tiled on any workspace
+     * @param client The client
+     * @return true if the client is tiled
+     */
+    bool contains(const Client* client) const;
+
+    /**
+     * @brief Take a client out of its layout so it can be placed by hand
+     * @param client The client
+     */
+    void setFloating(Client* client);
+
+    /**
+     * @brief Show another workspace on the current monitor
+     * @param index The workspace index
+     */
+    void switchTo(unsigned int index);
+
+    /**
+     * @brief Show a neighbouring workspace, wrapping around
+     * @param delta Offset from the current workspace
+     */
+    void switchBy(int delta);
+
+    /**
+     * @brief Move the focused client to a neighbouring workspace
+     * @param delta Offset from the current workspace
+     */
+    void moveFocusedBy(int delta);
+
+    /**
+     * @brief Focus a client, raise it within its layer and remember it
+     * @param client The client, or nullptr to focus the root window
+     */
+    void focus(Client* client);
+
+    /**
+     * @brief Focus the nearest visible client in a direction
+     * @param direction The direction from the focused client
+     *
+     * Works across monitors.
+     */
+    void focusDirection(ClientIndex::Direction direction);
+
+    /**
+     * @brief Map the frame of a client
+     * @param client The client
+     *
+     * The request is not flushed.
+     */
+    void show(Client* client);
+
+    /**
+     * @brief Forget the focused client if it is going away
+     * @param client The client
+     */
+    void forget(const Client* client);
+
+    /**
+     * @brief Relayout the visible workspaces
+     * @param changed Receives the workspaces whose clients moved, or nullptr
+     */
+    void apply(std::vector<unsigned int>* changed = nullptr);
+
+    /**
+     * @brief Follow a change of the monitors
+     * @param monitors The new monitors
+     *
+     * Monitors are matched by name. A workspace stays on its monitor and
+     * is only resized if the monitor was; the workspaces of removed
+     * monitors move to added ones or are hidden. The requests are not
+     * flushed until the focus changes or apply() is followed by a flush.
+     */
+    void setMonitors(const std::vector<Monitor>& monitors);
+
+    /**
+     * @brief Check if a client is on a visible workspace
+     * @param client The client
+     * @return true if the client is visible
+     */
+    bool isVisible(const Client* client) const { return workspaces[client->getWorkspace()].monitor >= 0; }
+
+    /**
+     * @brief Find the workspace shown on a monitor
+     * @param monitor The monitor index
+     * @return The workspace index, or -1 if the monitor shows none
+     */
+    int shownOn(size_t monitor) const { return monitor < shown.size() ? shown[monitor] : -1; }
+
+    /**
+     * @brief Get the area a workspace is laid out in
+     * @param index The workspace index
+     * @return The area of the monitor it is or was last shown on
+     */
+    const Rect& getArea(unsigned int index) const { return workspaces[index].area; }
+
+    /**
+     * @brief Get the monitor a workspace is shown on
+     * @param index The workspace index
+     * @return The monitor index, or -1 if the workspace is hidden
+     */
+    int getMonitor(unsigned int index) const { return workspaces[index].monitor; }
+
+    /**
+     * @brief Get the number of clients on a workspace
+     * @param index The workspace index
+     * @return The tiled and floating clients
+     */
+    size_t getClientCount(unsigned int index) const {
+        return workspaces[index].layout->size() + workspaces[index].floating.size();
+    }
+
+    /**
+     * @brief Move a floating client to the workspace shown on a monitor
+     * @param client The client
+     * @param monitor The monitor index
+     *
+     * The client keeps its geometry; nothing happens if the monitor shows
+     * no workspace or already shows the client's.
+     */
+    void moveToMonitor(Client* client, size_t monitor);
+
+    /**
+     * @brief Get the index of the workspace on the focused monitor
+     * @return The workspace index
+     */
+    unsigned int getCurrent() const { return current; }
+
+    /**
+     * @brief Get the number of workspaces
+     * @return The workspace count
+     */
+    size_t getCount() const { return workspaces.size(); }
+
+    /**
+     * @brief Get the focused client
+     * @return The client, or nullptr if no client has the focus
+     */
+    Client* getFocused() const { return focused; }
+
+    /**
+     * @brief Get the clients in focus order
+     * @return The most recently used list
+     */
+    const MruList& getMru() const { return mru; }
+
+    /**
+     * @brief Get the border width of tiled clients
+     * @return The border width
+     */
+    unsigned int getBorderWidth() const { return borderWidth; }
+
+    /**
+     * @brief Change the border width of every client
+     * @param width The new border width
+     *
+     * Tiled clients are placed again by the next apply(); floating ones
+     * keep their outer rectangle.
+     */
+    void setBorderWidth(unsigned int width);
+
+private:
+    struct Workspace {
+        std::unique_ptr<Layout> layout;
+        std::vector<Client*> floating;
+        Rect area;     // Area of the monitor it was last shown on
+        int monitor;   // Index of the monitor showing it, or -1 if hidden
+    };
+
+    Connection& connection;
+    StackingOrder& stack;
+    ClientIndex& index;
+    std::vector<Workspace> workspaces;
+    std::vector<Monitor> monitors;
+    std::vector<int> shown;   // Workspace shown on each monitor, or -1
+    unsigned int current;
+    unsigned int borderWidth;
+    Client* focused;
+    MruList mru;
+    LatencyStats switchStats;
+
+    /**
+     * @brief Find the most recently used client on a workspace
+     * @param index The workspace index
+     * @return The client, or nullptr if the workspace is empty
+     */
+    Client* mostRecent(unsigned int index) const;
+
+    /**
+     * @brief Unmap the frame of a client
+     * @param client The client
+     */
+    void hide(Client* client);
+
+    /**
+     * @brief Map or unmap every frame of a workspace
+     * @param index The workspace index
+     * @param visible Whether to map the frames
+     */
+    void setVisible(unsigned int index, bool visible);
+
+    /**
+     * @brief Put a workspace on a monitor
+     * @param index The workspace index
+     * @param monitor The monitor index, or -1 to take it off its monitor
+     *
+     * The layout is resized and floating clients are moved along only if
+     * the monitor's area differs from the one the workspace last had.
+     */
+    void assign(unsigned int index, int monitor);
+
+    /**
+     * @brief Move a placed floating client from one area to another
+     * @param client The client
+     * @param from The area it is relative to now
+     * @param to The area it should be relative to
+     */
+    void translate(Client* client, const Rect& from, const Rect& to);
+
+    /**
+     * @brief Put a client on a workspace, tiled or floating
+     * @param client The client
+     * @param index The workspace index
+     */
+    void attach(Client* client, unsigned int index);
+
+    /**
+     * @brief Take a client off its workspace
+     * @param client The client
+     * @return true if the client was on its workspace, false otherwise
+     */
+    bool detach(Client* client);
+
+    /**
+     * @brief Get the index of a neighbouring workspace
+     * @param delta Offset from the current workspace
+     * @return The workspace index
+     */
+    unsigned int neighbour(int delta) const;
+};
+
+} // namespace X
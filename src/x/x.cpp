@@ -1,12 +1,12 @@
 #include "x.h"
 #include "../log/logger.h"
+#include "../log/phase_timer.h"
 #include "event/event_handler.h"
 #include <xcb/xcb.h>
+#include <X11/keysym.h>
 #include <stdexcept>
+#include <cstdlib>
 #include "launcher/launcher.h"
-#include <unistd.h>     // fork(), execl(), setsid()
-#include <sys/types.h>  // pid_t
-#include <sys/wait.h>   // waitpid()
 
 namespace X {
 
@@ -21,22 +21,35 @@ X::X()
 X::~X() {
     Logger::debug("X destructor called");
     
-    // Clean up managed windows
-    for (auto window : managedWindows) {
-        delete window;
-    }
-    managedWindows.clear();
-    
-    // Release resources in reverse order of creation
+    // Release resources in reverse order of creation; the I/O thread
+    // goes first since it uses the connection until it is joined
+    ioThread.reset();
+    configWatcher.reset();
+    ipcEvents.reset();
+    ipc.reset();
+    ipcCommands.reset();
+    state.reset();
+    drag.reset();
     launcher.reset();
+    childTracker.reset();
+    spawner.reset();
     eventHandler.reset();
+    eventLoop.reset();
     keyboardHandler.reset();
+    switcher.reset();
+    ewmh.reset();
+    config.reset();
+    workspaces.reset();
+    stack.reset();
+    monitors.reset();
+    clients.reset();
     rootWindow.reset();
     connection.reset();
 }
 
 bool X::initialize() {
     Logger::debug("Initializing X");
+    PhaseTimer startup("Startup timing");
     
     try {
         // Create X connection
@@ -45,36 +58,154 @@ bool X::initialize() {
             Logger::error("Failed to connect to X server");
             return false;
         }
+        startup.mark("connect");
         
         // Get the root window
         rootWindow = std::make_unique<Window>(*connection, connection->getRootWindow());
         
-        // Set up keyboard handler
+        // Set up the event loop
+        eventLoop = std::make_unique<EventLoop>();
+        
+        // Send every startup request that does not depend on another reply
+        // before waiting on any of them, so their round trips overlap
+        auto redirectCookie = setupRootWindow();
+        auto treeCookie = xcb_query_tree(connection->getConnection(), rootWindow->getId());
+        connection->prefetchAtoms({ "_NET_WM_PID" });
+        Window::prefetchManageAtoms(*connection);
+        MonitorManager::prefetchExtension(*connection);
+        startup.mark("requests");
+        
+        // Set up the client registry
+        clients = std::make_unique<ClientManager>(*connection);
+        const char* prefetch = std::getenv("DOOWM_PREFETCH");
+        if (prefetch && std::string(prefetch) == "0") {
+            clients->setPrefetchEnabled(false);
+        }
+        
+        // Tile managed windows per workspace, one shown on each monitor;
+        // reading the monitors overlaps with the requests above
+        monitors = std::make_unique<MonitorManager>(*connection);
+        const char* layoutMode = std::getenv("DOOWM_LAYOUT");
+        bool splitTree = layoutMode && std::string(layoutMode) == "tree";
+        stack = std::make_unique<StackingOrder>(*connection);
+        workspaces = std::make_unique<WorkspaceManager>(
+            *connection, *stack, clients->getIndex(), 4, monitors->getMonitors(),
+            splitTree ? Layout::Mode::SplitTree : Layout::Mode::MasterStack, 2);
+        
+        // Set up keyboard handler; this sends the keyboard mapping request
         keyboardHandler = std::make_unique<Keyboard::KeyboardHandler>(*connection);
         
         // Set up event handler (after keyboard handler)
         eventHandler = std::make_unique<EventHandler>(*this);
+        const char* order = std::getenv("DOOWM_EVENT_ORDER");
+        if (order && std::string(order) == "fifo") {
+            eventHandler->setPrioritized(false);
+        }
+        
+        // Read the configuration and window rules while those requests
+        // are in flight
+        std::string configDirectory = Config::directory();
+        std::shared_ptr<const Config> initialConfig = Config::load(configDirectory);
+        startup.mark("config");
+        
+        // Alt+Tab cycles until Alt is released
+        const uint8_t altKeys[2] = {
+            keyboardHandler->keysymToKeycode(XK_Alt_L),
+            keyboardHandler->keysymToKeycode(XK_Alt_R),
+        };
+        switcher = std::make_unique<WindowSwitcher>(*connection, *clients, *workspaces, altKeys);
         
-        // Configure root window
-        setupRootWindow();
+        // Grab the bound keys (waits for the mapping)
+        applyConfig(std::move(initialConfig));
+        
+        // Alt+drag moves and resizes, paced by the display refresh rate
+        drag = std::make_unique<PointerDrag>(*connection, *eventLoop, *clients, *workspaces,
+                                             *monitors);
+        const char* dragOutline = std::getenv("DOOWM_DRAG_OUTLINE");
+        drag->setOutline(dragOutline && std::string(dragOutline) == "1");
+        if (const char* dragHz = std::getenv("DOOWM_DRAG_HZ")) {
+            drag->setRefreshRate(static_cast<unsigned int>(std::strtoul(dragHz, nullptr, 10)));
+        }
+        const char* dragSync = std::getenv("DOOWM_DRAG_SYNC");
+        drag->setSync(!(dragSync && std::string(dragSync) == "0"));
+        drag->grabButtons();
+        startup.mark("grab keys");
+        
+        // Only now block on the answer to the substructure redirect
+        checkRootWindow(redirectCookie);
+        startup.mark("redirect");
+        
+        // Announce ourselves to pagers only once we own the root window
+        ewmh = std::make_unique<EwmhPublisher>(*connection, *clients, *workspaces, *stack);
         
         // Scan for existing windows
-        scanExistingWindows();
+        scanExistingWindows(treeCookie);
+        startup.mark("scan");
+        
+        // Set up process spawner and reaping of launched processes
+        spawner = std::make_unique<Spawner>();
+        childTracker = std::make_unique<ChildTracker>(*eventLoop);
         
-        // Set up launcher
+        // Set up launcher; its window is created the first time it is shown
         launcher = std::make_unique<Launcher>(getConnection());
         launcher->setExecuteCallback([this](const std::string& command) {
             Logger::info("Executing command from launcher: " + command);
-            // Fork and exec the command
-            pid_t pid = fork();
-            if (pid == 0) {
-                // Child process
-                setsid();
-                execl("/bin/sh", "sh", "-c", command.c_str(), nullptr);
-                exit(1);
-            }
+            pid_t pid = spawner->spawn(command);
+            childTracker->track(pid, command);
         });
+        startup.mark("subsystems");
+        
+        // Control socket, served from the event loop
+        const char* ipcEnabled = std::getenv("DOOWM_IPC");
+        if (!(ipcEnabled && std::string(ipcEnabled) == "0")) {
+            state = std::make_unique<StatePublisher>(*clients, *workspaces, *monitors);
+            ipcCommands = std::make_unique<IpcCommands>(*this);
+            ipc = std::make_unique<IpcServer>(*eventLoop);
+            ipc->setHandler([this](Ipc::Op op, std::string_view payload, std::string& reply) {
+                return ipcCommands->run(op, payload, reply);
+            });
+            if (ipc->listen(Ipc::socketPath())) {
+                // Launched programs and doowmc find the socket through this
+                setenv("DOOWM_SOCKET", ipc->getPath().c_str(), 1);
+                ipcEvents = std::make_unique<IpcEvents>(*ipc, *workspaces, *monitors);
+                
+                // Queries read snapshots and never touch the live state
+                StatePublisher* snapshots = state.get();
+                ipc->setQueryHandler([snapshots](std::string_view requests, std::string& replies) {
+                    // Every query of a client sees the same state
+                    auto snapshot = snapshots->current();
+                    IpcCommands::queries(*snapshot, requests, replies);
+                });
+            } else {
+                ipc.reset();
+                ipcCommands.reset();
+                state.reset();
+            }
+            startup.mark("ipc");
+        }
         
+        // Pick up configuration changes without a restart
+        const char* watchConfig = std::getenv("DOOWM_CONFIG_WATCH");
+        if (!configDirectory.empty() && !(watchConfig && std::string(watchConfig) == "0")) {
+            configWatcher = std::make_unique<ConfigWatcher>(*eventLoop, configDirectory);
+            if (!configWatcher->start([this](std::shared_ptr<const Config> next) {
+                    applyConfig(std::move(next));
+                })) {
+                configWatcher.reset();
+            }
+        }
+        
+        // Optionally read X events on a separate thread
+        const char* threaded = std::getenv("DOOWM_IO_THREAD");
+        if (threaded && std::string(threaded) == "1") {
+            ioThread = std::make_unique<IoThread>(*connection);
+            if (!ioThread->start()) {
+                ioThread.reset();
+            }
+            startup.mark("io thread");
+        }
+        
+        Logger::info(startup.report());
         Logger::info("X initialized successfully");
         return true;
     } catch (const std::exception& e) {
@@ -84,12 +215,34 @@ bool X::initialize() {
 }
 
 void X::run() {
-    Logger::info("Starting main event loop");
+    Logger::info("Starting main event loop, managing after " +
+                 std::to_string(PhaseTimer::sinceProcessStart() / 1000) + "ms");
     running = true;
     
     while (running) {
-        // Wait for and process the next event
-        eventHandler->processNextEvent();
+        // Process everything that has arrived, then sleep until the X
+        // connection or one of the watched descriptors has more
+        eventHandler->processPendingEvents();
+        if (!running) {
+            break;
+        }
+        if (ioThread && connection->getAsync().hasPending()) {
+            ioThread->watchReplies();
+        }
+        connection->flush();
+        
+        if (!ioThread) {
+            eventLoop->wait(connection->getFileDescriptor());
+            continue;
+        }
+        
+        // Events that arrived after the last drain are handled first
+        if (!ioThread->prepareToSleep()) {
+            continue;
+        }
+        
+        eventLoop->wait(ioThread->getWakeupFd());
+        ioThread->acknowledgeWakeup();
     }
     
     Logger::info("Main event loop terminated");
@@ -100,7 +253,7 @@ void X::terminate() {
     running = false;
 }
 
-void X::setupRootWindow() {
+xcb_void_cookie_t X::setupRootWindow() {
     Logger::debug("Setting up root window");
     
     // Set event mask for root window to receive notifications about
@@ -111,35 +264,25 @@ void X::setupRootWindow() {
                 XCB_EVENT_MASK_PROPERTY_CHANGE |
                 XCB_EVENT_MASK_KEY_PRESS;
     
-    auto cookie = xcb_change_window_attributes_checked(
+    return xcb_change_window_attributes_checked(
         connection->getConnection(),
         rootWindow->getId(),
         XCB_CW_EVENT_MASK,
         values
     );
-    
+}
+
+void X::checkRootWindow(xcb_void_cookie_t cookie) {
     auto error = xcb_request_check(connection->getConnection(), cookie);
     if (error) {
         free(error);
         throw std::runtime_error("Another window manager is already running");
     }
-    
-    // Grab keys for window management shortcuts
-    keyboardHandler->grabWMKeys();
-    
-    // Make sure changes are applied
-    connection->flush();
 }
 
-void X::scanExistingWindows() {
+void X::scanExistingWindows(xcb_query_tree_cookie_t cookie) {
     Logger::debug("Scanning for existing windows");
     
-    // Query for existing windows
-    auto cookie = xcb_query_tree(
-        connection->getConnection(),
-        rootWindow->getId()
-    );
-    
     auto reply = xcb_query_tree_reply(
         connection->getConnection(),
         cookie,
@@ -157,22 +300,38 @@ void X::scanExistingWindows() {
     
     Logger::info("Found " + std::to_string(childrenLen) + " existing windows");
     
-    // Manage each window
+    // Send the queries for all windows first and collect the replies
+    // afterwards: one round trip for the scan instead of two per window
+    std::vector<Window::ManageQuery> queries;
+    queries.reserve(childrenLen);
+    for (int i = 0; i < childrenLen; i++) {
+        queries.push_back(Window::queryManage(*connection, children[i]));
+    }
+    
+    // Manage each window; the children come bottom to top, which seeds
+    // the stacking order with the windows that are not managed
     for (int i = 0; i < childrenLen; i++) {
         auto windowId = children[i];
+        Window::ManageInfo info = Window::readManage(*connection, queries[i]);
         
         // Skip windows that shouldn't be managed
         // (like dock, desktop, etc.)
-        if (!Window::shouldManage(*connection, windowId)) {
+        if (!info.shouldManage(true)) {
+            if (info.exists) {
+                stack->add(windowId,
+                           info.overrideRedirect ? StackingOrder::Layer::OverrideRedirect
+                                                 : StackingOrder::Layer::Normal,
+                           info.viewable);
+            }
             continue;
         }
         
-        // Create and manage the window
-        auto window = new Window(*connection, windowId);
-        managedWindows.push_back(window);
+        // Create and manage the window; the first pass of the event
+        // loop tiles it
+        Client* client = manageClient(windowId, info, true);
         
-        // Map the window if it's not already mapped
-        window->map();
+        // The window was mapped before; show it in its frame
+        workspaces->show(client);
         
         Logger::debug("Managing existing window: " + std::to_string(windowId));
     }
@@ -180,6 +339,119 @@ void X::scanExistingWindows() {
     free(reply);
 }
 
+void X::applyConfig(std::shared_ptr<const Config> next) {
+    for (const std::string& problem : next->problems) {
+        Logger::warning(problem);
+    }
+    
+    std::map<std::pair<uint8_t, uint16_t>, std::function<void()>> callbacks;
+    for (const KeyBinding& binding : next->bindings) {
+        uint8_t keycode = keyboardHandler->keysymToKeycode(binding.keysym);
+        if (keycode) {
+            callbacks[{ keycode, binding.modifiers }] = [this, binding]() { runBinding(binding); };
+        }
+    }
+    size_t grabs = keyboardHandler->rebind(std::move(callbacks));
+    
+    // Borders are only repainted or resized when they changed
+    std::vector<Client*> all;
+    clients->getAll(all);
+    if (!config || next->borderWidth != config->borderWidth) {
+        workspaces->setBorderWidth(next->borderWidth);
+        for (Client* client : all) {
+            client->getFrame().setBorderWidth(next->borderWidth);
+        }
+    }
+    if (!config || next->borderColor != config->borderColor || next->highlightColor != config->highlightColor) {
+        switcher->setColors(next->borderColor, next->highlightColor);
+        for (Client* client : all) {
+            client->getFrame().setBorderColor(next->borderColor);
+        }
+    }
+    
+    config = std::move(next);
+    Logger::info("Configuration: " + std::to_string(config->bindings.size()) + " key bindings (" +
+                 std::to_string(grabs) + " grabs changed), " + std::to_string(config->rules->size()) +
+                 " window rules");
+}
+
+void X::runBinding(const KeyBinding& binding) {
+    switch (binding.action) {
+        case KeyAction::Workspace:
+            if (binding.relative) {
+                workspaces->switchBy(binding.value);
+            } else if (static_cast<unsigned int>(binding.value) < workspaces->getCount()) {
+                workspaces->switchTo(static_cast<unsigned int>(binding.value));
+            }
+            break;
+        case KeyAction::MoveToWorkspace:
+            if (binding.relative) {
+                workspaces->moveFocusedBy(binding.value);
+            } else if (static_cast<unsigned int>(binding.value) < workspaces->getCount()) {
+                workspaces->moveFocusedBy(binding.value - static_cast<int>(workspaces->getCurrent()));
+            }
+            break;
+        case KeyAction::Focus:
+            workspaces->focusDirection(static_cast<ClientIndex::Direction>(binding.value));
+            break;
+        case KeyAction::Switch:
+            switcher->cycle();
+            break;
+        case KeyAction::Launcher:
+            showLauncher();
+            break;
+        case KeyAction::Spawn: {
+            pid_t pid = spawner->spawn(binding.command);
+            if (pid > 0) {
+                childTracker->track(pid, binding.command);
+            }
+            break;
+        }
+    }
+}
+
+Client* X::manageClient(xcb_window_t windowId, const Window::ManageInfo& info, bool mapped) {
+    Client* client = clients->manage(windowId, mapped);
+    unsigned int borderWidth = workspaces->getBorderWidth();
+    client->getFrame().setBorderWidth(borderWidth);
+    client->getFrame().setBorderColor(config->borderColor);
+    
+    // Rules first, then the window type
+    RuleActions actions = config->rules->match(info.className, info.instance, info.title);
+    bool floating = actions.floating ? *actions.floating : info.shouldFloat();
+    client->setFloating(floating);
+    
+    unsigned int workspace = workspaces->getCurrent();
+    if (actions.monitor && workspaces->shownOn(*actions.monitor) >= 0) {
+        workspace = static_cast<unsigned int>(workspaces->shownOn(*actions.monitor));
+    }
+    if (actions.workspace && *actions.workspace < workspaces->getCount()) {
+        workspace = *actions.workspace;
+    }
+    workspaces->add(client, workspace);
+    clients->setTitle(client, info.title, info.netTitle);
+    ewmh->add(windowId);
+    
+    if (floating) {
+        // Over the parent of a transient, centred if the window did not
+        // ask for a position, else where it asked to be
+        Rect outer{ info.x, info.y, info.width + 2 * borderWidth, info.height + 2 * borderWidth };
+        Client* parent = info.transientFor != XCB_NONE ? clients->find(info.transientFor) : nullptr;
+        const Rect* centre = nullptr;
+        if (parent && parent->isPlaced()) {
+            centre = &parent->getGeometry();
+        } else if (info.x == 0 && info.y == 0) {
+            centre = &workspaces->getArea(client->getWorkspace());
+        }
+        if (centre) {
+            outer.x = centre->x + (static_cast<int>(centre->width) - static_cast<int>(outer.width)) / 2;
+            outer.y = centre->y + (static_cast<int>(centre->height) - static_cast<int>(outer.height)) / 2;
+        }
+        client->place(outer, borderWidth);
+    }
+    return client;
+}
+
 void X::showLauncher() {
     if (launcher) {
         launcher->show();
@@ -6,6 +6,21 @@
 #include "window/window.h"
 #include "keyboard/keyboard.h"
 #include "launcher/launcher.h"
+#include "process/spawner.h"
+#include "process/child_tracker.h"
+#include "event/event_loop.h"
+#include "event/io_thread.h"
+#include "client/client_manager.h"
+#include "monitor/monitor_manager.h"
+#include "workspace/workspace_manager.h"
+#include "workspace/window_switcher.h"
+#include "ewmh/ewmh_publisher.h"
+#include "pointer/pointer_drag.h"
+#include "config/config_watcher.h"
+#include "ipc/ipc_server.h"
+#include "ipc/ipc_commands.h"
+#include "ipc/ipc_events.h"
+#include "state/state_publisher.h"
 
 namespace X {
 
@@ -65,6 +80,121 @@ public:
      */
     Window& getRootWindow() { return *rootWindow; }
     
+    /**
+     * @brief Get the event loop
+     * @return Reference to the event loop
+     */
+    EventLoop& getEventLoop() { return *eventLoop; }
+    
+    /**
+     * @brief Get the X I/O thread
+     * @return Pointer to the I/O thread, or nullptr if events are read on the main thread
+     */
+    IoThread* getIoThread() { return ioThread.get(); }
+    
+    /**
+     * @brief Get the child process tracker
+     * @return Reference to the child process tracker
+     */
+    ChildTracker& getChildTracker() { return *childTracker; }
+    
+    /**
+     * @brief Get the process spawner
+     * @return Reference to the spawner
+     */
+    Spawner& getSpawner() { return *spawner; }
+    
+    /**
+     * @brief Get the control socket
+     * @return Pointer to the server, or nullptr if IPC is disabled
+     */
+    IpcServer* getIpc() { return ipc.get(); }
+    
+    /**
+     * @brief Get the event publisher of the control socket
+     * @return Pointer to the publisher, or nullptr if IPC is disabled
+     */
+    IpcEvents* getIpcEvents() { return ipcEvents.get(); }
+    
+    /**
+     * @brief Get the published state snapshots
+     * @return Pointer to the publisher, or nullptr if IPC is disabled
+     */
+    StatePublisher* getState() { return state.get(); }
+    
+    /**
+     * @brief Get the client registry
+     * @return Reference to the client manager
+     */
+    ClientManager& getClients() { return *clients; }
+    
+    /**
+     * @brief Get the workspaces
+     * @return Reference to the workspace manager
+     */
+    WorkspaceManager& getWorkspaces() { return *workspaces; }
+    
+    /**
+     * @brief Get the monitors
+     * @return Reference to the monitor manager
+     */
+    MonitorManager& getMonitors() { return *monitors; }
+    
+    /**
+     * @brief Get the EWMH root property publisher
+     * @return Reference to the publisher
+     */
+    EwmhPublisher& getEwmh() { return *ewmh; }
+    
+    /**
+     * @brief Get the stacking order
+     * @return Reference to the stacking order model
+     */
+    StackingOrder& getStack() { return *stack; }
+    
+    /**
+     * @brief Get the Alt+Tab window switcher
+     * @return Reference to the window switcher
+     */
+    WindowSwitcher& getSwitcher() { return *switcher; }
+    
+    /**
+     * @brief Get the Alt+drag move and resize handler
+     * @return Reference to the pointer drag handler
+     */
+    PointerDrag& getDrag() { return *drag; }
+    
+    /**
+     * @brief Get the keyboard handler
+     * @return Reference to the keyboard handler
+     */
+    Keyboard::KeyboardHandler& getKeyboardHandler() { return *keyboardHandler; }
+    
+    /**
+     * @brief Get the window rules
+     * @return Reference to the rule matcher of the current configuration
+     */
+    const RuleMatcher& getRules() const { return *config->rules; }
+    
+    /**
+     * @brief Get the current configuration
+     * @return Reference to the configuration
+     */
+    const Config& getConfig() const { return *config; }
+    
+    /**
+     * @brief Start managing a window
+     * @param windowId The window ID
+     * @param info What the window is, from Window::readManage()
+     * @param mapped Whether the window is already mapped
+     * @return The new client
+     *
+     * Applies the window rules, floats dialogs and other auxiliary
+     * windows and gives floating clients their first position. The
+     * caller maps the client.
+     */
+    Client* manageClient(xcb_window_t windowId, const Window::ManageInfo& info, bool mapped);
+    
     /**
      * @brief Show the application launcher
      * 
@@ -77,26 +207,67 @@ private:
     /**
      * @brief Set up the root window
      * 
-     * Configures the root window to receive the necessary events
-     * and sets up key bindings.
+     * Asks for substructure redirection and the other root events
+     * without waiting for the result.
+     * 
+     * @return Cookie to pass to checkRootWindow()
+     */
+    xcb_void_cookie_t setupRootWindow();
+    
+    /**
+     * @brief Verify that the root window was set up
+     * @param cookie The cookie returned by setupRootWindow()
+     * 
+     * Throws if another window manager already owns the root window.
      */
-    void setupRootWindow();
+    void checkRootWindow(xcb_void_cookie_t cookie);
     
     /**
      * @brief Scan for existing windows
+     * @param cookie Cookie of a query tree request on the root window
      * 
-     * Queries the X server for existing windows and manages them.
+     * Manages the windows that existed before the window manager started.
      */
-    void scanExistingWindows();
+    void scanExistingWindows(xcb_query_tree_cookie_t cookie);
+    
+    /**
+     * @brief Switch to a new configuration
+     * @param next The configuration
+     * 
+     * Only key combinations that were added or removed are grabbed or
+     * ungrabbed, and clients are only touched if the border changed.
+     */
+    void applyConfig(std::shared_ptr<const Config> next);
+    
+    /**
+     * @brief Run the action of a key binding
+     * @param binding The binding
+     */
+    void runBinding(const KeyBinding& binding);
    
     bool running;                                      // Flag indicating if the event loop is running
     std::unique_ptr<Connection> connection;            // Connection to the X server
     std::unique_ptr<Window> rootWindow;                // The root window
+    std::unique_ptr<EventLoop> eventLoop;              // Waits on X and other descriptors
+    std::unique_ptr<IoThread> ioThread;                // Reads X events when threaded mode is enabled
     std::unique_ptr<EventHandler> eventHandler;        // Handler for X events
     std::unique_ptr<Keyboard::KeyboardHandler> keyboardHandler;  // Handler for keyboard input
-    
-    std::vector<Window*> managedWindows;               // List of windows managed by the window manager
+    std::unique_ptr<ClientManager> clients;            // Windows managed by the window manager
+    std::unique_ptr<MonitorManager> monitors;          // RandR monitors and point lookup
+    std::unique_ptr<StackingOrder> stack;              // Stacking order of the root window's children
+    std::unique_ptr<WorkspaceManager> workspaces;      // Tiles the managed windows per workspace
+    std::unique_ptr<EwmhPublisher> ewmh;               // EWMH state on the root window
+    std::shared_ptr<const Config> config;              // Bindings, colours and rules; replaced whole
+    std::unique_ptr<ConfigWatcher> configWatcher;      // Reloads the configuration when it changes
+    std::unique_ptr<WindowSwitcher> switcher;          // Alt+Tab in focus order
+    std::unique_ptr<PointerDrag> drag;                 // Alt+drag move and resize
     std::unique_ptr<Launcher> launcher;                // Application launcher
+    std::unique_ptr<Spawner> spawner;                  // Launches external commands
+    std::unique_ptr<ChildTracker> childTracker;        // Reaps launched processes
+    std::unique_ptr<StatePublisher> state;             // Snapshots for queries off the main thread
+    std::unique_ptr<IpcCommands> ipcCommands;          // Runs control socket requests
+    std::unique_ptr<IpcServer> ipc;                    // Control socket for scripts and doowmc
+    std::unique_ptr<IpcEvents> ipcEvents;              // Pushes state changes to subscribers
 };
 
 } // namespace X